@@ -0,0 +1,57 @@
+#include "alloc_counter.h"
+
+#include <new>
+#include <atomic>
+#include <cstdlib>
+
+namespace
+{
+    std::atomic<uint64_t> alloc_count{0};
+    std::atomic<uint64_t> alloc_bytes{0};
+
+    void *counted_alloc(std::size_t size, std::size_t alignment = 0)
+    {
+        alloc_count.fetch_add(1, std::memory_order_relaxed);
+        alloc_bytes.fetch_add(size, std::memory_order_relaxed);
+        size = size ? size : 1;
+        if (alignment > alignof(std::max_align_t))
+        {
+            // aligned_alloc要求size是alignment的整数倍
+            return std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+        }
+        return std::malloc(size);
+    }
+
+    void *checked(void *ptr)
+    {
+        if (!ptr)
+        {
+            throw std::bad_alloc();
+        }
+        return ptr;
+    }
+}
+
+namespace dRPC::bench
+{
+    AllocStats alloc_stats()
+    {
+        return {alloc_count.load(std::memory_order_relaxed), alloc_bytes.load(std::memory_order_relaxed)};
+    }
+}
+
+void *operator new(std::size_t size) { return checked(counted_alloc(size)); }
+void *operator new[](std::size_t size) { return checked(counted_alloc(size)); }
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept { return counted_alloc(size); }
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept { return counted_alloc(size); }
+void *operator new(std::size_t size, std::align_val_t align) { return checked(counted_alloc(size, static_cast<std::size_t>(align))); }
+void *operator new[](std::size_t size, std::align_val_t align) { return checked(counted_alloc(size, static_cast<std::size_t>(align))); }
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete[](void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <benchmark/benchmark.h>
+
+namespace dRPC::bench
+{
+    // 进程内operator new的累计次数和字节数。替换的全局operator new定义在alloc_counter.cpp中，
+    // 只链接进压测程序
+    struct AllocStats
+    {
+        uint64_t count = 0;
+        uint64_t bytes = 0;
+    };
+
+    AllocStats alloc_stats();
+
+    // 统计作用域内(通常是整个for (auto _ : state)循环)的分配，
+    // 析构时写入allocs/op和alloc_bytes/op计数器
+    class AllocCounter
+    {
+    public:
+        explicit AllocCounter(benchmark::State &state) : state_(state), start_(alloc_stats()) {}
+        ~AllocCounter()
+        {
+            AllocStats end = alloc_stats();
+            state_.counters["allocs/op"] = benchmark::Counter(static_cast<double>(end.count - start_.count),
+                                                              benchmark::Counter::kAvgIterations);
+            state_.counters["alloc_bytes/op"] = benchmark::Counter(static_cast<double>(end.bytes - start_.bytes),
+                                                                   benchmark::Counter::kAvgIterations);
+        }
+
+        AllocCounter(const AllocCounter &) = delete;
+        AllocCounter &operator=(const AllocCounter &) = delete;
+
+    private:
+        benchmark::State &state_;
+        AllocStats start_;
+    };
+}
@@ -0,0 +1,311 @@
+// 任务队列对比：无界分块的MPMCQueue与有界环形的BoundedMPMCQueue，在生产者/消费者数的矩阵上
+// 测吞吐和入队到出队的延迟分位数(纳秒)，结果以JSON输出。有界队列满时生产者yield后重试，
+// 队列空时消费者yield后重试。单组超过--timeout仍未结束时报告丢失的元素数，线程卡在队列内部时标记为hung
+//
+//   queue_bench --producers=1,2,4,8,16,32 --consumers=1,2,4,8,16,32 --items=200000
+//   queue_bench --queue=bounded --capacity=256 --producers=8 --consumers=1 --output=queue.json
+
+#include <cmath>
+#include <atomic>
+#include <memory>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdio>
+#include <format>
+#include <utility>
+#include <algorithm>
+
+#include "util/mpmc_queue.h"
+#include "util/bounded_mpmc_queue.h"
+
+using dRPC::util::BoundedMPMCQueue;
+using dRPC::util::MPMCQueue;
+
+namespace
+{
+    struct BenchOptions
+    {
+        std::vector<int> producers{1, 2, 4, 8, 16, 32};
+        std::vector<int> consumers{1, 2, 4, 8, 16, 32};
+        size_t items = 200000;     // 每组的总元素数，均分给生产者
+        size_t capacity = 1024;    // 有界队列容量
+        std::string queue = "all"; // chunked、bounded或all
+        double timeout_s = 30;     // 单组超时，超时后停止并报告未取出的元素数
+        std::string output;        // JSON结果文件，为空时只输出到stdout
+    };
+
+    struct RunResult
+    {
+        double seconds = 0;
+        uint64_t full_retries = 0; // 生产者遇到队列满的次数
+        size_t consumed = 0;
+        size_t lost = 0;           // 超时时仍未取出的元素数
+        bool hung = false;         // 超时后仍有线程阻塞在push/pop中
+        std::vector<int64_t> latencies;
+    };
+
+    int64_t now_ns()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    // 一组测试的共享状态。线程超时后仍阻塞时被分离，状态随之泄漏，不能放在栈上
+    template <typename Queue>
+    struct RunState
+    {
+        Queue queue;
+        std::atomic<bool> go{false};
+        std::atomic<size_t> consumed{0};
+        std::atomic<uint64_t> full_retries{0};
+        std::atomic<int> exited{0};
+        std::vector<std::vector<int64_t>> latencies;
+        int64_t deadline_ns = 0;
+
+        template <typename... Args>
+        explicit RunState(Args &&...args) : queue(std::forward<Args>(args)...) {}
+
+        void wait_go()
+        {
+            while (!go.load(std::memory_order_acquire))
+            {
+                std::this_thread::yield();
+            }
+        }
+    };
+
+    // 元素为入队时间，消费者据此计算在队列中停留的时间
+    template <typename Queue, typename... Args>
+    RunResult run(int producers, int consumers, size_t items, double timeout_s, Args &&...args)
+    {
+        size_t per_producer = items / producers;
+        size_t total = per_producer * producers;
+        auto state = std::make_shared<RunState<Queue>>(std::forward<Args>(args)...);
+        state->latencies.resize(consumers);
+        std::vector<std::thread> threads;
+
+        for (int i = 0; i < producers; ++i)
+        {
+            threads.emplace_back([state, per_producer]()
+                                 {
+                                     state->wait_go();
+                                     uint64_t retries = 0;
+                                     for (size_t n = 0; n < per_producer; ++n)
+                                     {
+                                         bool pushed = true;
+                                         while (!state->queue.push(now_ns()))
+                                         {
+                                             ++retries;
+                                             if (now_ns() > state->deadline_ns)
+                                             {
+                                                 pushed = false;
+                                                 break;
+                                             }
+                                             std::this_thread::yield();
+                                         }
+                                         if (!pushed)
+                                         {
+                                             break;
+                                         }
+                                     }
+                                     state->full_retries.fetch_add(retries);
+                                     state->exited.fetch_add(1, std::memory_order_release); });
+        }
+        for (int i = 0; i < consumers; ++i)
+        {
+            state->latencies[i].reserve(total / consumers + 1);
+            threads.emplace_back([state, total, i]()
+                                 {
+                                     state->wait_go();
+                                     auto &latencies = state->latencies[i];
+                                     int64_t enqueue_ns;
+                                     while (state->consumed.load(std::memory_order_relaxed) < total)
+                                     {
+                                         if (state->queue.pop(enqueue_ns))
+                                         {
+                                             latencies.push_back(now_ns() - enqueue_ns);
+                                             state->consumed.fetch_add(1, std::memory_order_relaxed);
+                                         }
+                                         else if (now_ns() > state->deadline_ns)
+                                         {
+                                             break;
+                                         }
+                                         else
+                                         {
+                                             std::this_thread::yield();
+                                         }
+                                     }
+                                     state->exited.fetch_add(1, std::memory_order_release); });
+        }
+
+        int64_t start_ns = now_ns();
+        state->deadline_ns = start_ns + static_cast<int64_t>(timeout_s * 1e9);
+        state->go.store(true, std::memory_order_release);
+
+        // 超时后再等1秒，仍未退出的线程卡在队列内部(如MPMCQueue::pop等待一个不会被写入的槽位)
+        int64_t give_up_ns = state->deadline_ns + 1000000000;
+        int thread_num = producers + consumers;
+        while (state->exited.load(std::memory_order_acquire) < thread_num && now_ns() < give_up_ns)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        RunResult result;
+        result.seconds = (now_ns() - start_ns) / 1e9;
+        result.hung = state->exited.load(std::memory_order_acquire) < thread_num;
+        for (auto &thread : threads)
+        {
+            if (result.hung)
+            {
+                thread.detach();
+            }
+            else
+            {
+                thread.join();
+            }
+        }
+        result.full_retries = state->full_retries.load();
+        result.consumed = state->consumed.load();
+        result.lost = total - result.consumed;
+        // 卡住的消费者仍可能写入延迟数组，此时不汇总
+        if (!result.hung)
+        {
+            for (auto &local : state->latencies)
+            {
+                result.latencies.insert(result.latencies.end(), local.begin(), local.end());
+            }
+            std::sort(result.latencies.begin(), result.latencies.end());
+        }
+        return result;
+    }
+
+    int64_t percentile(const std::vector<int64_t> &sorted, double p)
+    {
+        if (sorted.empty())
+        {
+            return 0;
+        }
+        size_t rank = static_cast<size_t>(std::ceil(p * sorted.size()));
+        return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+    }
+
+    std::string format_result(const std::string &queue, int producers, int consumers, const RunResult &r)
+    {
+        const auto &l = r.latencies;
+        return std::format("    {{\"queue\": \"{}\", \"producers\": {}, \"consumers\": {}, \"items\": {}, \"ops_per_s\": {:.0f}, "
+                           "\"full_retries\": {}, \"lost\": {}, \"hung\": {}, \"latency_ns\": {{\"p50\": {}, \"p90\": {}, \"p99\": {}, \"p999\": {}, \"max\": {}}}}}",
+                           queue, producers, consumers, r.consumed, r.consumed / r.seconds, r.full_retries, r.lost, r.hung,
+                           percentile(l, 0.5), percentile(l, 0.9), percentile(l, 0.99), percentile(l, 0.999),
+                           l.empty() ? 0 : l.back());
+    }
+
+    std::vector<int> parse_list(const std::string &value)
+    {
+        std::vector<int> list;
+        size_t start = 0;
+        while (start <= value.size())
+        {
+            size_t comma = value.find(',', start);
+            if (comma == std::string::npos)
+            {
+                comma = value.size();
+            }
+            list.push_back(std::max(std::stoi(value.substr(start, comma - start)), 1));
+            start = comma + 1;
+        }
+        return list;
+    }
+
+    bool parse_args(int argc, char **argv, BenchOptions &o)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            size_t eq = arg.find('=');
+            if (arg.rfind("--", 0) != 0 || eq == std::string::npos)
+            {
+                return false;
+            }
+            std::string key = arg.substr(2, eq - 2);
+            std::string value = arg.substr(eq + 1);
+            if (key == "producers")
+                o.producers = parse_list(value);
+            else if (key == "consumers")
+                o.consumers = parse_list(value);
+            else if (key == "items")
+                o.items = std::stoul(value);
+            else if (key == "capacity")
+                o.capacity = std::stoul(value);
+            else if (key == "queue")
+                o.queue = value;
+            else if (key == "timeout")
+                o.timeout_s = std::stod(value);
+            else if (key == "output")
+                o.output = value;
+            else
+                return false;
+        }
+        return o.items > 0 && (o.queue == "all" || o.queue == "chunked" || o.queue == "bounded");
+    }
+}
+
+int main(int argc, char **argv)
+{
+    BenchOptions o;
+    if (!parse_args(argc, argv, o))
+    {
+        fprintf(stderr, "usage: %s [--producers=1,2,...] [--consumers=1,2,...] [--items=N] [--capacity=N]\n"
+                        "          [--queue=chunked|bounded|all] [--timeout=S] [--output=FILE]\n",
+                argv[0]);
+        return 1;
+    }
+
+    std::vector<std::string> results;
+    for (int producers : o.producers)
+    {
+        for (int consumers : o.consumers)
+        {
+            // 每组使用新队列，避免上一组残留的块或位置影响结果
+            std::vector<std::pair<std::string, RunResult>> runs;
+            if (o.queue != "bounded")
+            {
+                runs.emplace_back("chunked", run<MPMCQueue<int64_t>>(producers, consumers, o.items, o.timeout_s));
+            }
+            if (o.queue != "chunked")
+            {
+                runs.emplace_back("bounded", run<BoundedMPMCQueue<int64_t>>(producers, consumers, o.items, o.timeout_s, o.capacity));
+            }
+            for (auto &[name, r] : runs)
+            {
+                results.push_back(format_result(name, producers, consumers, r));
+                fprintf(stderr, "%s p=%-2d c=%-2d %12.0f ops/s p99=%ldns lost=%zu%s\n", name.c_str(), producers, consumers,
+                        r.consumed / r.seconds, percentile(r.latencies, 0.99), r.lost, r.hung ? " HUNG" : "");
+            }
+        }
+    }
+
+    std::string out = std::format("{{\n  \"config\": {{\"items\": {}, \"capacity\": {}, \"hardware_threads\": {}}},\n  \"results\": [\n",
+                                  o.items, o.capacity, std::thread::hardware_concurrency());
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        out += results[i];
+        out += i + 1 < results.size() ? ",\n" : "\n";
+    }
+    out += "  ]\n}\n";
+    fputs(out.c_str(), stdout);
+    if (!o.output.empty())
+    {
+        FILE *file = fopen(o.output.c_str(), "w");
+        if (!file)
+        {
+            fprintf(stderr, "failed to open %s\n", o.output.c_str());
+            return 1;
+        }
+        fputs(out.c_str(), file);
+        fclose(file);
+    }
+    return 0;
+}
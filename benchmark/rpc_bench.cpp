@@ -0,0 +1,383 @@
+// 端到端RPC压测：在进程内启动RpcServer(或连接--server指定的服务端)，通过回环发送Echo请求，
+// 统计QPS和延迟分位数，结果以JSON输出。
+//
+//   闭环：每个连接保持--depth个并发请求，收到响应后立即发送下一个
+//     rpc_bench --payload=64 --connections=4 --depth=16 --server_executors=2 --client_executors=2
+//   开环：按--rate的总速率定时发送，不等待响应。延迟从计划发送时间算起，
+//   服务端或客户端停顿期间本应发出的请求也计入延迟，失败和超时的请求按耗时计入(修正coordinated omission)
+//     rpc_bench --rate=50000 --connections=8 --duration=30 --output=result.json
+
+#include <cmath>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <numeric>
+#include <algorithm>
+#include <unistd.h>
+
+#include "util/common.h"
+#include "util/clock.h"
+#include "scheduler/scheduler.h"
+#include "scheduler/task.h"
+#include "server/rpc_server.h"
+#include "client/client_channel.h"
+#include "example/echo.drpc.h"
+
+using namespace dRPC;
+
+namespace
+{
+    struct BenchOptions
+    {
+        std::string server;        // ip:port，为空时在进程内启动服务端
+        int port = 9901;           // 进程内服务端的端口
+        size_t payload = 64;       // 请求消息字节数，服务端原样返回
+        int connections = 4;
+        int depth = 16;            // 闭环模式下每个连接的并发请求数
+        int server_executors = 1;
+        int client_executors = 1;
+        size_t task_queue = 0;     // executor任务队列容量，0为无界
+        double rate = 0;           // 开环模式的总QPS，0表示闭环
+        double duration_s = 10;    // 统计时长
+        double warmup_s = 2;       // 统计开始前的预热时长，期间的请求不计入结果
+        int timeout_ms = 10000;
+        std::string output;        // JSON结果文件，为空时只输出到stdout
+    };
+
+    // 不打日志的Echo，只测RPC框架本身的开销
+    class BenchEchoService : public EchoServiceBase<BenchEchoService>
+    {
+    public:
+        void Echo(RpcController &, const EchoRequest &request, EchoResponse &response, google::protobuf::Closure *done)
+        {
+            response.set_message(request.message());
+            done->Run();
+        }
+        void Echo1(RpcController &controller, const EchoRequest &request, EchoResponse &response, google::protobuf::Closure *done)
+        {
+            Echo(controller, request, response, done);
+        }
+    };
+
+    struct Bench;
+
+    // 一条连接及其统计，统计只在连接所属的executor线程上写入
+    struct Worker
+    {
+        Bench *bench = nullptr;
+        std::unique_ptr<ClientChannel> channel;
+        EchoRequest request;
+        std::vector<int64_t> latencies;
+        uint64_t errors = 0;
+
+        void record(int64_t start_us, int64_t end_us, bool ok);
+    };
+
+    struct Bench
+    {
+        BenchOptions options;
+        std::vector<std::unique_ptr<Worker>> workers;
+        int64_t measure_start_us = 0;
+        int64_t measure_end_us = 0;
+        std::atomic<bool> stopping{false};
+        std::atomic<int64_t> outstanding{0}; // 未结束的闭环协程或开环请求
+        std::atomic<int> connect_failures{0};
+    };
+
+    void Worker::record(int64_t start_us, int64_t end_us, bool ok)
+    {
+        // 按请求的(计划)发送时间归入统计窗口
+        if (start_us < bench->measure_start_us || start_us >= bench->measure_end_us)
+        {
+            return;
+        }
+        if (!ok)
+        {
+            ++errors;
+        }
+        // 开环模式下失败和超时的请求也按耗时计入延迟，否则最严重的停顿会从高分位中消失
+        if (ok || bench->options.rate > 0)
+        {
+            latencies.push_back(end_us - start_us);
+        }
+    }
+
+    Task closed_loop(Worker *worker)
+    {
+        Bench *bench = worker->bench;
+        int err = co_await worker->channel->wait_connected();
+        if (err != 0)
+        {
+            bench->connect_failures.fetch_add(1);
+            bench->outstanding.fetch_sub(1);
+            co_return;
+        }
+        EchoServiceClient client(worker->channel.get());
+        while (!bench->stopping.load(std::memory_order_relaxed))
+        {
+            int64_t start_us = util::now_us();
+            auto result = co_await client.Echo(worker->request);
+            worker->record(start_us, util::now_us(), result.ok());
+        }
+        bench->outstanding.fetch_sub(1);
+    }
+
+    Task open_call(Worker *worker, int64_t intended_us)
+    {
+        EchoServiceClient client(worker->channel.get());
+        auto result = co_await client.Echo(worker->request);
+        worker->record(intended_us, util::now_us(), result.ok());
+        worker->bench->outstanding.fetch_sub(1);
+    }
+
+    Task wait_connected(Worker *worker, std::atomic<int> *pending)
+    {
+        int err = co_await worker->channel->wait_connected();
+        if (err != 0)
+        {
+            worker->bench->connect_failures.fetch_add(1);
+        }
+        pending->fetch_sub(1);
+    }
+
+    // 第k个请求的计划发送时间为start + k/rate，落后于计划时立即补发，不跳过
+    void pace(Bench &bench, int64_t start_us)
+    {
+        double interval_us = 1e6 / bench.options.rate;
+        size_t worker_num = bench.workers.size();
+        for (uint64_t k = 0;; ++k)
+        {
+            int64_t intended_us = start_us + static_cast<int64_t>(k * interval_us);
+            if (intended_us >= bench.measure_end_us)
+            {
+                break;
+            }
+            int64_t wait_us = intended_us - util::now_us();
+            if (wait_us > 0)
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds(wait_us));
+            }
+            Worker *worker = bench.workers[k % worker_num].get();
+            bench.outstanding.fetch_add(1, std::memory_order_relaxed);
+            worker->channel->executor()->spawn([worker, intended_us]()
+                                               { open_call(worker, intended_us); });
+        }
+    }
+
+    int64_t percentile(const std::vector<int64_t> &sorted, double p)
+    {
+        if (sorted.empty())
+        {
+            return 0;
+        }
+        size_t rank = static_cast<size_t>(std::ceil(p * sorted.size()));
+        return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+    }
+
+    std::string report(const Bench &bench, int64_t drain_us)
+    {
+        std::vector<int64_t> latencies;
+        uint64_t errors = 0;
+        for (auto &worker : bench.workers)
+        {
+            latencies.insert(latencies.end(), worker->latencies.begin(), worker->latencies.end());
+            errors += worker->errors;
+        }
+        std::sort(latencies.begin(), latencies.end());
+        const BenchOptions &o = bench.options;
+        // 开环模式的延迟样本包含失败的请求
+        size_t requests = o.rate > 0 ? latencies.size() - errors : latencies.size();
+        double mean = latencies.empty() ? 0 : static_cast<double>(std::accumulate(latencies.begin(), latencies.end(), int64_t{0})) / latencies.size();
+
+        std::string out = "{\n  \"config\": {";
+        out += std::format("\"mode\": \"{}\", \"server\": \"{}\", \"payload\": {}, \"connections\": {}, \"depth\": {}, "
+                           "\"server_executors\": {}, \"client_executors\": {}, \"task_queue\": {}, \"rate\": {}, \"duration_s\": {}, \"warmup_s\": {}",
+                           o.rate > 0 ? "open" : "closed", o.server.empty() ? "in-process" : o.server, o.payload,
+                           o.connections, o.depth, o.server_executors, o.client_executors, o.task_queue, o.rate, o.duration_s, o.warmup_s);
+        out += "},\n";
+        out += std::format("  \"requests\": {},\n  \"errors\": {},\n  \"qps\": {:.1f},\n  \"drain_ms\": {},\n",
+                           requests, errors, requests / o.duration_s, drain_us / 1000);
+        out += std::format("  \"latency_us\": {{\"mean\": {:.1f}, \"p50\": {}, \"p90\": {}, \"p99\": {}, \"p999\": {}, \"p9999\": {}, \"max\": {}}}\n}}\n",
+                           mean, percentile(latencies, 0.5), percentile(latencies, 0.9), percentile(latencies, 0.99),
+                           percentile(latencies, 0.999), percentile(latencies, 0.9999), latencies.empty() ? 0 : latencies.back());
+        return out;
+    }
+
+    bool parse_args(int argc, char **argv, BenchOptions &o)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            size_t eq = arg.find('=');
+            if (arg.rfind("--", 0) != 0 || eq == std::string::npos)
+            {
+                return false;
+            }
+            std::string key = arg.substr(2, eq - 2);
+            std::string value = arg.substr(eq + 1);
+            if (key == "server")
+                o.server = value;
+            else if (key == "port")
+                o.port = std::stoi(value);
+            else if (key == "payload")
+                o.payload = std::stoul(value);
+            else if (key == "connections")
+                o.connections = std::max(std::stoi(value), 1);
+            else if (key == "depth")
+                o.depth = std::max(std::stoi(value), 1);
+            else if (key == "server_executors")
+                o.server_executors = std::max(std::stoi(value), 1);
+            else if (key == "client_executors")
+                o.client_executors = std::max(std::stoi(value), 1);
+            else if (key == "task_queue")
+                o.task_queue = std::stoul(value);
+            else if (key == "rate")
+                o.rate = std::stod(value);
+            else if (key == "duration")
+                o.duration_s = std::stod(value);
+            else if (key == "warmup")
+                o.warmup_s = std::stod(value);
+            else if (key == "timeout_ms")
+                o.timeout_ms = std::stoi(value);
+            else if (key == "output")
+                o.output = value;
+            else
+                return false;
+        }
+        return o.duration_s > 0;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Bench bench;
+    BenchOptions &o = bench.options;
+    if (!parse_args(argc, argv, o))
+    {
+        fprintf(stderr, "usage: %s [--server=ip:port] [--port=N] [--payload=BYTES] [--connections=N] [--depth=N]\n"
+                        "          [--server_executors=N] [--client_executors=N] [--task_queue=N] [--rate=QPS]\n"
+                        "          [--duration=S] [--warmup=S] [--timeout_ms=N] [--output=FILE]\n",
+                argv[0]);
+        return 1;
+    }
+
+    // stdout只输出JSON结果
+    util::Logger::instance().set_output(stderr);
+
+    std::string ip = "127.0.0.1";
+    int port = o.port;
+    if (o.server.empty())
+    {
+        // 构造时已开始监听，start在后台线程中接受连接
+        RpcServerOptions server_options(o.port);
+        server_options.executor_num_ = o.server_executors;
+        server_options.executor_.task_queue_capacity_ = o.task_queue;
+        auto server = new RpcServer(server_options);
+        if (!server->register_service(new BenchEchoService))
+        {
+            return 1;
+        }
+        std::thread([server]()
+                    { server->start(); })
+            .detach();
+    }
+    else
+    {
+        size_t colon = o.server.rfind(':');
+        ip = o.server.substr(0, colon);
+        port = std::stoi(o.server.substr(colon + 1));
+    }
+
+    ExecutorOptions executor_options;
+    executor_options.task_queue_capacity_ = o.task_queue;
+    Scheduler scheduler(100, o.client_executors, executor_options);
+    ClientOptions client_options;
+    client_options.ip_ = ip;
+    client_options.port_ = port;
+    client_options.timeout_ms_ = o.timeout_ms;
+    std::string payload(o.payload, 'x');
+    for (int i = 0; i < o.connections; ++i)
+    {
+        auto worker = std::make_unique<Worker>();
+        worker->bench = &bench;
+        worker->channel = std::make_unique<ClientChannel>(client_options, scheduler.alloc_executor());
+        worker->request.set_message(payload);
+        bench.workers.push_back(std::move(worker));
+    }
+
+    // 连接全部建立后再开始计时
+    std::atomic<int> pending{o.connections};
+    for (auto &worker : bench.workers)
+    {
+        Worker *w = worker.get();
+        w->channel->executor()->spawn([w, &pending]()
+                                      { wait_connected(w, &pending); });
+    }
+    while (pending.load() > 0)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    if (bench.connect_failures.load() > 0)
+    {
+        fprintf(stderr, "failed to connect to %s:%d\n", ip.c_str(), port);
+        return 1;
+    }
+
+    int64_t start_us = util::now_us();
+    bench.measure_start_us = start_us + static_cast<int64_t>(o.warmup_s * 1e6);
+    bench.measure_end_us = bench.measure_start_us + static_cast<int64_t>(o.duration_s * 1e6);
+
+    if (o.rate > 0)
+    {
+        pace(bench, start_us);
+    }
+    else
+    {
+        for (auto &worker : bench.workers)
+        {
+            for (int d = 0; d < o.depth; ++d)
+            {
+                Worker *w = worker.get();
+                bench.outstanding.fetch_add(1);
+                w->channel->executor()->spawn([w]()
+                                              { closed_loop(w); });
+            }
+        }
+        while (util::now_us() < bench.measure_end_us)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+
+    // 等待窗口内发出的请求全部完成，超时的请求以失败计入
+    bench.stopping.store(true);
+    int64_t drain_start_us = util::now_us();
+    while (bench.outstanding.load() > 0 && util::now_us() - drain_start_us < (o.timeout_ms + 1000) * 1000LL)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    int64_t drain_us = util::now_us() - drain_start_us;
+    scheduler.stop();
+
+    std::string result = report(bench, drain_us);
+    fputs(result.c_str(), stdout);
+    if (!o.output.empty())
+    {
+        FILE *file = fopen(o.output.c_str(), "w");
+        if (!file)
+        {
+            fprintf(stderr, "failed to open %s\n", o.output.c_str());
+            return 1;
+        }
+        fputs(result.c_str(), file);
+        fclose(file);
+    }
+    fflush(stdout);
+    // RpcServer没有停止接口，直接退出
+    _exit(0);
+}
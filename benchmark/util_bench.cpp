@@ -0,0 +1,299 @@
+// util层微基准：ChainedBuffer的读写和iovec操作、模拟socket收发的commit_send/commit_resv模式，
+// 以及经InputStream/OutputStream的protobuf序列化和解析。输出ns/op、bytes/s和每次操作的分配次数
+//
+//   util_bench --benchmark_filter=Buffer
+//   util_bench --benchmark_format=json --benchmark_out=util_bench.json
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <sys/uio.h>
+#include <benchmark/benchmark.h>
+#include <google/protobuf/struct.pb.h>
+
+#include "util/chained_buffer.h"
+#include "util/stream.h"
+#include "proto/message.pb.h"
+#include "example/echo.pb.h"
+#include "alloc_counter.h"
+
+using dRPC::bench::AllocCounter;
+using dRPC::util::ChainedBuffer;
+
+namespace
+{
+    // 缓冲超过该大小时清空，clear保留空闲块，稳定后写入不再分配
+    constexpr size_t MAX_BUFFERED = 1 << 20;
+
+    template <size_t BlockSize>
+    void BM_BufferWrite(benchmark::State &state)
+    {
+        size_t chunk = state.range(0);
+        std::string data(chunk, 'x');
+        ChainedBuffer<BlockSize> buffer;
+        {
+            AllocCounter allocs(state);
+            for (auto _ : state)
+            {
+                buffer.write(data.data(), chunk);
+                if (buffer.size() >= MAX_BUFFERED)
+                {
+                    buffer.clear();
+                }
+            }
+        }
+        state.SetBytesProcessed(state.iterations() * chunk);
+    }
+
+    template <size_t BlockSize>
+    void BM_BufferWriteRead(benchmark::State &state)
+    {
+        size_t chunk = state.range(0);
+        std::string data(chunk, 'x');
+        std::string out(chunk, '\0');
+        ChainedBuffer<BlockSize> buffer;
+        {
+            AllocCounter allocs(state);
+            for (auto _ : state)
+            {
+                buffer.write(data.data(), chunk);
+                buffer.read(out.data(), chunk);
+                benchmark::DoNotOptimize(out.data());
+            }
+        }
+        state.SetBytesProcessed(state.iterations() * chunk);
+    }
+
+    // 发送路径：写入一批帧，get_iovecs后按writev全部写出的情况commit_send，对应Connection::async_write
+    template <size_t BlockSize>
+    void BM_BufferSendPattern(benchmark::State &state)
+    {
+        constexpr int FRAMES_PER_BATCH = 16;
+        size_t frame = state.range(0);
+        std::string data(frame, 'x');
+        ChainedBuffer<BlockSize> buffer;
+        iovec iovs[64];
+        {
+            AllocCounter allocs(state);
+            for (auto _ : state)
+            {
+                for (int i = 0; i < FRAMES_PER_BATCH; ++i)
+                {
+                    buffer.write(data.data(), frame);
+                }
+                size_t count = buffer.get_iovecs(iovs, 64);
+                benchmark::DoNotOptimize(count);
+                buffer.commit_send(buffer.size());
+            }
+        }
+        state.SetBytesProcessed(state.iterations() * frame * FRAMES_PER_BATCH);
+        state.SetItemsProcessed(state.iterations() * FRAMES_PER_BATCH);
+    }
+
+    // 接收路径：在write_view上就地填充recv_size字节(代替recv)并commit_resv，再按帧读出，
+    // 对应Connection::async_read和recv_fn
+    template <size_t BlockSize>
+    void BM_BufferRecvPattern(benchmark::State &state)
+    {
+        constexpr size_t FRAME = 256;
+        size_t recv_size = state.range(0);
+        std::string data(recv_size, 'x');
+        char out[FRAME];
+        ChainedBuffer<BlockSize> buffer;
+        {
+            AllocCounter allocs(state);
+            for (auto _ : state)
+            {
+                size_t remaining = recv_size;
+                while (remaining > 0)
+                {
+                    auto [ptr, len] = buffer.write_view();
+                    size_t n = std::min(len, remaining);
+                    std::memcpy(ptr, data.data(), n);
+                    buffer.commit_resv(n);
+                    remaining -= n;
+                }
+                while (buffer.size() >= FRAME)
+                {
+                    buffer.read(out, FRAME);
+                }
+                benchmark::DoNotOptimize(out);
+            }
+        }
+        state.SetBytesProcessed(state.iterations() * recv_size);
+    }
+
+#define BUFFER_BENCHMARK(func, lo, hi)                                            \
+    BENCHMARK_TEMPLATE(func, 1024)->RangeMultiplier(8)->Range(lo, hi);            \
+    BENCHMARK_TEMPLATE(func, 4096)->RangeMultiplier(8)->Range(lo, hi);            \
+    BENCHMARK_TEMPLATE(func, 16384)->RangeMultiplier(8)->Range(lo, hi)
+
+    BUFFER_BENCHMARK(BM_BufferWrite, 64, 32768);
+    BUFFER_BENCHMARK(BM_BufferWriteRead, 64, 32768);
+    BUFFER_BENCHMARK(BM_BufferSendPattern, 64, 4096);
+    BUFFER_BENCHMARK(BM_BufferRecvPattern, 512, 65536);
+
+    // 不同形状的消息：帧首部(少量标量和短字符串)、单个大字符串、大量嵌套小消息
+    enum Shape
+    {
+        HEADER,
+        ECHO_64,
+        ECHO_4K,
+        ECHO_64K,
+        LIST_16,
+        LIST_1K,
+    };
+
+    std::unique_ptr<google::protobuf::Message> make_message(int shape, const char **name)
+    {
+        switch (shape)
+        {
+        case HEADER:
+        {
+            *name = "header";
+            auto header = std::make_unique<dRPC::proto::Header>();
+            header->set_magic(0x12345678);
+            header->set_version(1);
+            header->set_message_type(dRPC::proto::REQUEST);
+            header->set_request_id(123456789);
+            header->set_service_name("benchmark.EchoService");
+            header->set_method_name("Echo");
+            header->set_timeout_ms(500);
+            return header;
+        }
+        case ECHO_64:
+        case ECHO_4K:
+        case ECHO_64K:
+        {
+            size_t size = shape == ECHO_64 ? 64 : shape == ECHO_4K ? 4096 : 65536;
+            *name = shape == ECHO_64 ? "echo/64" : shape == ECHO_4K ? "echo/4k" : "echo/64k";
+            auto echo = std::make_unique<EchoRequest>();
+            echo->set_message(std::string(size, 'x'));
+            return echo;
+        }
+        default:
+        {
+            int count = shape == LIST_16 ? 16 : 1024;
+            *name = shape == LIST_16 ? "list/16" : "list/1k";
+            auto list = std::make_unique<google::protobuf::ListValue>();
+            for (int i = 0; i < count; ++i)
+            {
+                auto value = list->add_values();
+                if (i % 2)
+                {
+                    value->set_number_value(i * 1.5);
+                }
+                else
+                {
+                    value->set_string_value("item" + std::to_string(i));
+                }
+            }
+            return list;
+        }
+        }
+    }
+
+    void shape_args(benchmark::internal::Benchmark *b)
+    {
+        for (int shape = HEADER; shape <= LIST_1K; ++shape)
+        {
+            b->Arg(shape);
+        }
+    }
+
+    // 序列化到OutputStream，写出后按发送完成丢弃
+    void BM_SerializeToStream(benchmark::State &state)
+    {
+        const char *name;
+        auto message = make_message(state.range(0), &name);
+        size_t size = message->ByteSizeLong();
+        ChainedBuffer<> buffer;
+        {
+            AllocCounter allocs(state);
+            for (auto _ : state)
+            {
+                dRPC::util::OutputStream output(&buffer);
+                message->SerializeToZeroCopyStream(&output);
+                buffer.commit_send(buffer.size());
+            }
+        }
+        state.SetLabel(name);
+        state.SetBytesProcessed(state.iterations() * size);
+    }
+
+    // 对照：序列化到连续内存
+    void BM_SerializeToArray(benchmark::State &state)
+    {
+        const char *name;
+        auto message = make_message(state.range(0), &name);
+        size_t size = message->ByteSizeLong();
+        std::string out(size, '\0');
+        {
+            AllocCounter allocs(state);
+            for (auto _ : state)
+            {
+                message->SerializeToArray(out.data(), static_cast<int>(size));
+                benchmark::DoNotOptimize(out.data());
+            }
+        }
+        state.SetLabel(name);
+        state.SetBytesProcessed(state.iterations() * size);
+    }
+
+    // 把序列化后的字节写入接收缓冲，再按长度限制从InputStream解析，与recv_fn相同
+    void BM_ParseFromStream(benchmark::State &state)
+    {
+        const char *name;
+        auto message = make_message(state.range(0), &name);
+        std::string bytes = message->SerializeAsString();
+        std::unique_ptr<google::protobuf::Message> parsed(message->New());
+        ChainedBuffer<> buffer;
+        {
+            AllocCounter allocs(state);
+            for (auto _ : state)
+            {
+                buffer.write(bytes.data(), bytes.size());
+                dRPC::util::InputStream input(&buffer);
+                input.push_limit(static_cast<int>(bytes.size()));
+                bool ok = parsed->ParseFromZeroCopyStream(&input);
+                input.pop_limit();
+                if (!ok || !buffer.empty())
+                {
+                    state.SkipWithError("parse failed");
+                    break;
+                }
+            }
+        }
+        state.SetLabel(name);
+        state.SetBytesProcessed(state.iterations() * bytes.size());
+    }
+
+    // 对照：从连续内存解析
+    void BM_ParseFromArray(benchmark::State &state)
+    {
+        const char *name;
+        auto message = make_message(state.range(0), &name);
+        std::string bytes = message->SerializeAsString();
+        std::unique_ptr<google::protobuf::Message> parsed(message->New());
+        {
+            AllocCounter allocs(state);
+            for (auto _ : state)
+            {
+                if (!parsed->ParseFromArray(bytes.data(), static_cast<int>(bytes.size())))
+                {
+                    state.SkipWithError("parse failed");
+                    break;
+                }
+            }
+        }
+        state.SetLabel(name);
+        state.SetBytesProcessed(state.iterations() * bytes.size());
+    }
+
+    BENCHMARK(BM_SerializeToStream)->Apply(shape_args);
+    BENCHMARK(BM_SerializeToArray)->Apply(shape_args);
+    BENCHMARK(BM_ParseFromStream)->Apply(shape_args);
+    BENCHMARK(BM_ParseFromArray)->Apply(shape_args);
+}
+
+BENCHMARK_MAIN();
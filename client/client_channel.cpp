@@ -1,28 +1,56 @@
 #include "client_channel.h"
 
+#include <algorithm>
 #include <fcntl.h>
+#include <string.h>
 #include <netinet/tcp.h>
 
 #include "net/socket_utils.h"
 #include "proto/message.pb.h"
+#include "util/service.h"
+#include "util/clock.h"
+#include "client/retry_call.h"
+#include "client/hedged_call.h"
 
 namespace dRPC
 {
     ClientChannel::ClientChannel(const ClientOptions &options, dRPC::Executor *executor)
-        : executor_(executor)
+        : executor_(executor), timeout_ms_(options.timeout_ms_), connect_timeout_ms_(options.connect_timeout_ms_),
+          reconnect_initial_backoff_ms_(options.reconnect_initial_backoff_ms_),
+          reconnect_max_backoff_ms_(options.reconnect_max_backoff_ms_),
+          reconnect_hold_ms_(options.reconnect_hold_ms_),
+          max_inflight_(options.max_inflight_), max_buffered_bytes_(options.max_buffered_bytes_),
+          wait_when_full_(options.wait_when_full_),
+          alive_(std::make_shared<bool>(true)), free_calls_(PENDING_CALL_POOL_SIZE)
     {
-        int sockfd = dRPC::net::SocketUtils::socket();
+        addr_.sin_family = AF_INET;
+        addr_.sin_port = htons(options.port_);
+        dRPC::net::SocketUtils::inet_pton(AF_INET, options.ip_.c_str(), &addr_.sin_addr);
+        peer_ip_ = net::SocketUtils::inet_ntoa(addr_.sin_addr);
 
-        struct sockaddr_in addr;
-        addr.sin_family = AF_INET;
-        addr.sin_port = htons(options.port_);
+        conn_ = std::make_unique<dRPC::net::Connection>(create_socket(), executor);
 
-        dRPC::net::SocketUtils::inet_pton(AF_INET, options.ip_.c_str(), &addr.sin_addr);
-        dRPC::net::SocketUtils::connect(sockfd, (const struct sockaddr *)&addr, sizeof(addr));
+        if (!options.retry_.methods_.empty())
+        {
+            retrier_ = std::make_unique<Retrier>(options.retry_);
+        }
 
-        fcntl(sockfd, F_SETFL, O_NONBLOCK | O_CLOEXEC);
+        for (int i = 0; i < PENDING_CALL_POOL_SIZE; ++i)
+        {
+            free_calls_.push(new PendingCall);
+        }
 
-        conn_ = std::make_unique<dRPC::net::Connection>(sockfd, executor);
+        // 连接在executor上异步建立，连接完成前的请求先缓存在发送缓冲区中
+        disconnected_us_ = util::now_us();
+        executor->spawn([this]()
+                        { connect_fn(); });
+    }
+
+    int ClientChannel::create_socket()
+    {
+        int sockfd = dRPC::net::SocketUtils::socket();
+
+        fcntl(sockfd, F_SETFL, O_NONBLOCK | O_CLOEXEC);
 
         // 设置发送缓冲区大小
         int sendbuf = 512 * 1024;
@@ -41,15 +69,200 @@ namespace dRPC
         linger.l_linger = 0;
         dRPC::net::SocketUtils::setsockopt(sockfd, SOL_SOCKET, SO_LINGER, &linger, sizeof(linger));
 
-        executor->spawn([this]()
-                        { send_fn(); });
-        executor->spawn([this]()
-                        { recv_fn(); });
+        return sockfd;
+    }
+
+    dRPC::Task ClientChannel::connect_fn()
+    {
+        connect_running_ = true;
+        int err = co_await conn_->async_connect((const struct sockaddr *)&addr_, sizeof(addr_), connect_timeout_ms_);
+        if (closing_.load(std::memory_order_relaxed))
+        {
+            err = err != 0 ? err : ECONNABORTED;
+            conn_->close();
+            fail_fast_ = true;
+            fail_unsent();
+        }
+        else if (err != 0)
+        {
+            error("connect to {}:{} failed: {}", net::SocketUtils::inet_ntoa(addr_.sin_addr), ntohs(addr_.sin_port), strerror(err));
+            conn_->close();
+            broken_.store(true, std::memory_order_relaxed);
+            // 断线超过保留时间，缓存的请求失败，之后的请求快速失败直到重连成功
+            if (util::now_us() - disconnected_us_ >= reconnect_hold_ms_ * 1000)
+            {
+                fail_fast_ = true;
+                fail_unsent();
+            }
+            schedule_reconnect();
+        }
+        else
+        {
+            reconnect_attempts_ = 0;
+            fail_fast_ = false;
+            broken_.store(false, std::memory_order_relaxed);
+            conn_->socket()->load_addr();
+            // recv_fn先注册读事件，send_fn在EAGAIN时才能修改为读写事件
+            recv_fn();
+            send_fn();
+        }
+
+        if (!connect_done_)
+        {
+            connect_done_ = true;
+            connect_error_ = err;
+            auto waiters = std::move(connect_waiters_);
+            for (auto handle : waiters)
+            {
+                handle.resume();
+            }
+        }
+
+        connect_running_ = false;
+        if (delete_after_connect_)
+        {
+            // 释放channel时连接协程仍挂起，协程返回后再析构
+            executor_->spawn([this]()
+                             { delete this; });
+        }
+    }
+
+    void ClientChannel::schedule_reconnect()
+    {
+        int64_t backoff = std::max(reconnect_initial_backoff_ms_, 1);
+        for (int i = 0; i < reconnect_attempts_ && backoff < reconnect_max_backoff_ms_; ++i)
+        {
+            backoff *= 2;
+        }
+        backoff = std::min<int64_t>(backoff, std::max(reconnect_max_backoff_ms_, 1));
+        // 随机抖动，避免大量channel同时重连
+        backoff = backoff / 2 + (util::now_us() ^ reinterpret_cast<uintptr_t>(this)) % (backoff - backoff / 2 + 1);
+        ++reconnect_attempts_;
+
+        // channel析构后定时器回调不再访问channel
+        std::weak_ptr<bool> alive = alive_;
+        executor_->run_after(backoff, [this, alive]()
+                             {
+                                 if (alive.expired() || closing_.load(std::memory_order_relaxed))
+                                 {
+                                     return;
+                                 }
+                                 conn_->reset(create_socket());
+                                 connect_fn(); });
+    }
+
+    void ClientChannel::on_disconnect()
+    {
+        // 已全部或部分写入socket的请求无法确定服务端是否处理，立即失败；
+        // 完全未发送的请求保留在发送缓冲区中，重连后重发
+        uint64_t sent = conn_->bytes_sent();
+        std::vector<int64_t> ids;
+        uint64_t replay_start = sent + conn_->to_write_bytes();
+        sessions_.for_each([&](int64_t id, Session &session)
+                           {
+                               if (session.frame_start < sent)
+                               {
+                                   ids.push_back(id);
+                               }
+                               else
+                               {
+                                   replay_start = std::min(replay_start, session.frame_start);
+                               } });
+        // 丢弃半个帧和已失效的CANCEL帧
+        conn_->discard_write(replay_start - sent);
+        buffered_bytes_.store(conn_->to_write_bytes(), std::memory_order_relaxed);
+        fail_sessions(ids, ErrorCode::UNAVAILABLE, "connection closed");
+
+        disconnected_us_ = util::now_us();
+        schedule_reconnect();
+    }
+
+    void ClientChannel::ConnectedAwaiter::await_suspend(std::coroutine_handle<> handle)
+    {
+        // 切换到channel所属executor上检查连接状态，保证connect_waiters_只在executor线程访问
+        auto channel = channel_;
+        channel->executor_->spawn([channel, handle]()
+                                  {
+                                      if (channel->connect_done_)
+                                      {
+                                          handle.resume();
+                                      }
+                                      else
+                                      {
+                                          channel->connect_waiters_.push_back(handle);
+                                      } });
+    }
+
+    ClientChannel::~ClientChannel()
+    {
+        closing_.store(true, std::memory_order_relaxed);
+        alive_.reset();
+        PendingCall *node = nullptr;
+        while (free_calls_.pop(node))
+        {
+            delete node;
+        }
+        while (pending_calls_.pop(node))
+        {
+            delete node;
+        }
+    }
+
+    std::shared_ptr<ClientChannel> ClientChannel::create(const ClientOptions &options, dRPC::Executor *executor)
+    {
+        return std::shared_ptr<ClientChannel>(new ClientChannel(options, executor), [](ClientChannel *channel)
+                                              {
+                                                  auto executor = channel->executor_;
+                                                  executor->spawn([channel, executor]()
+                                                                  {
+                                                                      channel->closing_.store(true, std::memory_order_relaxed);
+                                                                      channel->shutdown();
+                                                                      if (channel->connect_running_)
+                                                                      {
+                                                                          channel->delete_after_connect_ = true;
+                                                                          return;
+                                                                      }
+                                                                      // 完成回调中投递的任务先于析构执行
+                                                                      executor->spawn([channel]()
+                                                                                      { delete channel; }); }); });
     }
 
     void ClientChannel::close()
     {
+        // 连接只在executor线程上访问，channel析构后任务不再访问channel
+        closing_.store(true, std::memory_order_relaxed);
+        std::weak_ptr<bool> alive = alive_;
+        executor_->spawn([this, alive]()
+                         {
+                             if (!alive.expired())
+                             {
+                                 shutdown();
+                             } });
+    }
+
+    void ClientChannel::shutdown()
+    {
+        if (conn_->connecting())
+        {
+            // 中止进行中的连接：移出epoll，await_resume取消连接超时定时器，
+            // connect_fn看到closing_后失败缓存的请求并返回
+            executor_->add_event({EventType::DELETE, conn_.get()});
+            conn_->fail_connect(ECANCELED);
+            conn_->resume_connect();
+            return;
+        }
+        if (conn_->closed())
+        {
+            // 断线等待重连，读写协程已退出
+            fail_fast_ = true;
+            fail_unsent();
+            return;
+        }
+        // 唤醒读写协程，recv_fn看到连接关闭后失败进行中的请求
         conn_->close();
+        executor_->add_event({EventType::DELETE, conn_.get()});
+        conn_->resume_read();
+        conn_->resume_write();
     }
 
     dRPC::Task ClientChannel::recv_fn()
@@ -117,37 +330,98 @@ namespace dRPC
                 break;
             }
             auto request_id = header.request_id();
-            auto iter = session_registry_.find(request_id);
-            if (iter == session_registry_.end())
+            auto found = sessions_.take(request_id);
+            if (!found)
             {
-                error("Session not found: {}", request_id);
+                // 会话已超时释放，丢弃迟到的响应
+                input_stream.skip(response_len);
                 continue;
             }
-            auto [response, done] = iter->second;
-            session_registry_.erase(iter);
+            Session &session = *found;
+            executor_->cancel_timer(session.timer_id);
+            session.response_bytes = 2 * sizeof(uint32_t) + header_len + response_len;
 
-            input_stream.push_limit(response_len);
-            if (!response->ParseFromZeroCopyStream(&input_stream))
+            if (header.has_error_code() && header.error_code() != static_cast<int32_t>(ErrorCode::OK))
             {
-                error("Failed to parse response");
+                input_stream.skip(response_len);
+                set_failed(session, static_cast<ErrorCode>(header.error_code()),
+                           header.has_error_text() ? header.error_text() : "server error");
+                complete(session);
                 continue;
             }
-            input_stream.pop_limit();
 
-            if (done)
+            int64_t start = input_stream.ByteCount();
+            input_stream.push_limit(response_len);
+            if (!session.response->ParseFromZeroCopyStream(&input_stream))
             {
-                done->Run();
+                error("Failed to parse response");
+                set_failed(session, ErrorCode::FAILED, "failed to parse response");
             }
             else
             {
-                delete response;
+                // 只在executor线程更新，alpha = 1/8
+                int64_t latency = util::now_us() - session.start_us;
+                int64_t ewma = latency_ewma_us_.load(std::memory_order_relaxed);
+                latency_ewma_us_.store(ewma == 0 ? latency : ewma + (latency - ewma) / 8, std::memory_order_relaxed);
             }
+            input_stream.pop_limit();
+            input_stream.skip(response_len - (input_stream.ByteCount() - start));
+
+            complete(session);
         }
 
+        broken_.store(true, std::memory_order_relaxed);
         if (!conn_->closed())
         {
             conn_->close();
         }
+        conn_->set_read_handle(nullptr);
+
+        if (closing_.load(std::memory_order_relaxed))
+        {
+            // 主动关闭，不再重连
+            fail_fast_ = true;
+            fail_unsent();
+        }
+        else
+        {
+            on_disconnect();
+        }
+    }
+
+    void ClientChannel::fail_unsent()
+    {
+        conn_->discard_write(conn_->to_write_bytes());
+        buffered_bytes_.store(0, std::memory_order_relaxed);
+        std::vector<int64_t> ids;
+        ids.reserve(sessions_.size());
+        sessions_.for_each([&ids](int64_t id, Session &)
+                           { ids.push_back(id); });
+        fail_sessions(ids, ErrorCode::UNAVAILABLE, "connection unavailable");
+
+        // 等待容量的调用不再有机会发送
+        auto waiters = std::move(capacity_waiters_);
+        capacity_waiters_.clear();
+        for (auto &waiter : waiters)
+        {
+            fail_waiter(waiter, ErrorCode::UNAVAILABLE, "connection unavailable");
+        }
+    }
+
+    void ClientChannel::fail_sessions(const std::vector<int64_t> &ids, ErrorCode code, const std::string &reason)
+    {
+        // 先收集id再逐个完成，完成回调中可能发起新的调用
+        for (auto id : ids)
+        {
+            auto found = sessions_.take(id);
+            if (!found)
+            {
+                continue;
+            }
+            executor_->cancel_timer(found->timer_id);
+            set_failed(*found, code, reason);
+            complete(*found);
+        }
     }
 
     dRPC::Task ClientChannel::send_fn()
@@ -156,7 +430,194 @@ namespace dRPC
         {
             co_await WaitWriteAwaiter{conn_.get()};
             co_await conn_->async_write();
+            update_buffered();
+        }
+        // 协程结束，避免之后的resume_write访问已销毁的协程
+        conn_->set_write_handle(nullptr);
+    }
+
+    void ClientChannel::set_failed(Session &session, ErrorCode code, const std::string &reason)
+    {
+        session.error_code = code;
+        if (session.awaiter)
+        {
+            session.awaiter->code_ = code;
+            session.awaiter->error_text_ = reason;
+        }
+        if (auto cntl = dynamic_cast<dRPC::RpcController *>(session.controller))
+        {
+            cntl->SetFailed(code, reason);
+        }
+        else if (session.controller)
+        {
+            session.controller->SetFailed(reason);
+        }
+    }
+
+    void ClientChannel::complete(Session &session)
+    {
+        inflight_.fetch_sub(1, std::memory_order_relaxed);
+        if (session.metrics)
+        {
+            int64_t now_us = util::now_us();
+            session.metrics->on_response(session.response_bytes, session.error_code != ErrorCode::OK,
+                                         session.send_us - session.start_us, -1, now_us - session.start_us);
+            record_rpcz(session, now_us);
+            if (session.trace.sampled())
+            {
+                record_span(session, now_us);
+            }
+        }
+        if (!capacity_waiters_.empty())
+        {
+            admit_waiters();
+        }
+        auto cntl = dynamic_cast<dRPC::RpcController *>(session.controller);
+        if (session.awaiter)
+        {
+            if (cntl)
+            {
+                cntl->finish();
+            }
+            session.awaiter->handle_.resume();
+            return;
+        }
+        if (!session.owned)
+        {
+            // done可能释放controller，先结束controller
+            if (cntl)
+            {
+                cntl->finish();
+            }
+            session.done->Run();
+            return;
+        }
+
+        if (session.done)
+        {
+            session.done->Run();
+        }
+        else
+        {
+            delete session.response;
+        }
+        if (cntl)
+        {
+            cntl->finish();
+        }
+        delete session.controller;
+    }
+
+    void ClientChannel::send_cancel(int64_t request_id)
+    {
+        if (conn_->closed())
+        {
+            return;
+        }
+        util::OutputStream output_stream = conn_->get_output_stream();
+
+        proto::Header header;
+        header.set_magic(MAGIC_NUM);
+        header.set_version(VERSION);
+        header.set_message_type(proto::MessageType::CANCEL);
+        header.set_request_id(request_id);
+
+        uint32_t header_len = header.ByteSizeLong();
+        output_stream.write(&header_len, sizeof(header_len));
+        header.SerializeToZeroCopyStream(&output_stream);
+
+        uint32_t body_len = 0;
+        output_stream.write(&body_len, sizeof(body_len));
+        conn_->resume_write();
+    }
+
+    void ClientChannel::cancel_call(int64_t request_id)
+    {
+        auto found = sessions_.take(request_id);
+        if (!found)
+        {
+            return;
+        }
+        Session &session = *found;
+        executor_->cancel_timer(session.timer_id);
+
+        send_cancel(request_id);
+        set_failed(session, ErrorCode::CANCELED, "rpc call canceled");
+        complete(session);
+    }
+
+    void ClientChannel::on_timeout(int64_t request_id)
+    {
+        auto found = sessions_.take(request_id);
+        if (!found)
+        {
+            return;
+        }
+        Session &session = *found;
+
+        // 通知服务端放弃处理
+        send_cancel(request_id);
+        set_failed(session, ErrorCode::TIMEOUT, "rpc call timeout");
+        complete(session);
+    }
+
+    int64_t ClientChannel::call_timeout_ms(google::protobuf::RpcController *controller) const
+    {
+        if (auto cntl = dynamic_cast<dRPC::RpcController *>(controller); cntl && cntl->timeout_ms() >= 0)
+        {
+            return cntl->timeout_ms();
+        }
+        return timeout_ms_;
+    }
+
+    util::TraceContext ClientChannel::trace_parent(google::protobuf::RpcController *controller)
+    {
+        if (auto cntl = dynamic_cast<dRPC::RpcController *>(controller); cntl && cntl->trace_context().sampled())
+        {
+            return cntl->trace_context();
+        }
+        return util::Tracer::current();
+    }
+
+    void ClientChannel::record_rpcz(const Session &session, int64_t end_us)
+    {
+        auto &rpcz = util::Rpcz::instance();
+        if (!rpcz.enabled())
+        {
+            return;
         }
+        util::RpcRecord record;
+        record.method = session.metrics;
+        record.request_id = session.request_id;
+        record.start_us = session.start_us;
+        record.queue_us = session.send_us - session.start_us;
+        record.total_us = end_us - session.start_us;
+        record.trace_id = session.trace.trace_id;
+        record.request_bytes = session.request_bytes;
+        record.response_bytes = static_cast<uint32_t>(session.response_bytes);
+        record.error_code = static_cast<int32_t>(session.error_code);
+        record.set_peer(peer_ip_, ntohs(addr_.sin_port));
+        rpcz.record(record);
+    }
+
+    void ClientChannel::record_span(const Session &session, int64_t end_us)
+    {
+        auto &tracer = util::Tracer::instance();
+        if (!tracer.enabled())
+        {
+            return;
+        }
+        util::Span span;
+        span.trace_id = session.trace.trace_id;
+        span.id = session.trace.span_id;
+        span.parent_id = session.parent_span_id;
+        span.start_us = session.start_us;
+        span.end_us = end_us;
+        span.error_code = static_cast<int32_t>(session.error_code);
+        span.kind = util::SpanKind::CLIENT;
+        span.set_name(session.metrics->name());
+        span.set_peer(peer_ip_, ntohs(addr_.sin_port));
+        tracer.record(span);
     }
 
     void ClientChannel::CallMethod(
@@ -166,32 +627,369 @@ namespace dRPC
         google::protobuf::Message *response,
         google::protobuf::Closure *done)
     {
-        auto send_request = [=, this]
+        if (retrier_)
         {
-            util::OutputStream output_stream = conn_->get_output_stream();
+            if (int max_retries = retrier_->max_retries(method); max_retries > 0)
+            {
+                retrier_->call(this, max_retries, method, controller, request, response, done);
+                return;
+            }
+        }
+        PendingCall call{method, controller, request, response, done, call_timeout_ms(controller), util::now_us()};
+        call.trace = trace_parent(controller);
+        dispatch(call);
+    }
 
-            proto::Header header;
-            header.set_magic(MAGIC_NUM);
-            header.set_version(VERSION);
-            header.set_message_type(proto::MessageType::REQUEST);
-            header.set_request_id(request_id_++);
-            header.set_service_name(method->service()->full_name());
-            header.set_method_name(method->name());
-
-            uint32_t header_len = header.ByteSizeLong();
-            output_stream.write(&header_len, sizeof(header_len));
-            header.SerializeToZeroCopyStream(&output_stream);
-
-            uint32_t request_len = request->ByteSizeLong();
-            output_stream.write(&request_len, sizeof(request_len));
-            request->SerializePartialToZeroCopyStream(&output_stream);
-
-            delete controller;
-            delete request;
-
-            session_registry_[header.request_id()] = {response, done};
-            conn_->resume_write();
-        };
-        executor_->spawn(std::move(send_request));
-    }
-}
\ No newline at end of file
+    void ClientChannel::send(
+        const google::protobuf::MethodDescriptor *method,
+        dRPC::RpcController *controller,
+        const google::protobuf::Message *request,
+        google::protobuf::Message *response,
+        google::protobuf::Closure *done)
+    {
+        PendingCall call{method, controller, request, response, done, call_timeout_ms(controller), util::now_us()};
+        call.owned = false;
+        call.trace = trace_parent(controller);
+        dispatch(call);
+    }
+
+    void ClientChannel::send(
+        uint32_t method_id,
+        dRPC::RpcController *controller,
+        const google::protobuf::Message *request,
+        google::protobuf::Message *response,
+        google::protobuf::Closure *done)
+    {
+        PendingCall call{nullptr, controller, request, response, done, call_timeout_ms(controller), util::now_us()};
+        call.method_id = method_id;
+        call.owned = false;
+        call.trace = trace_parent(controller);
+        dispatch(call);
+    }
+
+    void ClientChannel::CallAwaiterBase::await_suspend(std::coroutine_handle<> handle)
+    {
+        handle_ = handle;
+        // 与CallMethod的顺序一致：先对冲，再重试
+        if (hedger_)
+        {
+            hedger_->call(owner_, this);
+            return;
+        }
+        if (auto retrier = retrier_ ? retrier_ : channel_->retrier_.get())
+        {
+            int max_retries = method_ ? retrier->max_retries(method_) : retrier->max_retries(method_id_);
+            if (max_retries > 0)
+            {
+                retrier->call(channel_, max_retries, this);
+                return;
+            }
+        }
+        // dispatch之后协程可能已在executor上恢复，不能再访问awaiter
+        channel_->dispatch({method_, controller_, request_, response_, nullptr,
+                            channel_->call_timeout_ms(controller_), util::now_us(), this, method_id_, false,
+                            trace_parent(controller_)});
+    }
+
+    void ClientChannel::CapacityAwaiter::await_suspend(std::coroutine_handle<> handle)
+    {
+        auto channel = channel_;
+        channel->executor_->spawn([channel, handle]()
+                                  {
+                                      channel->capacity_waiters_.push_back({PendingCall{}, handle, ++channel->next_waiter_id_});
+                                      channel->admit_waiters(); });
+    }
+
+    void ClientChannel::admit_waiters()
+    {
+        // 完成回调中可能再次触发，避免重入
+        if (admitting_)
+        {
+            return;
+        }
+        admitting_ = true;
+        while (!capacity_waiters_.empty() && !overloaded())
+        {
+            CapacityWaiter waiter = capacity_waiters_.front();
+            capacity_waiters_.pop_front();
+            if (waiter.call.awaiter)
+            {
+                executor_->cancel_timer(waiter.timer_id);
+                dispatch(waiter.call);
+            }
+            else
+            {
+                waiter.handle.resume();
+            }
+        }
+        admitting_ = false;
+    }
+
+    void ClientChannel::queue_waiter(const PendingCall &call)
+    {
+        CapacityWaiter waiter{call, nullptr, ++next_waiter_id_};
+        // 排队时间计入调用超时，后端卡住时排队的调用也按期失败
+        if (call.timeout_ms >= 0)
+        {
+            int64_t remaining_ms = call.timeout_ms - (util::now_us() - call.start_us) / 1000;
+            if (remaining_ms <= 0)
+            {
+                fail_waiter(waiter, ErrorCode::TIMEOUT, "rpc call timeout");
+                return;
+            }
+            std::weak_ptr<bool> alive = alive_;
+            int64_t id = waiter.id;
+            waiter.timer_id = executor_->run_after(remaining_ms, [this, alive, id]()
+                                                   {
+                                                       if (!alive.expired())
+                                                       {
+                                                           expire_waiter(id);
+                                                       } });
+        }
+        capacity_waiters_.push_back(waiter);
+        admit_waiters();
+    }
+
+    void ClientChannel::expire_waiter(int64_t id)
+    {
+        auto iter = std::find_if(capacity_waiters_.begin(), capacity_waiters_.end(),
+                                 [id](const CapacityWaiter &waiter)
+                                 { return waiter.id == id; });
+        if (iter == capacity_waiters_.end())
+        {
+            return;
+        }
+        CapacityWaiter waiter = *iter;
+        capacity_waiters_.erase(iter);
+        fail_waiter(waiter, ErrorCode::TIMEOUT, "rpc call timeout");
+    }
+
+    void ClientChannel::fail_waiter(const CapacityWaiter &waiter, ErrorCode code, const std::string &reason)
+    {
+        executor_->cancel_timer(waiter.timer_id);
+        // wait_capacity的协程恢复后发起的调用自行失败
+        if (!waiter.call.awaiter)
+        {
+            waiter.handle.resume();
+            return;
+        }
+        const PendingCall &call = waiter.call;
+        // 排队时已扣除，complete中再次扣除
+        inflight_.fetch_add(1, std::memory_order_relaxed);
+        Session session{call.response, call.done, call.controller, 0, call.awaiter, call.start_us, call.owned};
+        set_failed(session, code, reason);
+        complete(session);
+    }
+
+    void ClientChannel::update_buffered()
+    {
+        buffered_bytes_.store(conn_->to_write_bytes(), std::memory_order_relaxed);
+        if (!capacity_waiters_.empty())
+        {
+            admit_waiters();
+        }
+    }
+
+    void ClientChannel::dispatch(const PendingCall &call)
+    {
+        int64_t inflight = inflight_.fetch_add(1, std::memory_order_relaxed) + 1;
+        if ((max_inflight_ > 0 && inflight > max_inflight_) ||
+            (max_buffered_bytes_ > 0 && buffered_bytes_.load(std::memory_order_relaxed) >= max_buffered_bytes_))
+        {
+            // 协程调用挂起等待容量，其余调用立即以OVERLOADED失败，结果都在executor上返回
+            if (call.awaiter && wait_when_full_)
+            {
+                inflight_.fetch_sub(1, std::memory_order_relaxed);
+                executor_->spawn([this, call]()
+                                 { queue_waiter(call); });
+                return;
+            }
+            if (call.owned)
+            {
+                delete call.request;
+            }
+            Session session{call.response, call.done, call.controller, 0, call.awaiter, call.start_us, call.owned};
+            set_failed(session, ErrorCode::OVERLOADED, "too many pending requests");
+            if (executor_->in_executor_thread())
+            {
+                complete(session);
+            }
+            else
+            {
+                executor_->spawn([this, session]() mutable
+                                 { complete(session); });
+            }
+            return;
+        }
+
+        // 在所属executor线程上调用时直接编码到发送缓冲区
+        if (executor_->in_executor_thread())
+        {
+            send_request(call);
+            return;
+        }
+
+        // 其它线程：请求放入预分配节点，批量交给executor发送
+        PendingCall *node = nullptr;
+        if (!free_calls_.pop(node))
+        {
+            node = new PendingCall;
+        }
+        *node = call;
+        pending_calls_.push(node);
+        if (!flush_scheduled_.exchange(true, std::memory_order_acq_rel))
+        {
+            executor_->spawn([this]()
+                             { flush_calls(); });
+        }
+    }
+
+    void ClientChannel::flush_calls()
+    {
+        // 先清除标记再取队列，保证之后入队的请求会重新调度flush
+        flush_scheduled_.store(false, std::memory_order_release);
+        PendingCall *node = nullptr;
+        while (pending_calls_.pop(node))
+        {
+            send_request(*node);
+            // 池已满(高峰期额外分配的节点)时释放
+            if (!free_calls_.push(node))
+            {
+                delete node;
+            }
+        }
+    }
+
+    util::MethodMetrics *ClientChannel::method_metrics(const PendingCall &call)
+    {
+        if (call.method_id != 0)
+        {
+            auto &metrics = method_id_metrics_[call.method_id];
+            if (!metrics)
+            {
+                metrics = util::MetricsRegistry::instance().method("client", std::format("0x{:08x}", call.method_id));
+            }
+            return metrics;
+        }
+        auto &metrics = method_metrics_[call.method];
+        if (!metrics)
+        {
+            metrics = util::MetricsRegistry::instance().method("client", call.method->full_name());
+        }
+        return metrics;
+    }
+
+    void ClientChannel::send_request(const PendingCall &call)
+    {
+        if (fail_fast_)
+        {
+            if (call.owned)
+            {
+                delete call.request;
+            }
+            Session session{call.response, call.done, call.controller, 0, call.awaiter, call.start_us, call.owned};
+            set_failed(session, ErrorCode::UNAVAILABLE, "connection unavailable");
+            complete(session);
+            return;
+        }
+
+        util::OutputStream output_stream = conn_->get_output_stream();
+        // 帧在发送流中的起始位置，断线时据此判断请求是否已发出
+        uint64_t frame_start = conn_->bytes_sent() + conn_->to_write_bytes();
+
+        // 复用header对象，service/method名字符串保留容量，避免每次分配
+        proto::Header &header = request_header_;
+        header.set_magic(MAGIC_NUM);
+        header.set_version(VERSION);
+        header.set_message_type(proto::MessageType::REQUEST);
+        header.set_request_id(request_id_++);
+        if (call.method_id != 0)
+        {
+            header.set_method_id(call.method_id);
+            header.clear_service_name();
+            header.clear_method_name();
+        }
+        else
+        {
+            header.clear_method_id();
+            header.set_service_name(call.method->service()->full_name());
+            header.set_method_name(call.method->name());
+        }
+        // 扣除排队时间后的剩余超时随请求发给服务端
+        int64_t remaining_ms = -1;
+        if (call.timeout_ms >= 0)
+        {
+            remaining_ms = std::max<int64_t>(call.timeout_ms - (util::now_us() - call.start_us) / 1000, 0);
+            header.set_timeout_ms(remaining_ms);
+        }
+        else
+        {
+            header.clear_timeout_ms();
+        }
+        // 沿用上游的trace或按比例开始新trace，未采样的请求不携带trace信息
+        util::TraceContext trace;
+        uint64_t parent_span_id = 0;
+        if (call.trace.sampled())
+        {
+            trace = {call.trace.trace_id, util::Tracer::random_id()};
+            parent_span_id = call.trace.span_id;
+        }
+        else if (util::Tracer::instance().sample())
+        {
+            trace.trace_id = util::Tracer::random_id();
+            trace.span_id = trace.trace_id;
+        }
+        if (trace.sampled())
+        {
+            header.set_trace_id(trace.trace_id);
+            header.set_span_id(trace.span_id);
+        }
+        else if (header.has_trace_id())
+        {
+            header.clear_trace_id();
+            header.clear_span_id();
+        }
+
+        uint32_t header_len = header.ByteSizeLong();
+        output_stream.write(&header_len, sizeof(header_len));
+        header.SerializeToZeroCopyStream(&output_stream);
+
+        uint32_t request_len = call.request->ByteSizeLong();
+        output_stream.write(&request_len, sizeof(request_len));
+        call.request->SerializePartialToZeroCopyStream(&output_stream);
+
+        // 协程调用和send()的请求属于调用方
+        if (call.owned)
+        {
+            delete call.request;
+        }
+
+        int64_t request_id = header.request_id();
+        TimerId timer_id = 0;
+        if (remaining_ms >= 0)
+        {
+            timer_id = executor_->run_after(remaining_ms, [this, request_id]()
+                                            { on_timeout(request_id); });
+        }
+        util::MethodMetrics *metrics = method_metrics(call);
+        uint32_t request_bytes = conn_->bytes_sent() + conn_->to_write_bytes() - frame_start;
+        metrics->on_request(request_bytes);
+        Session session{call.response, call.done, call.controller, timer_id, call.awaiter, call.start_us,
+                        call.owned, frame_start, metrics, util::now_us()};
+        session.trace = trace;
+        session.parent_span_id = parent_span_id;
+        session.request_id = request_id;
+        session.request_bytes = request_bytes;
+        sessions_.insert(request_id, session);
+        buffered_bytes_.store(conn_->to_write_bytes(), std::memory_order_relaxed);
+        conn_->resume_write();
+
+        // StartCancel可能在任意线程调用，切回executor上取消会话
+        if (auto cntl = dynamic_cast<dRPC::RpcController *>(call.controller))
+        {
+            cntl->set_cancel_handler([this, request_id]()
+                                     { executor_->spawn([this, request_id]()
+                                                        { cancel_call(request_id); }); });
+        }
+    }
+}
@@ -1,30 +1,250 @@
 #pragma once
 
 #include <string>
+#include <atomic>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <coroutine>
+#include <netinet/in.h>
 #include <google/protobuf/service.h>
 
 #include "scheduler/scheduler.h"
 #include "scheduler/task.h"
+#include "util/service.h"
+#include "util/session_table.h"
+#include "util/mpmc_queue.h"
+#include "util/bounded_mpmc_queue.h"
+#include "util/retry_budget.h"
+#include "util/metrics.h"
+#include "util/rpcz.h"
+#include "proto/message.pb.h"
 
 namespace dRPC
 {
+    // 对冲请求：首个请求超过近期延迟的percentile_分位仍未响应时，向另一条连接/endpoint
+    // 发送同一请求，先成功的响应生效，另一个被取消。只用于幂等方法
+    struct HedgeOptions
+    {
+        std::vector<std::string> methods_; // 可对冲的方法全名(package.Service.Method)，为空表示不启用
+        double percentile_ = 0.95;
+        int min_samples_ = 64;   // 延迟样本不足时不对冲
+        int min_delay_ms_ = 1;   // 对冲延迟下限
+    };
+
+    // 失败重试：按方法配置最大重试次数，失败码在retry_on_中时按指数退避加随机抖动重发，
+    // 重试次数受RetryBudget限制，整体仍受调用超时约束。PooledChannel和LoadBalancedChannel
+    // 在自身层面重试，每次重试换到另一条连接/endpoint，子channel不再单独重试
+    struct RetryOptions
+    {
+        std::unordered_map<std::string, int> methods_; // 方法全名 -> 最大重试次数，为空表示不启用
+        std::vector<ErrorCode> retry_on_ = {ErrorCode::UNAVAILABLE, ErrorCode::TIMEOUT, ErrorCode::OVERLOADED};
+        int initial_backoff_ms_ = 10;
+        int max_backoff_ms_ = 1000;
+        int attempt_timeout_ms_ = -1; // 单次发送超时，<0表示使用整个调用的剩余时间
+        double budget_ratio_ = 0.1;   // 重试流量与正常流量之比
+        std::shared_ptr<util::RetryBudget> budget_; // 多个channel共享预算，为空时按budget_ratio_创建
+    };
+
     struct ClientOptions
     {
         std::string ip_;
         int port_;
+        int connection_num_ = 1;         // 连接池大小，仅PooledChannel使用
+        int connect_timeout_ms_ = 3000; // 连接超时，<0表示不超时
+        int timeout_ms_ = -1;           // 默认调用超时，RpcController::SetTimeout优先，<0表示不超时
+        int reconnect_initial_backoff_ms_ = 100; // 断线重连的退避时间，每次失败翻倍
+        int reconnect_max_backoff_ms_ = 5000;
+        int reconnect_hold_ms_ = 1000;  // 断线期间未发送的请求最多保留的时间，超过后失败，新请求快速失败直到重连成功
+        int max_inflight_ = -1;          // 未完成请求数上限，<=0表示不限制
+        int64_t max_buffered_bytes_ = -1; // 发送缓冲区未发出字节数上限，<=0表示不限制
+        bool wait_when_full_ = true;     // 达到上限时协程调用等待，否则与CallMethod一样以OVERLOADED失败
+        HedgeOptions hedge_;            // 仅PooledChannel和LoadBalancedChannel使用
+        RetryOptions retry_;
     };
 
-    class ClientChannel : public google::protobuf::RpcChannel
+    // 协程调用结果
+    template <typename Response>
+    struct CallResult
+    {
+        ErrorCode code = ErrorCode::OK;
+        std::string error_text;
+        Response response;
+
+        bool ok() const { return code == ErrorCode::OK; }
+    };
+
+    class Retrier;
+    class Hedger;
+
+    class ClientChannel : public google::protobuf::RpcChannel, public std::enable_shared_from_this<ClientChannel>
     {
     public:
+        // 协程调用的公共部分：请求按引用传入，响应保存在awaiter(即协程帧)中，
+        // 调用完成后在channel所属executor上直接恢复协程；与CallMethod一样，
+        // 可对冲的方法经Hedger发送，配置了重试的方法经Retrier发送
+        class CallAwaiterBase
+        {
+        public:
+            // channel为空(如负载均衡没有可用endpoint)时不挂起，直接返回失败
+            bool await_ready() const noexcept { return channel_ == nullptr; }
+            void await_suspend(std::coroutine_handle<> handle);
+
+            // 供重试、对冲等上层使用：写入调用结果并恢复协程，之后不能再访问awaiter
+            void resume(ErrorCode code, const std::string &error_text)
+            {
+                code_ = code;
+                error_text_ = error_text;
+                handle_.resume();
+            }
+
+            CallAwaiterBase(const CallAwaiterBase &) = delete;
+            CallAwaiterBase &operator=(const CallAwaiterBase &) = delete;
+
+        protected:
+            CallAwaiterBase(ClientChannel *channel,
+                            const google::protobuf::MethodDescriptor *method,
+                            const google::protobuf::Message &request,
+                            google::protobuf::Message *response,
+                            dRPC::RpcController *controller,
+                            std::shared_ptr<ClientChannel> owner,
+                            Hedger *hedger,
+                            Retrier *retrier)
+                : channel_(channel), owner_(std::move(owner)), hedger_(hedger), retrier_(retrier), method_(method), request_(&request), response_(response), controller_(controller) { check_channel(); }
+            CallAwaiterBase(ClientChannel *channel,
+                            uint32_t method_id,
+                            const google::protobuf::Message &request,
+                            google::protobuf::Message *response,
+                            dRPC::RpcController *controller,
+                            std::shared_ptr<ClientChannel> owner,
+                            Hedger *hedger,
+                            Retrier *retrier)
+                : channel_(channel), owner_(std::move(owner)), hedger_(hedger), retrier_(retrier), method_id_(method_id), request_(&request), response_(response), controller_(controller) { check_channel(); }
+
+            ErrorCode code_ = ErrorCode::OK;
+            std::string error_text_;
+
+        private:
+            friend class ClientChannel;
+            friend class Retrier;
+            friend class Hedger;
+
+            void check_channel()
+            {
+                if (channel_ == nullptr)
+                {
+                    code_ = ErrorCode::FAILED;
+                    error_text_ = "no available channel";
+                }
+            }
+
+            ClientChannel *channel_;
+            std::shared_ptr<ClientChannel> owner_; // 调用完成前保持channel存活，channel不由shared_ptr管理时为空
+            Hedger *hedger_;                       // 非空时对冲发送，channel_为第一次发送的channel
+            Retrier *retrier_;                     // 上层channel的重试策略，为空时使用channel_自身的
+            const google::protobuf::MethodDescriptor *method_ = nullptr;
+            uint32_t method_id_ = 0;
+            const google::protobuf::Message *request_;
+            google::protobuf::Message *response_;
+            dRPC::RpcController *controller_;
+            std::coroutine_handle<> handle_;
+        };
+
+        template <typename Response>
+        class CallAwaiter : public CallAwaiterBase
+        {
+        public:
+            CallAwaiter(ClientChannel *channel,
+                        const google::protobuf::MethodDescriptor *method,
+                        const google::protobuf::Message &request,
+                        dRPC::RpcController *controller,
+                        std::shared_ptr<ClientChannel> owner = nullptr,
+                        Hedger *hedger = nullptr,
+                        Retrier *retrier = nullptr)
+                : CallAwaiterBase(channel, method, request, &result_.response, controller, std::move(owner), hedger, retrier) {}
+            CallAwaiter(ClientChannel *channel,
+                        uint32_t method_id,
+                        const google::protobuf::Message &request,
+                        dRPC::RpcController *controller,
+                        std::shared_ptr<ClientChannel> owner = nullptr,
+                        Hedger *hedger = nullptr,
+                        Retrier *retrier = nullptr)
+                : CallAwaiterBase(channel, method_id, request, &result_.response, controller, std::move(owner), hedger, retrier) {}
+
+            CallResult<Response> await_resume()
+            {
+                result_.code = code_;
+                result_.error_text = std::move(error_text_);
+                return std::move(result_);
+            }
+
+        private:
+            CallResult<Response> result_;
+        };
+
         ClientChannel(const ClientOptions &options, dRPC::Executor *executor);
-        ~ClientChannel() = default;
+        ~ClientChannel();
+
+        // 由shared_ptr管理的channel，最后一个引用可在任意线程释放：在所属executor上关闭连接、
+        // 让读写协程退出，之前投递到该executor的任务执行完后再析构
+        static std::shared_ptr<ClientChannel> create(const ClientOptions &options, dRPC::Executor *executor);
 
+        // 不再重连，在所属executor上关闭连接，进行中的请求以UNAVAILABLE失败
         void close();
 
+        // co_await channel.wait_connected() 等待连接建立完成，结果为0或errno，
+        // 在channel所属executor上恢复
+        struct ConnectedAwaiter
+        {
+            ClientChannel *channel_;
+
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> handle);
+            int await_resume() const noexcept { return channel_->connect_error_; }
+        };
+
+        ConnectedAwaiter wait_connected() { return {this}; }
+
+        // co_await channel.wait_capacity() 等待未完成请求数和缓冲字节数低于上限，
+        // 在channel所属executor上恢复；CallMethod达到上限时直接以OVERLOADED失败
+        struct CapacityAwaiter
+        {
+            ClientChannel *channel_;
+
+            bool await_ready() const noexcept { return !channel_->overloaded(); }
+            void await_suspend(std::coroutine_handle<> handle);
+            void await_resume() const noexcept {}
+        };
+
+        CapacityAwaiter wait_capacity() { return {this}; }
+
+        // 是否达到未完成请求数或缓冲字节数上限
+        bool overloaded() const
+        {
+            return (max_inflight_ > 0 && inflight() >= max_inflight_) ||
+                   (max_buffered_bytes_ > 0 && buffered_bytes_.load(std::memory_order_relaxed) >= max_buffered_bytes_);
+        }
+
+        // 已发出但未收到响应的请求数
+        int64_t inflight() const { return inflight_.load(std::memory_order_relaxed); }
+        // 成功响应延迟的指数加权平均(微秒)，尚无样本时为0
+        int64_t latency_ewma_us() const { return latency_ewma_us_.load(std::memory_order_relaxed); }
+        // 连接失败或已断开(可能正在重连)，不应再分配新请求
+        bool broken() const { return broken_.load(std::memory_order_relaxed); }
+
+        dRPC::Executor *executor() const { return executor_; }
+        // ClientOptions::timeout_ms_
+        int64_t timeout_ms() const { return timeout_ms_; }
+
+        dRPC::Task connect_fn();
         dRPC::Task recv_fn();
         dRPC::Task send_fn();
 
+        // channel接管controller和request，request在发送后释放，controller在done执行后释放；
+        // 配置了重试的方法request保留到调用结束；
+        // 超时、取消或失败时通过controller报告，done仍会被调用；
+        // RpcController::StartCancel会向服务端发送CANCEL帧
         void CallMethod(
             const google::protobuf::MethodDescriptor *method,
             google::protobuf::RpcController *controller,
@@ -32,14 +252,160 @@ namespace dRPC
             google::protobuf::Message *response,
             google::protobuf::Closure *done) override;
 
+        // 不接管request和controller，二者须在done执行前保持有效，done不能为空；
+        // 供对冲、重试等需要重发同一请求的上层使用
+        void send(const google::protobuf::MethodDescriptor *method,
+                  dRPC::RpcController *controller,
+                  const google::protobuf::Message *request,
+                  google::protobuf::Message *response,
+                  google::protobuf::Closure *done);
+        // 按方法ID发送，用于生成stub的协程调用的重试和对冲
+        void send(uint32_t method_id,
+                  dRPC::RpcController *controller,
+                  const google::protobuf::Message *request,
+                  google::protobuf::Message *response,
+                  google::protobuf::Closure *done);
+
+        // auto result = co_await channel.call<EchoResponse>(method, request);
+        // controller可选且不被channel接管，用于设置超时和取消(StartCancel)
+        template <typename Response>
+        CallAwaiter<Response> call(const google::protobuf::MethodDescriptor *method,
+                                   const google::protobuf::Message &request,
+                                   dRPC::RpcController *controller = nullptr)
+        {
+            return {this, method, request, controller};
+        }
+
+        // 按方法ID调用，供protoc-gen-drpc生成的stub使用，服务端需注册对应的GeneratedService
+        template <typename Response>
+        CallAwaiter<Response> call(uint32_t method_id,
+                                   const google::protobuf::Message &request,
+                                   dRPC::RpcController *controller = nullptr)
+        {
+            return {this, method_id, request, controller};
+        }
+
     private:
+        struct Session
+        {
+            google::protobuf::Message *response = nullptr;
+            google::protobuf::Closure *done = nullptr;
+            google::protobuf::RpcController *controller = nullptr;
+            TimerId timer_id = 0;
+            CallAwaiterBase *awaiter = nullptr; // 协程调用，controller不归channel所有
+            int64_t start_us = 0;
+            bool owned = true; // controller、request和response是否由channel释放
+            uint64_t frame_start = 0; // 请求帧在发送流中的起始位置
+            util::MethodMetrics *metrics = nullptr;
+            int64_t send_us = 0;        // 请求写入发送缓冲的时间
+            size_t response_bytes = 0;
+            ErrorCode error_code = ErrorCode::OK;
+            util::TraceContext trace{}; // 客户端span，未采样时trace_id为0
+            uint64_t parent_span_id = 0;
+            int64_t request_id = 0;
+            uint32_t request_bytes = 0;
+        };
+
+        // 非executor线程发起的调用，节点预分配并循环使用
+        struct PendingCall
+        {
+            const google::protobuf::MethodDescriptor *method = nullptr;
+            google::protobuf::RpcController *controller = nullptr;
+            const google::protobuf::Message *request = nullptr;
+            google::protobuf::Message *response = nullptr;
+            google::protobuf::Closure *done = nullptr;
+            int64_t timeout_ms = -1;
+            int64_t start_us = 0;
+            CallAwaiterBase *awaiter = nullptr;
+            uint32_t method_id = 0; // 非0时按方法ID发送，method为空
+            bool owned = true;
+            util::TraceContext trace{}; // 发起调用时的上游span
+        };
+
+        // 背压：达到上限的协程调用和wait_capacity在executor线程上排队
+        struct CapacityWaiter
+        {
+            PendingCall call;                // call.awaiter非空时为等待发送的协程调用
+            std::coroutine_handle<> handle; // wait_capacity的协程
+            int64_t id = 0;
+            TimerId timer_id = 0;           // 排队期间的调用超时
+        };
+
+        static constexpr int PENDING_CALL_POOL_SIZE = 256;
+
+        int64_t call_timeout_ms(google::protobuf::RpcController *controller) const;
+        static util::TraceContext trace_parent(google::protobuf::RpcController *controller);
+        void record_span(const Session &session, int64_t end_us);
+        void record_rpcz(const Session &session, int64_t end_us);
+        void dispatch(const PendingCall &call);
+        void send_request(const PendingCall &call);
+        void flush_calls();
+        static void set_failed(Session &session, ErrorCode code, const std::string &reason);
+        void complete(Session &session);
+        void fail_sessions(const std::vector<int64_t> &ids, ErrorCode code, const std::string &reason);
+        void fail_unsent();
+        void update_buffered();
+        void admit_waiters();
+        void queue_waiter(const PendingCall &call);
+        void expire_waiter(int64_t id);
+        void fail_waiter(const CapacityWaiter &waiter, ErrorCode code, const std::string &reason);
+        util::MethodMetrics *method_metrics(const PendingCall &call);
+        void on_disconnect();
+        void shutdown();
+        void schedule_reconnect();
+        static int create_socket();
+        void on_timeout(int64_t request_id);
+        void cancel_call(int64_t request_id);
+        void send_cancel(int64_t request_id);
+
         std::unique_ptr<dRPC::net::Connection> conn_;
-        using Session = std::pair<google::protobuf::Message *, google::protobuf::Closure *>;
-        std::unordered_map<int64_t, Session> session_registry_;
+        util::SessionTable<Session> sessions_;
 
         dRPC::Executor *executor_;
+        int64_t timeout_ms_;
+        int connect_timeout_ms_;
+        int reconnect_initial_backoff_ms_;
+        int reconnect_max_backoff_ms_;
+        int64_t reconnect_hold_ms_;
+
+        struct sockaddr_in addr_ = {};
+        std::string peer_ip_; // addr_的文本形式，供rpcz和tracing使用
+        bool connect_done_ = false;
+        int connect_error_ = 0;
+        std::vector<std::coroutine_handle<>> connect_waiters_;
+        bool connect_running_ = false;      // connect_fn挂起等待连接完成
+        bool delete_after_connect_ = false; // 由connect_fn返回时析构channel
 
         int64_t request_id_ = 0;
+        std::atomic<int64_t> inflight_{0};
+        std::atomic<int64_t> latency_ewma_us_{0};
+
+        // 背压，capacity_waiters_只在executor线程访问
+        int64_t max_inflight_;
+        int64_t max_buffered_bytes_;
+        bool wait_when_full_;
+        std::atomic<int64_t> buffered_bytes_{0};
+        std::deque<CapacityWaiter> capacity_waiters_;
+        int64_t next_waiter_id_ = 0;
+        bool admitting_ = false;
+        std::atomic<bool> broken_{false};
+
+        // 以下重连状态只在executor线程访问(closing_除外)
+        std::atomic<bool> closing_{false};
+        bool fail_fast_ = false;
+        int reconnect_attempts_ = 0;
+        int64_t disconnected_us_ = 0;
+        std::shared_ptr<bool> alive_;
+
+        proto::Header request_header_;
+        // 方法统计缓存，只在executor线程访问；按方法ID发送的调用以ID命名
+        std::unordered_map<const google::protobuf::MethodDescriptor *, util::MethodMetrics *> method_metrics_;
+        std::unordered_map<uint32_t, util::MethodMetrics *> method_id_metrics_;
+        util::MPMCQueue<PendingCall *> pending_calls_; // 多个调用线程入队，只在executor线程取出
+        util::BoundedMPMCQueue<PendingCall *> free_calls_; // 调用线程取出节点，可能有多个消费者
+        std::atomic<bool> flush_scheduled_{false};
+
+        std::unique_ptr<Retrier> retrier_; // 未配置重试方法时为空
 
         ClientChannel(const ClientChannel &) = delete;
         ClientChannel &operator=(const ClientChannel &) = delete;
@@ -0,0 +1,338 @@
+#include "hedged_call.h"
+
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/message.h>
+
+#include "util/common.h"
+#include "util/clock.h"
+#include "util/generated_service.h"
+
+namespace dRPC
+{
+    namespace
+    {
+        struct HedgedCall;
+
+        // 一次发送，作为done交给ClientChannel::send
+        struct Attempt : public google::protobuf::Closure
+        {
+            void Run() override;
+
+            HedgedCall *call = nullptr;
+            std::shared_ptr<ClientChannel> channel; // 调用结束前保持channel存活
+            dRPC::RpcController controller;
+            std::unique_ptr<google::protobuf::Message> response;
+            int64_t start_us = 0;
+            bool done = false;
+        };
+
+        // 一个逻辑调用对应最多两次发送(两个request_id)，先成功的响应交给调用方。
+        // 引用计数：每次发送、对冲定时器和controller上的取消回调各持有一个，全部释放后删除
+        struct HedgedCall
+        {
+            ~HedgedCall()
+            {
+                delete request;
+            }
+
+            void start(int64_t delay_ms);
+            void arm_timer(int64_t delay_ms);
+            void on_timer();
+            void on_done(Attempt *attempt);
+            void send(Attempt &attempt, std::shared_ptr<ClientChannel> channel);
+            void cancel_all();
+            void release()
+            {
+                if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                {
+                    delete this;
+                }
+            }
+
+            Hedger *hedger = nullptr;
+            const google::protobuf::MethodDescriptor *method = nullptr; // 为空时按方法ID发送
+            uint32_t method_id = 0;
+            ClientChannel::CallAwaiterBase *awaiter = nullptr; // 协程调用，不接管controller
+            google::protobuf::RpcController *controller = nullptr;
+            const google::protobuf::Message *request = nullptr; // 归HedgedCall所有，协程调用时为调用方请求的副本
+            google::protobuf::Message *response = nullptr;
+            google::protobuf::Closure *done = nullptr;
+            int64_t timeout_ms = -1;
+            int64_t start_us = 0;
+
+            Attempt attempts[2];
+            std::mutex mutex;
+            int started = 0;
+            bool finished = false;
+            TimerId timer_id = 0;
+            std::atomic<int> refs{0};
+        };
+
+        void Attempt::Run()
+        {
+            call->on_done(this);
+        }
+
+        void HedgedCall::start(int64_t delay_ms)
+        {
+            // 整个调用的超时：controller未设置时使用channel的默认超时，两次发送都只用剩余时间
+            timeout_ms = attempts[0].channel->timeout_ms();
+            auto cntl = dynamic_cast<dRPC::RpcController *>(controller);
+            if (cntl && cntl->timeout_ms() >= 0)
+            {
+                timeout_ms = cntl->timeout_ms();
+            }
+
+            refs.store((delay_ms >= 0 ? 2 : 1) + (cntl ? 1 : 0), std::memory_order_relaxed);
+            if (cntl)
+            {
+                // 用户取消时取消所有发送。StartCancel在锁外执行回调，可能晚于调用完成，
+                // 回调持有一个引用，回调执行完或被finish清除时释放
+                std::shared_ptr<HedgedCall> self(this, [](HedgedCall *call)
+                                                 { call->release(); });
+                cntl->set_cancel_handler([self]()
+                                         { self->cancel_all(); });
+            }
+            started = 1;
+            if (delay_ms >= 0)
+            {
+                arm_timer(delay_ms);
+            }
+            send(attempts[0], attempts[0].channel);
+        }
+
+        void HedgedCall::send(Attempt &attempt, std::shared_ptr<ClientChannel> channel)
+        {
+            attempt.call = this;
+            attempt.channel = std::move(channel);
+            attempt.response.reset(response->New());
+            attempt.start_us = util::now_us();
+            if (timeout_ms >= 0)
+            {
+                attempt.controller.SetTimeout(std::max<int64_t>(timeout_ms - (attempt.start_us - start_us) / 1000, 0));
+            }
+            if (method)
+            {
+                attempt.channel->send(method, &attempt.controller, request, attempt.response.get(), &attempt);
+            }
+            else
+            {
+                attempt.channel->send(method_id, &attempt.controller, request, attempt.response.get(), &attempt);
+            }
+        }
+
+        void HedgedCall::arm_timer(int64_t delay_ms)
+        {
+            // 定时器只能在executor线程上设置和取消，固定使用第一次发送的channel所在executor
+            auto executor = attempts[0].channel->executor();
+            executor->spawn([this, executor, delay_ms]()
+                            {
+                                std::unique_lock<std::mutex> lock(mutex);
+                                if (finished)
+                                {
+                                    lock.unlock();
+                                    release();
+                                    return;
+                                }
+                                timer_id = executor->run_after(delay_ms, [this]()
+                                                               { on_timer(); }); });
+        }
+
+        void HedgedCall::on_timer()
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            timer_id = 0;
+            std::shared_ptr<ClientChannel> other;
+            if (!finished && started == 1)
+            {
+                other = hedger->selector()->select_other(attempts[0].channel.get());
+            }
+            if (other == nullptr)
+            {
+                lock.unlock();
+                release();
+                return;
+            }
+            started = 2;
+            attempts[1].channel = other;
+            // 定时器的引用转给第二次发送
+            lock.unlock();
+            send(attempts[1], std::move(other));
+        }
+
+        void HedgedCall::on_done(Attempt *attempt)
+        {
+            bool success = !attempt->controller.Failed();
+            if (success)
+            {
+                hedger->record(method_id, util::now_us() - attempt->start_us);
+            }
+
+            Attempt *loser = nullptr;
+            TimerId timer = 0;
+            bool win = false;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                attempt->done = true;
+                Attempt *other = attempt == &attempts[0] ? &attempts[1] : &attempts[0];
+                bool other_pending = other->channel != nullptr && !other->done;
+                // 成功的响应立即生效；失败时若另一次发送仍在进行则等待它的结果
+                if (!finished && (success || !other_pending))
+                {
+                    finished = true;
+                    win = true;
+                    if (other_pending)
+                    {
+                        loser = other;
+                    }
+                    // 定时器与第一次发送在同一executor上，未触发时直接取消
+                    if (timer_id != 0 && attempts[0].channel->executor()->in_executor_thread())
+                    {
+                        timer = timer_id;
+                        timer_id = 0;
+                    }
+                }
+            }
+
+            if (win)
+            {
+                if (loser)
+                {
+                    loser->controller.StartCancel();
+                }
+                if (timer != 0)
+                {
+                    attempts[0].channel->executor()->cancel_timer(timer);
+                    release();
+                }
+
+                // 与ClientChannel::CallMethod一致：结果写入response，失败通过controller报告
+                auto cntl = dynamic_cast<dRPC::RpcController *>(controller);
+                if (success)
+                {
+                    response->GetReflection()->Swap(response, attempt->response.get());
+                }
+                else if (cntl)
+                {
+                    cntl->SetFailed(attempt->controller.error_code(), attempt->controller.ErrorText());
+                }
+                else if (controller)
+                {
+                    controller->SetFailed(attempt->controller.ErrorText());
+                }
+                if (awaiter)
+                {
+                    if (cntl)
+                    {
+                        cntl->finish();
+                    }
+                    controller = nullptr;
+                    awaiter->resume(attempt->controller.error_code(), attempt->controller.ErrorText());
+                    release();
+                    return;
+                }
+                if (done)
+                {
+                    done->Run();
+                }
+                else
+                {
+                    delete response;
+                }
+                if (cntl)
+                {
+                    cntl->finish();
+                }
+                delete controller;
+                controller = nullptr;
+            }
+            release();
+        }
+
+        void HedgedCall::cancel_all()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (int i = 0; i < started; ++i)
+            {
+                if (!attempts[i].done)
+                {
+                    attempts[i].controller.StartCancel();
+                }
+            }
+        }
+    }
+
+    Hedger::Hedger(const HedgeOptions &options, ChannelSelector *selector)
+        : options_(options), selector_(selector)
+    {
+        for (auto &name : options_.methods_)
+        {
+            // 生成stub按方法ID调用，描述符池中没有该方法时仍可按ID匹配
+            uint32_t id = method_id(name);
+            methods_.emplace(id, std::make_unique<MethodState>());
+            auto method = google::protobuf::DescriptorPool::generated_pool()->FindMethodByName(name);
+            if (method == nullptr)
+            {
+                DRPC_WARN("hedge method not found in descriptor pool, only calls by method id are hedged: {}", name);
+                continue;
+            }
+            method_ids_.emplace(method, id);
+        }
+    }
+
+    int64_t Hedger::delay_ms(uint32_t method_id)
+    {
+        MethodState &state = *methods_.at(method_id);
+        uint64_t count = state.latencies.count();
+        int64_t cached = state.cached_delay_ms.load(std::memory_order_relaxed);
+        if (count < static_cast<uint64_t>(options_.min_samples_) ||
+            (cached >= 0 && count - state.cached_at.load(std::memory_order_relaxed) < REFRESH_SAMPLES))
+        {
+            return cached;
+        }
+        // 多个线程同时重算只是重复计算，结果相同
+        int64_t p = state.latencies.percentile(options_.percentile_, options_.min_samples_);
+        int64_t delay = p < 0 ? -1 : std::max<int64_t>((p + 999) / 1000, options_.min_delay_ms_);
+        state.cached_delay_ms.store(delay, std::memory_order_relaxed);
+        state.cached_at.store(count, std::memory_order_relaxed);
+        return delay;
+    }
+
+    void Hedger::call(std::shared_ptr<ClientChannel> first,
+                      const google::protobuf::MethodDescriptor *method,
+                      google::protobuf::RpcController *controller,
+                      const google::protobuf::Message *request,
+                      google::protobuf::Message *response,
+                      google::protobuf::Closure *done)
+    {
+        auto call = new HedgedCall;
+        call->hedger = this;
+        call->method = method;
+        call->controller = controller;
+        call->request = request;
+        call->response = response;
+        call->done = done;
+        call->method_id = method_ids_.at(method);
+        call->start_us = util::now_us();
+        call->attempts[0].channel = std::move(first);
+        call->start(delay_ms(call->method_id));
+    }
+
+    void Hedger::call(std::shared_ptr<ClientChannel> first, ClientChannel::CallAwaiterBase *awaiter)
+    {
+        auto call = new HedgedCall;
+        call->hedger = this;
+        call->method = awaiter->method_;
+        call->method_id = awaiter->method_ ? method_ids_.at(awaiter->method_) : awaiter->method_id_;
+        call->awaiter = awaiter;
+        call->controller = awaiter->controller_;
+        // 恢复协程后调用方可能修改或释放请求，而落败的一次发送可能仍在另一个channel中等待编码
+        auto request = awaiter->request_->New();
+        request->CopyFrom(*awaiter->request_);
+        call->request = request;
+        call->response = awaiter->response_;
+        call->start_us = util::now_us();
+        call->attempts[0].channel = std::move(first);
+        call->start(delay_ms(call->method_id));
+    }
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <mutex>
+#include <memory>
+#include <atomic>
+#include <unordered_map>
+#include <google/protobuf/service.h>
+
+#include "client/client_channel.h"
+#include "util/latency_window.h"
+
+namespace dRPC
+{
+    // 为对冲请求选择第二个子channel的接口，由持有多个ClientChannel的channel实现
+    class ChannelSelector
+    {
+    public:
+        virtual ~ChannelSelector() = default;
+        // 返回不同于exclude的可用channel，没有时返回nullptr；返回的引用保证发送期间channel不被释放
+        virtual std::shared_ptr<ClientChannel> select_other(ClientChannel *exclude) = 0;
+    };
+
+    // 对冲策略：记录可对冲方法和各方法的近期延迟分布，按方法计算对冲延迟
+    class Hedger
+    {
+    public:
+        Hedger(const HedgeOptions &options, ChannelSelector *selector);
+
+        bool enabled() const { return !methods_.empty(); }
+        bool eligible(const google::protobuf::MethodDescriptor *method) const
+        {
+            return method_ids_.count(method) != 0;
+        }
+        // 按方法ID调用(生成stub)时使用
+        bool eligible(uint32_t method_id) const
+        {
+            return methods_.count(method_id) != 0;
+        }
+
+        // 方法的对冲延迟(毫秒)，样本不足时返回-1表示不对冲
+        int64_t delay_ms(uint32_t method_id);
+        void record(uint32_t method_id, int64_t latency_us)
+        {
+            methods_.at(method_id)->latencies.add(latency_us);
+        }
+
+        // channel不接管request等参数的所有权语义与ClientChannel::CallMethod相同
+        void call(std::shared_ptr<ClientChannel> first,
+                  const google::protobuf::MethodDescriptor *method,
+                  google::protobuf::RpcController *controller,
+                  const google::protobuf::Message *request,
+                  google::protobuf::Message *response,
+                  google::protobuf::Closure *done);
+        // 协程调用：复制一份request，controller属于调用方，结束时写入结果并恢复awaiter
+        void call(std::shared_ptr<ClientChannel> first, ClientChannel::CallAwaiterBase *awaiter);
+
+        ChannelSelector *selector() const { return selector_; }
+
+    private:
+        static constexpr uint64_t REFRESH_SAMPLES = 64; // 每新增64个样本重新计算分位数
+
+        // 每个方法单独统计，慢方法的延迟不影响快方法的对冲时机
+        struct MethodState
+        {
+            util::LatencyWindow latencies;
+            std::atomic<int64_t> cached_delay_ms{-1};
+            std::atomic<uint64_t> cached_at{0};
+        };
+
+        HedgeOptions options_;
+        ChannelSelector *selector_;
+        // 构造后不再修改，查找无需加锁；统计按方法ID索引，按描述符调用时先映射为ID
+        std::unordered_map<uint32_t, std::unique_ptr<MethodState>> methods_;
+        std::unordered_map<const google::protobuf::MethodDescriptor *, uint32_t> method_ids_;
+    };
+}
@@ -0,0 +1,380 @@
+#include "load_balanced_channel.h"
+
+#include <algorithm>
+#include <fstream>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "util/common.h"
+#include "util/clock.h"
+
+namespace dRPC
+{
+    namespace
+    {
+        uint64_t fnv1a64(const std::string &str)
+        {
+            uint64_t hash = 14695981039346656037ull;
+            for (char c : str)
+            {
+                hash ^= static_cast<uint8_t>(c);
+                hash *= 1099511628211ull;
+            }
+            return hash;
+        }
+
+        // splitmix64的终结函数，打散调用方给出的连续key
+        uint64_t mix64(uint64_t x)
+        {
+            x ^= x >> 30;
+            x *= 0xbf58476d1ce4e5b9ull;
+            x ^= x >> 27;
+            x *= 0x94d049bb133111ebull;
+            x ^= x >> 31;
+            return x;
+        }
+
+        uint64_t fast_rand()
+        {
+            thread_local uint64_t state = mix64(static_cast<uint64_t>(util::now_us()) ^ reinterpret_cast<uintptr_t>(&state));
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            return state;
+        }
+
+        bool parse_endpoint(const std::string &line, Endpoint &endpoint)
+        {
+            auto begin = line.find_first_not_of(" \t\r");
+            if (begin == std::string::npos || line[begin] == '#')
+            {
+                return false;
+            }
+            auto end = line.find_last_not_of(" \t\r");
+            std::string text = line.substr(begin, end - begin + 1);
+            auto colon = text.rfind(':');
+            if (colon == std::string::npos)
+            {
+                error("invalid endpoint: {}", text);
+                return false;
+            }
+            endpoint.ip_ = text.substr(0, colon);
+            endpoint.port_ = atoi(text.c_str() + colon + 1);
+            if (endpoint.port_ <= 0 || endpoint.port_ > 65535)
+            {
+                error("invalid endpoint: {}", text);
+                return false;
+            }
+            return true;
+        }
+    }
+
+    LoadBalancedChannel::LoadBalancedChannel(const LoadBalancedOptions &options, dRPC::Scheduler *scheduler)
+        : options_(options), scheduler_(scheduler), reload_(std::make_shared<ReloadState>())
+    {
+        channels_.store(std::make_shared<ChannelSet>());
+        reload_->channel = this;
+        // 在负载均衡层面重试，以便换一个endpoint；子channel自身不重试
+        auto &retry = options_.client_.retry_;
+        if (!retry.methods_.empty())
+        {
+            retrier_ = std::make_unique<Retrier>(retry, this);
+            retry.methods_.clear();
+        }
+        if (!options_.client_.hedge_.methods_.empty())
+        {
+            hedger_ = std::make_unique<Hedger>(options_.client_.hedge_, this);
+        }
+        if (options_.endpoint_file_.empty())
+        {
+            update(options_.endpoints_);
+            return;
+        }
+        reload();
+        if (options_.reload_interval_ms_ > 0)
+        {
+            schedule_reload();
+        }
+    }
+
+    LoadBalancedChannel::~LoadBalancedChannel()
+    {
+        std::lock_guard<std::mutex> lock(reload_->mutex);
+        reload_->stopped = true;
+    }
+
+    void LoadBalancedChannel::schedule_reload()
+    {
+        // timer只能在executor线程上设置
+        auto executor = scheduler_->executor(0);
+        executor->spawn([executor, state = reload_, interval = options_.reload_interval_ms_]()
+                        { executor->run_after(interval, [state]()
+                                              {
+                                                  std::lock_guard<std::mutex> lock(state->mutex);
+                                                  if (state->stopped)
+                                                  {
+                                                      return;
+                                                  }
+                                                  state->channel->reload_locked();
+                                                  state->channel->schedule_reload(); }); });
+    }
+
+    bool LoadBalancedChannel::reload()
+    {
+        std::lock_guard<std::mutex> lock(reload_->mutex);
+        return reload_locked();
+    }
+
+    bool LoadBalancedChannel::reload_locked()
+    {
+        // 已移除的子channel：请求完成后释放引用，调用方仍持有的引用全部释放后
+        // 在子channel所属executor上关闭连接并析构
+        std::erase_if(retired_, [](auto &sub)
+                      { return sub->channel->inflight() == 0; });
+
+        if (options_.endpoint_file_.empty())
+        {
+            return true;
+        }
+        struct stat st;
+        if (::stat(options_.endpoint_file_.c_str(), &st) != 0)
+        {
+            error("stat endpoint file {} failed: {}", options_.endpoint_file_, strerror(errno));
+            return false;
+        }
+        int64_t mtime_ns = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+        if (mtime_ns == file_mtime_ns_)
+        {
+            return true;
+        }
+
+        std::ifstream file(options_.endpoint_file_);
+        if (!file)
+        {
+            error("open endpoint file {} failed", options_.endpoint_file_);
+            return false;
+        }
+        std::vector<Endpoint> endpoints;
+        std::string line;
+        while (std::getline(file, line))
+        {
+            Endpoint endpoint;
+            if (parse_endpoint(line, endpoint))
+            {
+                endpoints.push_back(std::move(endpoint));
+            }
+        }
+        file_mtime_ns_ = mtime_ns;
+        update(endpoints);
+        return true;
+    }
+
+    void LoadBalancedChannel::update(const std::vector<Endpoint> &endpoints)
+    {
+        auto old_set = channels_.load();
+        auto new_set = std::make_shared<ChannelSet>();
+
+        // 保留仍存在的endpoint的子channel，新endpoint建立新连接
+        for (auto &endpoint : endpoints)
+        {
+            auto same = [&endpoint](const std::shared_ptr<SubChannel> &sub)
+            { return sub->endpoint == endpoint; };
+            if (std::any_of(new_set->subs.begin(), new_set->subs.end(), same))
+            {
+                continue;
+            }
+            auto iter = std::find_if(old_set->subs.begin(), old_set->subs.end(), same);
+            if (iter != old_set->subs.end())
+            {
+                new_set->subs.push_back(*iter);
+                continue;
+            }
+            auto sub = std::make_shared<SubChannel>();
+            sub->endpoint = endpoint;
+            ClientOptions client_options = options_.client_;
+            client_options.ip_ = endpoint.ip_;
+            client_options.port_ = endpoint.port_;
+            sub->channel = ClientChannel::create(client_options, scheduler_->alloc_executor());
+            new_set->subs.push_back(std::move(sub));
+            info("load balancer add endpoint {}:{}", endpoint.ip_, endpoint.port_);
+        }
+        for (auto &sub : old_set->subs)
+        {
+            if (std::find(new_set->subs.begin(), new_set->subs.end(), sub) == new_set->subs.end())
+            {
+                info("load balancer remove endpoint {}:{}", sub->endpoint.ip_, sub->endpoint.port_);
+                retired_.push_back(sub);
+            }
+        }
+
+        if (options_.policy_ == LbPolicy::CONSISTENT_HASH)
+        {
+            int virtual_nodes = std::max(options_.virtual_nodes_, 1);
+            new_set->ring.reserve(new_set->subs.size() * virtual_nodes);
+            for (uint32_t i = 0; i < new_set->subs.size(); ++i)
+            {
+                auto &endpoint = new_set->subs[i]->endpoint;
+                std::string name = endpoint.ip_ + ":" + std::to_string(endpoint.port_) + "#";
+                for (int v = 0; v < virtual_nodes; ++v)
+                {
+                    new_set->ring.emplace_back(mix64(fnv1a64(name + std::to_string(v))), i);
+                }
+            }
+            std::sort(new_set->ring.begin(), new_set->ring.end());
+        }
+
+        channels_.store(std::move(new_set));
+    }
+
+    std::shared_ptr<ClientChannel> LoadBalancedChannel::select(google::protobuf::RpcController *controller)
+    {
+        auto set = channels_.load();
+        if (set->subs.empty())
+        {
+            return nullptr;
+        }
+        switch (options_.policy_)
+        {
+        case LbPolicy::P2C:
+            return select_p2c(*set);
+        case LbPolicy::CONSISTENT_HASH:
+            if (auto cntl = dynamic_cast<dRPC::RpcController *>(controller); cntl && cntl->has_request_code())
+            {
+                return select_hash(*set, cntl->request_code());
+            }
+            return select_round_robin(*set);
+        default:
+            return select_round_robin(*set);
+        }
+    }
+
+    std::shared_ptr<ClientChannel> LoadBalancedChannel::select_round_robin(const ChannelSet &set)
+    {
+        size_t n = set.subs.size();
+        size_t start = next_.fetch_add(1, std::memory_order_relaxed);
+        for (size_t i = 0; i < n; ++i)
+        {
+            auto &channel = set.subs[(start + i) % n]->channel;
+            if (!channel->broken())
+            {
+                return channel;
+            }
+        }
+        return nullptr;
+    }
+
+    std::shared_ptr<ClientChannel> LoadBalancedChannel::select_other(ClientChannel *exclude)
+    {
+        auto set = channels_.load();
+        size_t n = set->subs.size();
+        size_t start = next_.fetch_add(1, std::memory_order_relaxed);
+        for (size_t i = 0; i < n; ++i)
+        {
+            auto &channel = set->subs[(start + i) % n]->channel;
+            if (channel.get() != exclude && !channel->broken())
+            {
+                return channel;
+            }
+        }
+        return nullptr;
+    }
+
+    std::shared_ptr<ClientChannel> LoadBalancedChannel::select_p2c(const ChannelSet &set)
+    {
+        size_t n = set.subs.size();
+        if (n == 1)
+        {
+            return select_round_robin(set);
+        }
+        size_t a = fast_rand() % n;
+        size_t b = fast_rand() % (n - 1);
+        if (b >= a)
+        {
+            ++b;
+        }
+        auto &first = set.subs[a]->channel;
+        auto &second = set.subs[b]->channel;
+        if (first->broken() || second->broken())
+        {
+            if (first->broken() && second->broken())
+            {
+                return select_round_robin(set);
+            }
+            return first->broken() ? second : first;
+        }
+        // 没有延迟样本的新连接按1us计，优先获得请求以尽快得到样本
+        auto cost = [](const std::shared_ptr<ClientChannel> &channel)
+        {
+            return (channel->inflight() + 1) * std::max<int64_t>(channel->latency_ewma_us(), 1);
+        };
+        return cost(first) <= cost(second) ? first : second;
+    }
+
+    std::shared_ptr<ClientChannel> LoadBalancedChannel::select_hash(const ChannelSet &set, uint64_t code)
+    {
+        uint64_t hash = mix64(code);
+        auto iter = std::lower_bound(set.ring.begin(), set.ring.end(), std::make_pair(hash, uint32_t(0)));
+        // 顺时针找到第一个可用的节点
+        for (size_t i = 0; i < set.ring.size(); ++i, ++iter)
+        {
+            if (iter == set.ring.end())
+            {
+                iter = set.ring.begin();
+            }
+            auto &channel = set.subs[iter->second]->channel;
+            if (!channel->broken())
+            {
+                return channel;
+            }
+        }
+        return nullptr;
+    }
+
+    void LoadBalancedChannel::CallMethod(
+        const google::protobuf::MethodDescriptor *method,
+        google::protobuf::RpcController *controller,
+        const google::protobuf::Message *request,
+        google::protobuf::Message *response,
+        google::protobuf::Closure *done)
+    {
+        auto channel = select(controller);
+        if (channel)
+        {
+            if (hedger_ && hedger_->eligible(method))
+            {
+                hedger_->call(std::move(channel), method, controller, request, response, done);
+                return;
+            }
+            if (retrier_)
+            {
+                if (int max_retries = retrier_->max_retries(method); max_retries > 0)
+                {
+                    retrier_->call(channel.get(), max_retries, method, controller, request, response, done);
+                    return;
+                }
+            }
+            channel->CallMethod(method, controller, request, response, done);
+            return;
+        }
+
+        // 与ClientChannel一致：request和controller由channel释放，失败通过controller报告
+        if (auto cntl = dynamic_cast<dRPC::RpcController *>(controller))
+        {
+            cntl->SetFailed(ErrorCode::FAILED, "no available channel");
+        }
+        else if (controller)
+        {
+            controller->SetFailed("no available channel");
+        }
+        delete request;
+        if (done)
+        {
+            done->Run();
+        }
+        else
+        {
+            delete response;
+        }
+        delete controller;
+    }
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <google/protobuf/service.h>
+
+#include "client/client_channel.h"
+#include "client/hedged_call.h"
+#include "client/retry_call.h"
+
+namespace dRPC
+{
+    struct Endpoint
+    {
+        std::string ip_;
+        int port_ = 0;
+
+        bool operator==(const Endpoint &other) const = default;
+    };
+
+    enum class LbPolicy
+    {
+        ROUND_ROBIN,
+        P2C,             // 随机选两个，取 (inflight+1)*延迟EWMA 较小者
+        CONSISTENT_HASH, // 按RpcController::request_code在哈希环上选择，没有key时退化为轮询
+    };
+
+    struct LoadBalancedOptions
+    {
+        ClientOptions client_;          // 子channel的连接和超时配置，ip_/port_被忽略
+        std::vector<Endpoint> endpoints_; // 静态endpoint列表
+        std::string endpoint_file_;     // 非空时从文件加载endpoint，每行ip:port，#开头为注释
+        int reload_interval_ms_ = 5000; // 文件修改时间变化时重新加载
+        LbPolicy policy_ = LbPolicy::ROUND_ROBIN;
+        int virtual_nodes_ = 100; // 一致性哈希每个endpoint的虚拟节点数
+    };
+
+    // 每个endpoint一个ClientChannel，按策略为每次调用选择子channel，
+    // 连接失败或断开的子channel不再分配请求；可对冲的方法在另一个endpoint上发送对冲请求，
+    // 可重试的方法在另一个endpoint上重试
+    class LoadBalancedChannel : public google::protobuf::RpcChannel, public ChannelSelector
+    {
+    public:
+        LoadBalancedChannel(const LoadBalancedOptions &options, dRPC::Scheduler *scheduler);
+        ~LoadBalancedChannel();
+
+        // 重新读取endpoint文件，列表变化时更新子channel，返回是否读取成功
+        bool reload();
+
+        size_t size() const { return channels_.load()->subs.size(); }
+
+        void CallMethod(
+            const google::protobuf::MethodDescriptor *method,
+            google::protobuf::RpcController *controller,
+            const google::protobuf::Message *request,
+            google::protobuf::Message *response,
+            google::protobuf::Closure *done) override;
+
+        // co_await调用，没有可用endpoint时直接返回FAILED；awaiter持有子channel的引用，
+        // 调用期间endpoint被移除也不会释放子channel。对冲和重试与CallMethod相同
+        template <typename Response>
+        ClientChannel::CallAwaiter<Response> call(const google::protobuf::MethodDescriptor *method,
+                                                  const google::protobuf::Message &request,
+                                                  dRPC::RpcController *controller = nullptr)
+        {
+            auto channel = select(controller);
+            Hedger *hedger = hedger_ && hedger_->eligible(method) ? hedger_.get() : nullptr;
+            return {channel.get(), method, request, controller, channel, hedger, retrier_.get()};
+        }
+
+        template <typename Response>
+        ClientChannel::CallAwaiter<Response> call(uint32_t method_id,
+                                                  const google::protobuf::Message &request,
+                                                  dRPC::RpcController *controller = nullptr)
+        {
+            auto channel = select(controller);
+            Hedger *hedger = hedger_ && hedger_->eligible(method_id) ? hedger_.get() : nullptr;
+            return {channel.get(), method_id, request, controller, channel, hedger, retrier_.get()};
+        }
+
+        std::shared_ptr<ClientChannel> select_other(ClientChannel *exclude) override;
+
+    private:
+        // channel由ClientChannel::create创建，最后一个引用释放时在所属executor上关闭并析构
+        struct SubChannel
+        {
+            Endpoint endpoint;
+            std::shared_ptr<ClientChannel> channel;
+        };
+
+        // 不可变快照，更新时整体替换，选择路径无锁
+        struct ChannelSet
+        {
+            std::vector<std::shared_ptr<SubChannel>> subs;
+            std::vector<std::pair<uint64_t, uint32_t>> ring; // (hash, subs下标)，按hash排序
+        };
+
+        // 定时重新加载的状态，timer回调持有shared_ptr，channel析构后回调不再访问channel
+        struct ReloadState
+        {
+            std::mutex mutex;
+            LoadBalancedChannel *channel;
+            bool stopped = false;
+        };
+
+        // 返回的引用在调用结束前保持子channel存活
+        std::shared_ptr<ClientChannel> select(google::protobuf::RpcController *controller);
+        std::shared_ptr<ClientChannel> select_round_robin(const ChannelSet &set);
+        std::shared_ptr<ClientChannel> select_p2c(const ChannelSet &set);
+        std::shared_ptr<ClientChannel> select_hash(const ChannelSet &set, uint64_t code);
+
+        bool reload_locked();
+        void update(const std::vector<Endpoint> &endpoints);
+        void schedule_reload();
+
+        LoadBalancedOptions options_;
+        dRPC::Scheduler *scheduler_;
+
+        std::atomic<std::shared_ptr<const ChannelSet>> channels_;
+        std::atomic<size_t> next_{0};
+        std::unique_ptr<Hedger> hedger_; // 未配置对冲方法时为空
+        std::unique_ptr<Retrier> retrier_; // 未配置重试方法时为空
+
+        // 以下只在update/reload中访问，由reload_->mutex保护
+        std::vector<std::shared_ptr<SubChannel>> retired_; // 已移除但仍有进行中请求的子channel
+        int64_t file_mtime_ns_ = -1;
+        std::shared_ptr<ReloadState> reload_;
+
+        LoadBalancedChannel(const LoadBalancedChannel &) = delete;
+        LoadBalancedChannel &operator=(const LoadBalancedChannel &) = delete;
+    };
+}
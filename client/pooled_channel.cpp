@@ -0,0 +1,103 @@
+#include "pooled_channel.h"
+
+#include <algorithm>
+
+namespace dRPC
+{
+    PooledChannel::PooledChannel(const ClientOptions &options, dRPC::Scheduler *scheduler)
+    {
+        // 在连接池层面重试，以便换一条连接；各连接自身不重试
+        ClientOptions channel_options = options;
+        channel_options.retry_.methods_.clear();
+        if (!options.retry_.methods_.empty())
+        {
+            retrier_ = std::make_unique<Retrier>(options.retry_, this);
+        }
+
+        int connection_num = std::max(options.connection_num_, 1);
+        channels_.reserve(connection_num);
+        for (int i = 0; i < connection_num; ++i)
+        {
+            channels_.push_back(ClientChannel::create(channel_options, scheduler->alloc_executor()));
+        }
+        if (!options.hedge_.methods_.empty() && connection_num > 1)
+        {
+            hedger_ = std::make_unique<Hedger>(options.hedge_, this);
+        }
+    }
+
+    void PooledChannel::close()
+    {
+        for (auto &channel : channels_)
+        {
+            channel->close();
+        }
+    }
+
+    int64_t PooledChannel::inflight() const
+    {
+        int64_t total = 0;
+        for (auto &channel : channels_)
+        {
+            total += channel->inflight();
+        }
+        return total;
+    }
+
+    const std::shared_ptr<ClientChannel> &PooledChannel::select()
+    {
+        // 起点轮转，避免负载相同时总是落在第一条连接上；连接随PooledChannel存在，返回引用不增加计数
+        size_t n = channels_.size();
+        size_t start = next_.fetch_add(1, std::memory_order_relaxed);
+        size_t best = start % n;
+        int64_t best_inflight = channels_[best]->inflight();
+        for (size_t i = 1; i < n && best_inflight > 0; ++i)
+        {
+            size_t index = (start + i) % n;
+            int64_t inflight = channels_[index]->inflight();
+            if (inflight < best_inflight)
+            {
+                best = index;
+                best_inflight = inflight;
+            }
+        }
+        return channels_[best];
+    }
+
+    std::shared_ptr<ClientChannel> PooledChannel::select_other(ClientChannel *exclude)
+    {
+        std::shared_ptr<ClientChannel> best;
+        for (auto &channel : channels_)
+        {
+            if (channel.get() != exclude && !channel->broken() &&
+                (best == nullptr || channel->inflight() < best->inflight()))
+            {
+                best = channel;
+            }
+        }
+        return best;
+    }
+
+    void PooledChannel::CallMethod(
+        const google::protobuf::MethodDescriptor *method,
+        google::protobuf::RpcController *controller,
+        const google::protobuf::Message *request,
+        google::protobuf::Message *response,
+        google::protobuf::Closure *done)
+    {
+        if (hedger_ && hedger_->eligible(method))
+        {
+            hedger_->call(select(), method, controller, request, response, done);
+            return;
+        }
+        if (retrier_)
+        {
+            if (int max_retries = retrier_->max_retries(method); max_retries > 0)
+            {
+                retrier_->call(select().get(), max_retries, method, controller, request, response, done);
+                return;
+            }
+        }
+        select()->CallMethod(method, controller, request, response, done);
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <google/protobuf/service.h>
+
+#include "client/client_channel.h"
+#include "client/hedged_call.h"
+#include "client/retry_call.h"
+
+namespace dRPC
+{
+    // 对同一endpoint建立多条连接，连接分散在scheduler的各个executor上，
+    // 每次调用选择未完成请求数最少的连接，可对冲的方法在另一条连接上发送对冲请求，
+    // 可重试的方法在另一条连接上重试
+    class PooledChannel : public google::protobuf::RpcChannel, public ChannelSelector
+    {
+    public:
+        PooledChannel(const ClientOptions &options, dRPC::Scheduler *scheduler);
+        ~PooledChannel() = default;
+
+        void close();
+
+        size_t size() const { return channels_.size(); }
+
+        // 所有连接未完成请求数之和
+        int64_t inflight() const;
+
+        void CallMethod(
+            const google::protobuf::MethodDescriptor *method,
+            google::protobuf::RpcController *controller,
+            const google::protobuf::Message *request,
+            google::protobuf::Message *response,
+            google::protobuf::Closure *done) override;
+
+        std::shared_ptr<ClientChannel> select_other(ClientChannel *exclude) override;
+
+    private:
+        const std::shared_ptr<ClientChannel> &select();
+
+        std::vector<std::shared_ptr<ClientChannel>> channels_;
+        std::atomic<size_t> next_{0};
+        std::unique_ptr<Hedger> hedger_; // 未配置对冲方法时为空
+        std::unique_ptr<Retrier> retrier_; // 未配置重试方法时为空
+
+        PooledChannel(const PooledChannel &) = delete;
+        PooledChannel &operator=(const PooledChannel &) = delete;
+    };
+}
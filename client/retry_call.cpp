@@ -0,0 +1,319 @@
+#include "retry_call.h"
+
+#include <algorithm>
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/message.h>
+
+#include "util/common.h"
+#include "util/clock.h"
+#include "util/generated_service.h"
+#include "client/hedged_call.h"
+
+namespace dRPC
+{
+    namespace
+    {
+        uint64_t fast_rand()
+        {
+            thread_local uint64_t state = static_cast<uint64_t>(util::now_us()) | 1;
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            return state;
+        }
+
+        // 一个逻辑调用的多次发送依次进行，除start外的所有操作都在第一次发送的channel所属executor上执行，
+        // 重试换到其它executor上的channel时，发送完成后切换回来。
+        // 发送或退避定时器未完成时由self_保持存活，用户取消通过weak_ptr找到调用
+        struct RetryCall : public std::enable_shared_from_this<RetryCall>
+        {
+            struct AttemptDone : public google::protobuf::Closure
+            {
+                RetryCall *call = nullptr;
+                void Run() override
+                {
+                    if (call->executor->in_executor_thread())
+                    {
+                        call->on_done();
+                        return;
+                    }
+                    auto retry_call = call;
+                    call->executor->spawn([retry_call]()
+                                          { retry_call->on_done(); });
+                }
+            };
+
+            ~RetryCall()
+            {
+                if (!awaiter)
+                {
+                    delete request;
+                }
+            }
+
+            void start();
+            void send_attempt();
+            void on_done();
+            void cancel();
+            void finish(ErrorCode code, const std::string &reason);
+            int64_t remaining_ms() const
+            {
+                return deadline_us < 0 ? -1 : std::max<int64_t>(deadline_us - util::now_us(), 0) / 1000;
+            }
+
+            Retrier *retrier = nullptr;
+            ClientChannel *channel = nullptr; // 当前发送的channel
+            std::shared_ptr<ClientChannel> channel_ref; // channel由shared_ptr管理时，退避等待期间保持存活
+            dRPC::Executor *executor = nullptr; // 第一次发送的channel所属executor
+            int max_retries = 0;
+            const google::protobuf::MethodDescriptor *method = nullptr;
+            uint32_t method_id = 0; // 非0时按方法ID发送
+            ClientChannel::CallAwaiterBase *awaiter = nullptr; // 协程调用，不接管request和controller
+            google::protobuf::RpcController *controller = nullptr;
+            const google::protobuf::Message *request = nullptr;
+            google::protobuf::Message *response = nullptr;
+            google::protobuf::Closure *done = nullptr;
+
+            int retries = 0;
+            int64_t deadline_us = -1;
+            dRPC::RpcController attempt_controller;
+            AttemptDone attempt_done;
+            TimerId timer_id = 0;
+            bool canceled = false;
+            bool finished = false;
+            std::shared_ptr<RetryCall> self_;
+        };
+
+        void RetryCall::start()
+        {
+            int64_t timeout_ms = channel->timeout_ms();
+            auto cntl = dynamic_cast<dRPC::RpcController *>(controller);
+            if (cntl && cntl->timeout_ms() >= 0)
+            {
+                timeout_ms = cntl->timeout_ms();
+            }
+            if (timeout_ms >= 0)
+            {
+                deadline_us = util::now_us() + timeout_ms * 1000;
+            }
+
+            attempt_done.call = this;
+            executor = channel->executor();
+            self_ = shared_from_this();
+            if (cntl)
+            {
+                std::weak_ptr<RetryCall> weak = self_;
+                auto executor = this->executor;
+                cntl->set_cancel_handler([weak, executor]()
+                                         { executor->spawn([weak]()
+                                                           {
+                                                               if (auto call = weak.lock())
+                                                               {
+                                                                   call->cancel();
+                                                               } }); });
+            }
+            retrier->budget().deposit();
+            send_attempt();
+        }
+
+        void RetryCall::send_attempt()
+        {
+            attempt_controller.Reset();
+            int64_t timeout_ms = remaining_ms();
+            if (retrier->attempt_timeout_ms() >= 0)
+            {
+                timeout_ms = timeout_ms < 0 ? retrier->attempt_timeout_ms() : std::min(timeout_ms, retrier->attempt_timeout_ms());
+            }
+            if (timeout_ms >= 0)
+            {
+                attempt_controller.SetTimeout(timeout_ms);
+            }
+            // send之后本对象可能已被释放(连接不可用时同步完成)
+            if (method_id != 0)
+            {
+                channel->send(method_id, &attempt_controller, request, response, &attempt_done);
+            }
+            else
+            {
+                channel->send(method, &attempt_controller, request, response, &attempt_done);
+            }
+        }
+
+        void RetryCall::on_done()
+        {
+            if (canceled)
+            {
+                finish(ErrorCode::CANCELED, "rpc call canceled");
+                return;
+            }
+            if (!attempt_controller.Failed())
+            {
+                finish(ErrorCode::OK, "");
+                return;
+            }
+
+            ErrorCode code = attempt_controller.error_code();
+            if (retries < max_retries && retrier->retryable(code))
+            {
+                int64_t backoff = retrier->backoff_ms(retries + 1);
+                int64_t remaining = remaining_ms();
+                if ((remaining < 0 || remaining > backoff) && retrier->budget().try_withdraw())
+                {
+                    ++retries;
+                    response->Clear();
+                    // 连接失败、过载等错误换一个子channel重试，避免重复发往同一个不可用的后端
+                    if (auto selector = retrier->selector())
+                    {
+                        if (auto other = selector->select_other(channel))
+                        {
+                            channel = other.get();
+                            channel_ref = std::move(other);
+                        }
+                    }
+                    timer_id = executor->run_after(backoff, [this]()
+                                                              {
+                                                                  timer_id = 0;
+                                                                  send_attempt(); });
+                    return;
+                }
+            }
+            finish(code, attempt_controller.ErrorText());
+        }
+
+        void RetryCall::cancel()
+        {
+            if (finished)
+            {
+                return;
+            }
+            canceled = true;
+            if (timer_id != 0)
+            {
+                // 处于退避等待中，没有进行中的发送
+                executor->cancel_timer(timer_id);
+                timer_id = 0;
+                finish(ErrorCode::CANCELED, "rpc call canceled");
+                return;
+            }
+            attempt_controller.StartCancel();
+        }
+
+        void RetryCall::finish(ErrorCode code, const std::string &reason)
+        {
+            finished = true;
+            auto cntl = dynamic_cast<dRPC::RpcController *>(controller);
+            if (code != ErrorCode::OK)
+            {
+                if (cntl)
+                {
+                    cntl->SetFailed(code, reason);
+                }
+                else if (controller)
+                {
+                    controller->SetFailed(reason);
+                }
+            }
+            if (awaiter)
+            {
+                if (cntl)
+                {
+                    cntl->finish();
+                }
+                // 恢复的协程可能立即销毁awaiter和request，先释放自身引用，函数返回后才析构
+                auto self = std::move(self_);
+                awaiter->resume(code, reason);
+                return;
+            }
+            if (done)
+            {
+                done->Run();
+            }
+            else
+            {
+                delete response;
+            }
+            if (cntl)
+            {
+                cntl->finish();
+            }
+            delete controller;
+            controller = nullptr;
+            // 最后释放自身引用
+            auto self = std::move(self_);
+        }
+    }
+
+    Retrier::Retrier(const RetryOptions &options, ChannelSelector *selector)
+        : options_(options), selector_(selector), budget_(options.budget_)
+    {
+        if (!budget_)
+        {
+            budget_ = std::make_shared<util::RetryBudget>(options_.budget_ratio_);
+        }
+        for (auto &[name, max_retries] : options_.methods_)
+        {
+            // 生成stub按方法ID调用，描述符池中没有该方法时仍可按ID匹配
+            method_ids_[method_id(name)] = max_retries;
+            auto method = google::protobuf::DescriptorPool::generated_pool()->FindMethodByName(name);
+            if (method == nullptr)
+            {
+                DRPC_WARN("retry method not found in descriptor pool, only calls by method id are retried: {}", name);
+                continue;
+            }
+            methods_[method] = max_retries;
+        }
+    }
+
+    bool Retrier::retryable(ErrorCode code) const
+    {
+        return std::find(options_.retry_on_.begin(), options_.retry_on_.end(), code) != options_.retry_on_.end();
+    }
+
+    int64_t Retrier::backoff_ms(int retry) const
+    {
+        int64_t backoff = std::max(options_.initial_backoff_ms_, 1);
+        for (int i = 1; i < retry && backoff < options_.max_backoff_ms_; ++i)
+        {
+            backoff *= 2;
+        }
+        backoff = std::min<int64_t>(backoff, std::max(options_.max_backoff_ms_, 1));
+        return backoff / 2 + static_cast<int64_t>(fast_rand() % (backoff - backoff / 2 + 1));
+    }
+
+    void Retrier::call(ClientChannel *channel,
+                       int max_retries,
+                       const google::protobuf::MethodDescriptor *method,
+                       google::protobuf::RpcController *controller,
+                       const google::protobuf::Message *request,
+                       google::protobuf::Message *response,
+                       google::protobuf::Closure *done)
+    {
+        auto call = std::make_shared<RetryCall>();
+        call->retrier = this;
+        call->channel = channel;
+        call->channel_ref = channel->weak_from_this().lock();
+        call->max_retries = max_retries;
+        call->method = method;
+        call->controller = controller;
+        call->request = request;
+        call->response = response;
+        call->done = done;
+        call->start();
+    }
+
+    void Retrier::call(ClientChannel *channel, int max_retries, ClientChannel::CallAwaiterBase *awaiter)
+    {
+        auto call = std::make_shared<RetryCall>();
+        call->retrier = this;
+        call->channel = channel;
+        call->channel_ref = channel->weak_from_this().lock();
+        call->max_retries = max_retries;
+        call->method = awaiter->method_;
+        call->method_id = awaiter->method_id_;
+        call->awaiter = awaiter;
+        call->controller = awaiter->controller_;
+        call->request = awaiter->request_;
+        call->response = awaiter->response_;
+        call->start();
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <memory>
+#include <unordered_map>
+#include <google/protobuf/service.h>
+
+#include "client/client_channel.h"
+#include "util/retry_budget.h"
+
+namespace dRPC
+{
+    class ChannelSelector;
+
+    // 重试策略：可重试方法、退避时间和重试预算，由ClientChannel在CallMethod和协程调用中使用。
+    // 持有多个子channel的channel(PooledChannel、LoadBalancedChannel)传入selector，
+    // 每次重试经select_other换到另一个可用子channel，没有其它可用子channel时仍在原channel上重试
+    class Retrier
+    {
+    public:
+        explicit Retrier(const RetryOptions &options, ChannelSelector *selector = nullptr);
+
+        // 方法的最大重试次数，不可重试返回-1
+        int max_retries(const google::protobuf::MethodDescriptor *method) const
+        {
+            auto iter = methods_.find(method);
+            return iter == methods_.end() ? -1 : iter->second;
+        }
+        // 按方法ID调用(生成stub)时使用
+        int max_retries(uint32_t method_id) const
+        {
+            auto iter = method_ids_.find(method_id);
+            return iter == method_ids_.end() ? -1 : iter->second;
+        }
+        bool retryable(ErrorCode code) const;
+        // 第retry次重试(从1开始)前的等待时间，指数退避并在[backoff/2, backoff]内随机抖动
+        int64_t backoff_ms(int retry) const;
+        int64_t attempt_timeout_ms() const { return options_.attempt_timeout_ms_; }
+        util::RetryBudget &budget() { return *budget_; }
+        ChannelSelector *selector() const { return selector_; }
+
+        // 参数的所有权语义与ClientChannel::CallMethod相同
+        void call(ClientChannel *channel,
+                  int max_retries,
+                  const google::protobuf::MethodDescriptor *method,
+                  google::protobuf::RpcController *controller,
+                  const google::protobuf::Message *request,
+                  google::protobuf::Message *response,
+                  google::protobuf::Closure *done);
+        // 协程调用：request和controller属于调用方，结束时写入结果并恢复awaiter
+        void call(ClientChannel *channel, int max_retries, ClientChannel::CallAwaiterBase *awaiter);
+
+    private:
+        RetryOptions options_;
+        ChannelSelector *selector_;
+        std::unordered_map<const google::protobuf::MethodDescriptor *, int> methods_;
+        std::unordered_map<uint32_t, int> method_ids_;
+        std::shared_ptr<util::RetryBudget> budget_;
+    };
+}
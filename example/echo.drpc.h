@@ -0,0 +1,81 @@
+// Generated by protoc-gen-drpc. DO NOT EDIT!
+// source: echo.proto
+
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+#include "echo.pb.h"
+#include "util/generated_service.h"
+#include "client/client_channel.h"
+
+// EchoService的方法ID，同一服务内ID冲突时call_method中的case重复导致编译失败
+struct EchoServiceMethodId
+{
+    static constexpr uint32_t Echo = dRPC::method_id("EchoService.Echo");
+    static constexpr uint32_t Echo1 = dRPC::method_id("EchoService.Echo1");
+};
+
+// 服务端基类，Derived需实现每个方法：
+//   void/dRPC::Task Method(dRPC::RpcController &controller, const Request &request,
+//                          Response &response, google::protobuf::Closure *done);
+// handler可以是协程，处理完成后调用done->Run()
+template <typename Derived>
+class EchoServiceBase : public dRPC::GeneratedService
+{
+public:
+    std::string_view service_name() const override { return "EchoService"; }
+
+    std::span<const dRPC::MethodInfo> methods() const override
+    {
+        static const dRPC::MethodInfo infos[] = {
+            {EchoServiceMethodId::Echo, "EchoService.Echo", &::EchoRequest::default_instance(), &::EchoResponse::default_instance()},
+            {EchoServiceMethodId::Echo1, "EchoService.Echo1", &::EchoRequest::default_instance(), &::EchoResponse::default_instance()},
+        };
+        return infos;
+    }
+
+    void call_method(uint32_t method_id,
+                     dRPC::RpcController *controller,
+                     const google::protobuf::Message *request,
+                     google::protobuf::Message *response,
+                     google::protobuf::Closure *done) override
+    {
+        auto self = static_cast<Derived *>(this);
+        switch (method_id)
+        {
+        case EchoServiceMethodId::Echo:
+            self->Echo(*controller, static_cast<const ::EchoRequest &>(*request), static_cast<::EchoResponse &>(*response), done);
+            break;
+        case EchoServiceMethodId::Echo1:
+            self->Echo1(*controller, static_cast<const ::EchoRequest &>(*request), static_cast<::EchoResponse &>(*response), done);
+            break;
+        default:
+            controller->SetFailed("method not found");
+            done->Run();
+            break;
+        }
+    }
+};
+
+// 客户端stub：auto result = co_await client.Method(request);
+class EchoServiceClient
+{
+public:
+    explicit EchoServiceClient(dRPC::ClientChannel *channel) : channel_(channel) {}
+
+    dRPC::ClientChannel::CallAwaiter<::EchoResponse> Echo(const ::EchoRequest &request, dRPC::RpcController *controller = nullptr)
+    {
+        return channel_->call<::EchoResponse>(EchoServiceMethodId::Echo, request, controller);
+    }
+
+    dRPC::ClientChannel::CallAwaiter<::EchoResponse> Echo1(const ::EchoRequest &request, dRPC::RpcController *controller = nullptr)
+    {
+        return channel_->call<::EchoResponse>(EchoServiceMethodId::Echo1, request, controller);
+    }
+
+private:
+    dRPC::ClientChannel *channel_;
+};
@@ -0,0 +1,53 @@
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include "util/common.h"
+#include "scheduler/scheduler.h"
+#include "scheduler/task.h"
+#include "client/client_channel.h"
+#include "util/service.h"
+#include "example/echo.drpc.h"
+
+using namespace dRPC;
+
+// 串行发起请求，响应保存在协程帧中
+Task echo_loop(ClientChannel *channel, int count, std::atomic<bool> *finished)
+{
+    co_await channel->wait_connected();
+    EchoServiceClient client(channel);
+    EchoRequest request;
+    for (int i = 0; i < count; ++i)
+    {
+        request.set_message("echo request" + std::to_string(i));
+        auto result = co_await client.Echo1(request);
+        if (!result.ok())
+        {
+            error("call failed, code: {}, error: {}", static_cast<int>(result.code), result.error_text);
+            continue;
+        }
+        info("response: {}", result.response.DebugString());
+    }
+    finished->store(true);
+}
+
+int main()
+{
+    Scheduler scheduler(1000);
+    auto executor = scheduler.alloc_executor();
+    ClientOptions client_options;
+    client_options.ip_ = "127.0.0.1";
+    client_options.port_ = 8888;
+    client_options.timeout_ms_ = 1000;
+    ClientChannel channel(client_options, executor);
+
+    std::atomic<bool> finished{false};
+    executor->spawn([&]()
+                    { echo_loop(&channel, 1000, &finished); });
+    while (!finished.load())
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    scheduler.stop();
+}
@@ -1,4 +1,7 @@
+#include <csignal>
+
 #include "server/rpc_server.h"
+#include "util/rpcz.h"
 #include "example/echo_service.h"
 
 int main()
@@ -9,6 +12,15 @@ int main()
     // 注册服务
     EchoServiceImpl echo_service;
     rpc_server.register_service("EchoService", &echo_service);
+    // 生成代码的客户端按方法ID调用
+    EchoServiceDirectImpl echo_direct_service;
+    if (!rpc_server.register_service(&echo_direct_service))
+    {
+        return 1;
+    }
+
+    // kill -USR1 <pid> 把最近和最慢的请求写入drpc_rpcz.txt
+    dRPC::util::Rpcz::instance().dump_on_signal("drpc_rpcz.txt", SIGUSR1);
 
     rpc_server.start();
     return 0;
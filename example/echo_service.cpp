@@ -10,6 +10,7 @@ void EchoServiceImpl::Echo(
     std::string message = "[Echo] " + request->message();
     info("Echo: {}", message);
     response->set_message(message);
+    done->Run();
 }
 
 void EchoServiceImpl::Echo1(
@@ -21,4 +22,29 @@ void EchoServiceImpl::Echo1(
     std::string message = "[Echo1] " + request->message();
     info("Echo1: {}", message);
     response->set_message(message);
-}
\ No newline at end of file
+    done->Run();
+}
+
+void EchoServiceDirectImpl::Echo(
+    dRPC::RpcController &,
+    const ::EchoRequest &request,
+    ::EchoResponse &response,
+    ::google::protobuf::Closure *done)
+{
+    std::string message = "[Echo] " + request.message();
+    info("Echo: {}", message);
+    response.set_message(message);
+    done->Run();
+}
+
+void EchoServiceDirectImpl::Echo1(
+    dRPC::RpcController &,
+    const ::EchoRequest &request,
+    ::EchoResponse &response,
+    ::google::protobuf::Closure *done)
+{
+    std::string message = "[Echo1] " + request.message();
+    info("Echo1: {}", message);
+    response.set_message(message);
+    done->Run();
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "example/echo.pb.h"
+#include "example/echo.drpc.h"
 
 class EchoServiceImpl : public ::EchoService
 {
@@ -16,4 +17,19 @@ public:
                const ::EchoRequest *request,
                ::EchoResponse *response,
                ::google::protobuf::Closure *done) override;
-};
\ No newline at end of file
+};
+
+// protoc-gen-drpc生成的基类，按方法ID直接分发到handler
+class EchoServiceDirectImpl : public EchoServiceBase<EchoServiceDirectImpl>
+{
+public:
+    void Echo(dRPC::RpcController &controller,
+              const ::EchoRequest &request,
+              ::EchoResponse &response,
+              ::google::protobuf::Closure *done);
+
+    void Echo1(dRPC::RpcController &controller,
+               const ::EchoRequest &request,
+               ::EchoResponse &response,
+               ::google::protobuf::Closure *done);
+};
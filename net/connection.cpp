@@ -1,6 +1,10 @@
 #include "connection.h"
 
 #include <sys/uio.h>
+#include <errno.h>
+
+#include "socket_utils.h"
+#include "util/clock.h"
 
 namespace dRPC::net
 {
@@ -42,6 +46,10 @@ namespace dRPC::net
         {
             resume_write();
         }
+        if (read > 0)
+        {
+            last_read_us_ = util::now_us();
+        }
         read_buf_.commit_resv(read);
         bool should_suspend = !closed() && read <= 0;
         return {this, should_suspend};
@@ -51,13 +59,17 @@ namespace dRPC::net
     {
         int need_write = to_write_bytes();
         int written = 0;
+        struct iovec iovs[MAX_IOVS];
         while (written < need_write)
         {
-            auto iovs = write_buf_.get_iovecs();
-            int n = ::writev(fd(), iovs.data(), iovs.size());
+            size_t iov_count = write_buf_.get_iovecs(iovs, MAX_IOVS);
+            int n = ::writev(fd(), iovs, iov_count);
             if (n >= 0)
             {
+                // 每次写入后立即提交，部分写入时下一轮从未发送处继续
                 written += n;
+                write_buf_.commit_send(n);
+                bytes_sent_ += n;
                 continue;
             }
             else
@@ -74,8 +86,47 @@ namespace dRPC::net
                 break;
             }
         }
-        write_buf_.commit_send(written);
         bool should_suspend = !closed() && written < need_write;
         return {this, should_suspend};
     }
-}
\ No newline at end of file
+
+    dRPC::ConnectAwaiter Connection::async_connect(const struct sockaddr *addr, socklen_t addrlen, int timeout_ms)
+    {
+        connect_error_ = 0;
+        if (SocketUtils::connect(fd(), addr, addrlen) < 0)
+        {
+            if (errno == EINPROGRESS)
+            {
+                connecting_ = true;
+            }
+            else
+            {
+                connect_error_ = errno;
+            }
+        }
+        return {this, timeout_ms};
+    }
+
+    void Connection::finish_connect()
+    {
+        int err = 0;
+        socklen_t len = sizeof(err);
+        if (::getsockopt(fd(), SOL_SOCKET, SO_ERROR, &err, &len) < 0)
+        {
+            err = errno;
+        }
+        connecting_ = false;
+        connect_error_ = err;
+    }
+
+    void Connection::reset(int sockfd)
+    {
+        socket_ = std::make_unique<Socket>(sockfd);
+        read_buf_.clear();
+        read_handle_ = nullptr;
+        write_handle_ = nullptr;
+        connect_handle_ = nullptr;
+        connecting_ = false;
+        connect_error_ = 0;
+    }
+}
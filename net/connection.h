@@ -26,6 +26,8 @@ namespace dRPC
 
             dRPC::ReadAwaiter async_read();
             dRPC::WriteAwaiter async_write();
+            // 非阻塞connect，timeout_ms<0表示不超时，co_await结果为0或errno
+            dRPC::ConnectAwaiter async_connect(const struct sockaddr *addr, socklen_t addrlen, int timeout_ms);
 
             Executor *executor() const { return executor_; }
 
@@ -36,19 +38,49 @@ namespace dRPC
 
             Socket *socket() const { return socket_.get(); }
 
-            // 设置read/write协程句柄
+            // 设置read/write/connect协程句柄
             void set_read_handle(void *handle) { read_handle_ = handle; }
             void set_write_handle(void *handle) { write_handle_ = handle; }
-
-            // 恢复read/write协程句柄
-            void resume_read() const { std::coroutine_handle<>::from_address(read_handle_).resume(); }
-            void resume_write() const { std::coroutine_handle<>::from_address(write_handle_).resume(); }
+            void set_connect_handle(void *handle) { connect_handle_ = handle; }
+
+            // 恢复read/write/connect协程句柄
+            void resume_read() const { resume(read_handle_); }
+            void resume_write() const { resume(write_handle_); }
+            void resume_connect() const { resume(connect_handle_); }
+
+            // 连接状态
+            bool connecting() const { return connecting_; }
+            int connect_error() const { return connect_error_; }
+            // 连接完成，读取SO_ERROR
+            void finish_connect();
+            // 连接失败(如超时)
+            void fail_connect(int err)
+            {
+                connecting_ = false;
+                connect_error_ = err;
+            }
 
             size_t to_write_bytes() const
             {
                 return write_buf_.size();
             }
 
+            // 连接对象创建以来写入socket的总字节数，与to_write_bytes()一起确定帧在发送流中的位置
+            uint64_t bytes_sent() const { return bytes_sent_; }
+
+            // 丢弃发送缓冲区头部len字节，计入已发送字节数
+            void discard_write(size_t len)
+            {
+                write_buf_.commit_send(len);
+                bytes_sent_ += len;
+            }
+
+            // 断线重连：换用新socket，清空接收缓冲区和协程句柄，保留未发送的数据
+            void reset(int sockfd);
+
+            // 最近一次从socket读到数据的时间(单调时钟，微秒)
+            int64_t last_read_us() const { return last_read_us_; }
+
             size_t to_read_bytes() const
             {
                 return read_buf_.size();
@@ -65,13 +97,28 @@ namespace dRPC
             }
 
         private:
+            static void resume(void *handle)
+            {
+                if (handle)
+                {
+                    std::coroutine_handle<>::from_address(handle).resume();
+                }
+            }
+
+            static constexpr size_t MAX_IOVS = 64;
+
             Executor *executor_;
 
             bool is_dummy_;
             util::ChainedBuffer<> read_buf_;
             util::ChainedBuffer<> write_buf_;
-            void *read_handle_;
-            void *write_handle_;
+            void *read_handle_ = nullptr;
+            void *write_handle_ = nullptr;
+            void *connect_handle_ = nullptr;
+            bool connecting_ = false;
+            int connect_error_ = 0;
+            int64_t last_read_us_ = 0;
+            uint64_t bytes_sent_ = 0;
             std::unique_ptr<Socket> socket_;
 
             Connection(const Connection &) = delete;
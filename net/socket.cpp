@@ -6,22 +6,33 @@
 namespace dRPC::net
 {
     Socket::Socket(int sockfd) : sockfd_(sockfd), closed_(false)
+    {
+        load_addr();
+    }
+
+    bool Socket::load_addr()
     {
         // 获取本地地址
         struct sockaddr_in addr;
         socklen_t addrlen = sizeof(addr);
-        ::getsockname(sockfd, (struct sockaddr *)&addr, &addrlen);
-        local_addr_ = SocketUtils::inet_ntoa(addr.sin_addr);
-        local_port_ = ::ntohs(addr.sin_port);
+        if (::getsockname(sockfd_, (struct sockaddr *)&addr, &addrlen) == 0)
+        {
+            local_addr_ = SocketUtils::inet_ntoa(addr.sin_addr);
+            local_port_ = ::ntohs(addr.sin_port);
+        }
 
-        // 获取对端地址
+        // 获取对端地址，非阻塞connect未完成时失败
         struct sockaddr_in peer_addr;
         socklen_t peer_addrlen = sizeof(peer_addr);
-        ::getpeername(sockfd, (struct sockaddr *)&peer_addr, &peer_addrlen);
+        if (::getpeername(sockfd_, (struct sockaddr *)&peer_addr, &peer_addrlen) != 0)
+        {
+            return false;
+        }
         peer_addr_ = SocketUtils::inet_ntoa(peer_addr.sin_addr);
         peer_port_ = ::ntohs(peer_addr.sin_port);
 
         info("conn [{}]: local: {}:{} <-> peer: {}:{}", sockfd_, local_addr_, local_port_, peer_addr_, peer_port_);
+        return true;
     }
 
     Socket::~Socket()
@@ -30,13 +30,16 @@ namespace dRPC::net
 
         bool closed() const { return closed_; }
 
+        // 获取本地/对端地址，对端未连接时返回false
+        bool load_addr();
+
     private:
         int sockfd_;
 
         std::string local_addr_; // 本地地址
-        int local_port_;         // 本地端口
+        int local_port_ = 0;     // 本地端口
         std::string peer_addr_;  // 对端地址
-        int peer_port_;          // 对端端口
+        int peer_port_ = 0;      // 对端端口
 
         bool closed_; // 关闭标识
     };
@@ -65,12 +65,13 @@ namespace dRPC::net
 
     int SocketUtils::connect(int sockfd, const struct sockaddr *addr, socklen_t addrlen)
     {
+        // 非阻塞socket返回EINPROGRESS，由调用方等待可写后检查SO_ERROR
         int ret = ::connect(sockfd, addr, addrlen);
-        if (ret < 0)
+        if (ret < 0 && errno != EINPROGRESS)
         {
-            error("connect failed: {}", strerror(errno));
-            ::close(sockfd);
-            ::exit(EXIT_FAILURE);
+            int err = errno;
+            error("connect failed: {}", strerror(err));
+            errno = err;
         }
         return ret;
     }
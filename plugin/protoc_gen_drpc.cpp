@@ -0,0 +1,365 @@
+// protoc插件：为service生成按方法ID分发的服务基类和协程客户端stub
+//
+//   protoc --plugin=protoc-gen-drpc=<build>/protoc-gen-drpc --drpc_out=. echo.proto
+//
+// 输出<name>.drpc.h，需与protoc生成的<name>.pb.h放在同一目录。
+// 插件协议(CodeGeneratorRequest/Response)直接按wire格式编解码，只依赖libprotobuf，不需要libprotoc。
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/descriptor.pb.h>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/printer.h>
+#include <google/protobuf/io/zero_copy_stream_impl.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+#include <google/protobuf/wire_format_lite.h>
+
+using google::protobuf::Descriptor;
+using google::protobuf::DescriptorPool;
+using google::protobuf::FileDescriptor;
+using google::protobuf::FileDescriptorProto;
+using google::protobuf::MethodDescriptor;
+using google::protobuf::ServiceDescriptor;
+using google::protobuf::io::CodedInputStream;
+using google::protobuf::io::CodedOutputStream;
+using google::protobuf::io::Printer;
+using google::protobuf::io::StringOutputStream;
+using google::protobuf::internal::WireFormatLite;
+
+namespace
+{
+    // google/protobuf/compiler/plugin.proto中的字段号
+    constexpr int REQUEST_FILE_TO_GENERATE = 1;
+    constexpr int REQUEST_PROTO_FILE = 15;
+    constexpr int RESPONSE_ERROR = 1;
+    constexpr int RESPONSE_SUPPORTED_FEATURES = 2;
+    constexpr int RESPONSE_FILE = 15;
+    constexpr int FILE_NAME = 1;
+    constexpr int FILE_CONTENT = 15;
+    constexpr uint64_t FEATURE_PROTO3_OPTIONAL = 1;
+
+    struct GeneratorRequest
+    {
+        std::vector<std::string> files_to_generate;
+        std::vector<FileDescriptorProto> proto_files;
+    };
+
+    bool parse_request(const std::string &data, GeneratorRequest &request)
+    {
+        CodedInputStream input(reinterpret_cast<const uint8_t *>(data.data()), data.size());
+        while (uint32_t tag = input.ReadTag())
+        {
+            int field = WireFormatLite::GetTagFieldNumber(tag);
+            if (field == REQUEST_FILE_TO_GENERATE)
+            {
+                std::string name;
+                if (!WireFormatLite::ReadString(&input, &name))
+                {
+                    return false;
+                }
+                request.files_to_generate.push_back(std::move(name));
+            }
+            else if (field == REQUEST_PROTO_FILE)
+            {
+                std::string bytes;
+                if (!WireFormatLite::ReadBytes(&input, &bytes) ||
+                    !request.proto_files.emplace_back().ParseFromString(bytes))
+                {
+                    return false;
+                }
+            }
+            else if (!WireFormatLite::SkipField(&input, tag))
+            {
+                return false;
+            }
+        }
+        return input.ConsumedEntireMessage();
+    }
+
+    std::string strip_proto(const std::string &name)
+    {
+        if (name.size() > 6 && name.compare(name.size() - 6, 6, ".proto") == 0)
+        {
+            return name.substr(0, name.size() - 6);
+        }
+        return name;
+    }
+
+    std::string base_name(const std::string &path)
+    {
+        auto pos = path.rfind('/');
+        return pos == std::string::npos ? path : path.substr(pos + 1);
+    }
+
+    std::string replace_all(std::string str, const std::string &from, const std::string &to)
+    {
+        for (size_t pos = 0; (pos = str.find(from, pos)) != std::string::npos; pos += to.size())
+        {
+            str.replace(pos, from.size(), to);
+        }
+        return str;
+    }
+
+    // 与protoc的C++生成器一致：package映射为命名空间，嵌套消息用'_'连接
+    std::string class_name(const Descriptor *descriptor)
+    {
+        std::string name = descriptor->full_name();
+        const std::string &package = descriptor->file()->package();
+        if (!package.empty())
+        {
+            name = name.substr(package.size() + 1);
+        }
+        std::string result = "::" + replace_all(package, ".", "::");
+        if (!package.empty())
+        {
+            result += "::";
+        }
+        return result + replace_all(name, ".", "_");
+    }
+
+    bool check_service(const ServiceDescriptor *service, std::string &err)
+    {
+        for (int i = 0; i < service->method_count(); ++i)
+        {
+            auto method = service->method(i);
+            if (method->client_streaming() || method->server_streaming())
+            {
+                err = method->full_name() + ": streaming methods are not supported";
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void generate_service(Printer &printer, const ServiceDescriptor *service)
+    {
+        printer.Print("// $service$的方法ID，同一服务内ID冲突时call_method中的case重复导致编译失败\n"
+                      "struct $name$MethodId\n"
+                      "{\n",
+                      "service", service->full_name(), "name", service->name());
+        printer.Indent();
+        printer.Indent();
+        for (int i = 0; i < service->method_count(); ++i)
+        {
+            auto method = service->method(i);
+            printer.Print("static constexpr uint32_t $method$ = dRPC::method_id(\"$full_name$\");\n",
+                          "method", method->name(), "full_name", method->full_name());
+        }
+        printer.Outdent();
+        printer.Outdent();
+        printer.Print("};\n\n");
+
+        // 服务端基类：CRTP直接调用派生类的handler，无虚函数和描述符查找
+        printer.Print("// 服务端基类，Derived需实现每个方法：\n"
+                      "//   void/dRPC::Task Method(dRPC::RpcController &controller, const Request &request,\n"
+                      "//                          Response &response, google::protobuf::Closure *done);\n"
+                      "// handler可以是协程，处理完成后调用done->Run()\n"
+                      "template <typename Derived>\n"
+                      "class $name$Base : public dRPC::GeneratedService\n"
+                      "{\n"
+                      "public:\n",
+                      "name", service->name());
+        printer.Indent();
+        printer.Indent();
+        printer.Print("std::string_view service_name() const override { return \"$full_name$\"; }\n\n"
+                      "std::span<const dRPC::MethodInfo> methods() const override\n"
+                      "{\n"
+                      "    static const dRPC::MethodInfo infos[] = {\n",
+                      "full_name", service->full_name());
+        for (int i = 0; i < service->method_count(); ++i)
+        {
+            auto method = service->method(i);
+            printer.Print("        {$name$MethodId::$method$, \"$full_name$\", &$request$::default_instance(), &$response$::default_instance()},\n",
+                          "name", service->name(), "method", method->name(), "full_name", method->full_name(),
+                          "request", class_name(method->input_type()), "response", class_name(method->output_type()));
+        }
+        printer.Print("    };\n"
+                      "    return infos;\n"
+                      "}\n\n"
+                      "void call_method(uint32_t method_id,\n"
+                      "                 dRPC::RpcController *controller,\n"
+                      "                 const google::protobuf::Message *request,\n"
+                      "                 google::protobuf::Message *response,\n"
+                      "                 google::protobuf::Closure *done) override\n"
+                      "{\n"
+                      "    auto self = static_cast<Derived *>(this);\n"
+                      "    switch (method_id)\n"
+                      "    {\n");
+        for (int i = 0; i < service->method_count(); ++i)
+        {
+            auto method = service->method(i);
+            printer.Print("    case $name$MethodId::$method$:\n"
+                          "        self->$method$(*controller, static_cast<const $request$ &>(*request), static_cast<$response$ &>(*response), done);\n"
+                          "        break;\n",
+                          "name", service->name(), "method", method->name(),
+                          "request", class_name(method->input_type()), "response", class_name(method->output_type()));
+        }
+        printer.Print("    default:\n"
+                      "        controller->SetFailed(\"method not found\");\n"
+                      "        done->Run();\n"
+                      "        break;\n"
+                      "    }\n"
+                      "}\n");
+        printer.Outdent();
+        printer.Outdent();
+        printer.Print("};\n\n");
+
+        // 客户端stub：请求按方法ID发送，co_await返回dRPC::CallResult<Response>
+        printer.Print("// 客户端stub：auto result = co_await client.Method(request);\n"
+                      "class $name$Client\n"
+                      "{\n"
+                      "public:\n"
+                      "    explicit $name$Client(dRPC::ClientChannel *channel) : channel_(channel) {}\n\n",
+                      "name", service->name());
+        printer.Indent();
+        printer.Indent();
+        for (int i = 0; i < service->method_count(); ++i)
+        {
+            auto method = service->method(i);
+            printer.Print("dRPC::ClientChannel::CallAwaiter<$response$> $method$(const $request$ &request, dRPC::RpcController *controller = nullptr)\n"
+                          "{\n"
+                          "    return channel_->call<$response$>($name$MethodId::$method$, request, controller);\n"
+                          "}\n\n",
+                          "name", service->name(), "method", method->name(),
+                          "request", class_name(method->input_type()), "response", class_name(method->output_type()));
+        }
+        printer.Outdent();
+        printer.Outdent();
+        printer.Print("private:\n"
+                      "    dRPC::ClientChannel *channel_;\n"
+                      "};\n");
+    }
+
+    bool generate_file(const FileDescriptor *file, std::string &content, std::string &err)
+    {
+        for (int i = 0; i < file->service_count(); ++i)
+        {
+            if (!check_service(file->service(i), err))
+            {
+                return false;
+            }
+        }
+
+        StringOutputStream output(&content);
+        Printer printer(&output, '$');
+        printer.Print("// Generated by protoc-gen-drpc. DO NOT EDIT!\n"
+                      "// source: $file$\n\n"
+                      "#pragma once\n\n"
+                      "#include <cstdint>\n"
+                      "#include <span>\n"
+                      "#include <string_view>\n\n"
+                      "#include \"$pb_header$\"\n"
+                      "#include \"util/generated_service.h\"\n"
+                      "#include \"client/client_channel.h\"\n",
+                      "file", file->name(), "pb_header", base_name(strip_proto(file->name())) + ".pb.h");
+
+        std::vector<std::string> namespaces;
+        for (size_t begin = 0; !file->package().empty();)
+        {
+            auto end = file->package().find('.', begin);
+            namespaces.push_back(file->package().substr(begin, end - begin));
+            if (end == std::string::npos)
+            {
+                break;
+            }
+            begin = end + 1;
+        }
+        for (auto &ns : namespaces)
+        {
+            printer.Print("\nnamespace $ns$\n{", "ns", ns);
+        }
+        for (int i = 0; i < file->service_count(); ++i)
+        {
+            printer.Print("\n");
+            generate_service(printer, file->service(i));
+        }
+        for (auto iter = namespaces.rbegin(); iter != namespaces.rend(); ++iter)
+        {
+            printer.Print("} // namespace $ns$\n", "ns", *iter);
+        }
+        return !printer.failed();
+    }
+
+    std::string serialize_response(const std::vector<std::pair<std::string, std::string>> &files, const std::string &err)
+    {
+        std::string data;
+        {
+            StringOutputStream stream(&data);
+            CodedOutputStream output(&stream);
+            if (!err.empty())
+            {
+                WireFormatLite::WriteString(RESPONSE_ERROR, err, &output);
+            }
+            WireFormatLite::WriteUInt64(RESPONSE_SUPPORTED_FEATURES, FEATURE_PROTO3_OPTIONAL, &output);
+            for (auto &[name, content] : files)
+            {
+                std::string file;
+                {
+                    StringOutputStream file_stream(&file);
+                    CodedOutputStream file_output(&file_stream);
+                    WireFormatLite::WriteString(FILE_NAME, name, &file_output);
+                    WireFormatLite::WriteString(FILE_CONTENT, content, &file_output);
+                }
+                WireFormatLite::WriteBytes(RESPONSE_FILE, file, &output);
+            }
+        }
+        return data;
+    }
+}
+
+int main()
+{
+    std::string input((std::istreambuf_iterator<char>(std::cin)), std::istreambuf_iterator<char>());
+
+    GeneratorRequest request;
+    if (!parse_request(input, request))
+    {
+        std::cerr << "protoc-gen-drpc: failed to parse CodeGeneratorRequest" << std::endl;
+        return 1;
+    }
+
+    // 依赖文件按拓扑序排在前面，依次加入描述符池
+    DescriptorPool pool;
+    for (auto &proto : request.proto_files)
+    {
+        if (pool.BuildFile(proto) == nullptr)
+        {
+            std::cerr << "protoc-gen-drpc: failed to build " << proto.name() << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<std::pair<std::string, std::string>> files;
+    std::string err;
+    for (auto &name : request.files_to_generate)
+    {
+        auto file = pool.FindFileByName(name);
+        if (file == nullptr)
+        {
+            err = name + ": file not found in request";
+            break;
+        }
+        if (file->service_count() == 0)
+        {
+            continue;
+        }
+        std::string content;
+        if (!generate_file(file, content, err))
+        {
+            break;
+        }
+        files.emplace_back(strip_proto(name) + ".drpc.h", std::move(content));
+    }
+    if (!err.empty())
+    {
+        files.clear();
+    }
+
+    std::string output = serialize_response(files, err);
+    std::cout.write(output.data(), output.size());
+    std::cout.flush();
+    return std::cout.good() ? 0 : 1;
+}
@@ -28,10 +28,16 @@ PROTOBUF_CONSTEXPR Header::Header(
   , /*decltype(_impl_._cached_size_)*/{}
   , /*decltype(_impl_.service_name_)*/{&::_pbi::fixed_address_empty_string, ::_pbi::ConstantInitialized{}}
   , /*decltype(_impl_.method_name_)*/{&::_pbi::fixed_address_empty_string, ::_pbi::ConstantInitialized{}}
+  , /*decltype(_impl_.error_text_)*/{&::_pbi::fixed_address_empty_string, ::_pbi::ConstantInitialized{}}
   , /*decltype(_impl_.magic_)*/uint64_t{0u}
   , /*decltype(_impl_.version_)*/0
   , /*decltype(_impl_.message_type_)*/0
-  , /*decltype(_impl_.request_id_)*/int64_t{0}} {}
+  , /*decltype(_impl_.request_id_)*/int64_t{0}
+  , /*decltype(_impl_.timeout_ms_)*/int64_t{0}
+  , /*decltype(_impl_.method_id_)*/0u
+  , /*decltype(_impl_.error_code_)*/0
+  , /*decltype(_impl_.trace_id_)*/uint64_t{0u}
+  , /*decltype(_impl_.span_id_)*/uint64_t{0u}} {}
 struct HeaderDefaultTypeInternal {
   PROTOBUF_CONSTEXPR HeaderDefaultTypeInternal()
       : _instance(::_pbi::ConstantInitialized{}) {}
@@ -60,15 +66,27 @@ const uint32_t TableStruct_message_2eproto::offsets[] PROTOBUF_SECTION_VARIABLE(
   PROTOBUF_FIELD_OFFSET(::dRPC::proto::Header, _impl_.request_id_),
   PROTOBUF_FIELD_OFFSET(::dRPC::proto::Header, _impl_.service_name_),
   PROTOBUF_FIELD_OFFSET(::dRPC::proto::Header, _impl_.method_name_),
+  PROTOBUF_FIELD_OFFSET(::dRPC::proto::Header, _impl_.timeout_ms_),
+  PROTOBUF_FIELD_OFFSET(::dRPC::proto::Header, _impl_.method_id_),
+  PROTOBUF_FIELD_OFFSET(::dRPC::proto::Header, _impl_.error_code_),
+  PROTOBUF_FIELD_OFFSET(::dRPC::proto::Header, _impl_.error_text_),
+  PROTOBUF_FIELD_OFFSET(::dRPC::proto::Header, _impl_.trace_id_),
+  PROTOBUF_FIELD_OFFSET(::dRPC::proto::Header, _impl_.span_id_),
   ~0u,
   ~0u,
   ~0u,
   ~0u,
   0,
   1,
+  3,
+  4,
+  5,
+  2,
+  6,
+  7,
 };
 static const ::_pbi::MigrationSchema schemas[] PROTOBUF_SECTION_VARIABLE(protodesc_cold) = {
-  { 0, 12, -1, sizeof(::dRPC::proto::Header)},
+  { 0, 18, -1, sizeof(::dRPC::proto::Header)},
 };
 
 static const ::_pb::Message* const file_default_instances[] = {
@@ -76,18 +94,24 @@ static const ::_pb::Message* const file_default_instances[] = {
 };
 
 const char descriptor_table_protodef_message_2eproto[] PROTOBUF_SECTION_VARIABLE(protodesc_cold) =
-  "\n\rmessage.proto\022\ndRPC.proto\"\301\001\n\006Header\022\r"
+  "\n\rmessage.proto\022\ndRPC.proto\"\245\003\n\006Header\022\r"
   "\n\005magic\030\001 \001(\004\022\017\n\007version\030\002 \001(\005\022-\n\014messag"
   "e_type\030\003 \001(\0162\027.dRPC.proto.MessageType\022\022\n"
   "\nrequest_id\030\004 \001(\003\022\031\n\014service_name\030\005 \001(\tH"
-  "\000\210\001\001\022\030\n\013method_name\030\006 \001(\tH\001\210\001\001B\017\n\r_servi"
-  "ce_nameB\016\n\014_method_name*F\n\013MessageType\022\034"
-  "\n\030MESSAGE_TYPE_UNSPECIFIED\020\000\022\013\n\007REQUEST\020"
-  "\001\022\014\n\010RESPONSE\020\002b\006proto3"
+  "\000\210\001\001\022\030\n\013method_name\030\006 \001(\tH\001\210\001\001\022\027\n\ntimeou"
+  "t_ms\030\007 \001(\003H\002\210\001\001\022\026\n\tmethod_id\030\010 \001(\007H\003\210\001\001\022"
+  "\027\n\nerror_code\030\t \001(\005H\004\210\001\001\022\027\n\nerror_text\030\n"
+  " \001(\tH\005\210\001\001\022\025\n\010trace_id\030\013 \001(\006H\006\210\001\001\022\024\n\007span"
+  "_id\030\014 \001(\006H\007\210\001\001B\017\n\r_service_nameB\016\n\014_meth"
+  "od_nameB\r\n\013_timeout_msB\014\n\n_method_idB\r\n\013"
+  "_error_codeB\r\n\013_error_textB\013\n\t_trace_idB"
+  "\n\n\010_span_id*R\n\013MessageType\022\034\n\030MESSAGE_TY"
+  "PE_UNSPECIFIED\020\000\022\013\n\007REQUEST\020\001\022\014\n\010RESPONS"
+  "E\020\002\022\n\n\006CANCEL\020\003b\006proto3"
   ;
 static ::_pbi::once_flag descriptor_table_message_2eproto_once;
 const ::_pbi::DescriptorTable descriptor_table_message_2eproto = {
-    false, false, 303, descriptor_table_protodef_message_2eproto,
+    false, false, 543, descriptor_table_protodef_message_2eproto,
     "message.proto",
     &descriptor_table_message_2eproto_once, nullptr, 0, 1,
     schemas, file_default_instances, TableStruct_message_2eproto::offsets,
@@ -111,6 +135,7 @@ bool MessageType_IsValid(int value) {
     case 0:
     case 1:
     case 2:
+    case 3:
       return true;
     default:
       return false;
@@ -129,6 +154,24 @@ class Header::_Internal {
   static void set_has_method_name(HasBits* has_bits) {
     (*has_bits)[0] |= 2u;
   }
+  static void set_has_timeout_ms(HasBits* has_bits) {
+    (*has_bits)[0] |= 8u;
+  }
+  static void set_has_method_id(HasBits* has_bits) {
+    (*has_bits)[0] |= 16u;
+  }
+  static void set_has_error_code(HasBits* has_bits) {
+    (*has_bits)[0] |= 32u;
+  }
+  static void set_has_error_text(HasBits* has_bits) {
+    (*has_bits)[0] |= 4u;
+  }
+  static void set_has_trace_id(HasBits* has_bits) {
+    (*has_bits)[0] |= 64u;
+  }
+  static void set_has_span_id(HasBits* has_bits) {
+    (*has_bits)[0] |= 128u;
+  }
 };
 
 Header::Header(::PROTOBUF_NAMESPACE_ID::Arena* arena,
@@ -145,10 +188,16 @@ Header::Header(const Header& from)
     , /*decltype(_impl_._cached_size_)*/{}
     , decltype(_impl_.service_name_){}
     , decltype(_impl_.method_name_){}
+    , decltype(_impl_.error_text_){}
     , decltype(_impl_.magic_){}
     , decltype(_impl_.version_){}
     , decltype(_impl_.message_type_){}
-    , decltype(_impl_.request_id_){}};
+    , decltype(_impl_.request_id_){}
+    , decltype(_impl_.timeout_ms_){}
+    , decltype(_impl_.method_id_){}
+    , decltype(_impl_.error_code_){}
+    , decltype(_impl_.trace_id_){}
+    , decltype(_impl_.span_id_){}};
 
   _internal_metadata_.MergeFrom<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(from._internal_metadata_);
   _impl_.service_name_.InitDefault();
@@ -167,9 +216,17 @@ Header::Header(const Header& from)
     _this->_impl_.method_name_.Set(from._internal_method_name(), 
       _this->GetArenaForAllocation());
   }
+  _impl_.error_text_.InitDefault();
+  #ifdef PROTOBUF_FORCE_COPY_DEFAULT_STRING
+    _impl_.error_text_.Set("", GetArenaForAllocation());
+  #endif // PROTOBUF_FORCE_COPY_DEFAULT_STRING
+  if (from._internal_has_error_text()) {
+    _this->_impl_.error_text_.Set(from._internal_error_text(), 
+      _this->GetArenaForAllocation());
+  }
   ::memcpy(&_impl_.magic_, &from._impl_.magic_,
-    static_cast<size_t>(reinterpret_cast<char*>(&_impl_.request_id_) -
-    reinterpret_cast<char*>(&_impl_.magic_)) + sizeof(_impl_.request_id_));
+    static_cast<size_t>(reinterpret_cast<char*>(&_impl_.span_id_) -
+    reinterpret_cast<char*>(&_impl_.magic_)) + sizeof(_impl_.span_id_));
   // @@protoc_insertion_point(copy_constructor:dRPC.proto.Header)
 }
 
@@ -182,10 +239,16 @@ inline void Header::SharedCtor(
     , /*decltype(_impl_._cached_size_)*/{}
     , decltype(_impl_.service_name_){}
     , decltype(_impl_.method_name_){}
+    , decltype(_impl_.error_text_){}
     , decltype(_impl_.magic_){uint64_t{0u}}
     , decltype(_impl_.version_){0}
     , decltype(_impl_.message_type_){0}
     , decltype(_impl_.request_id_){int64_t{0}}
+    , decltype(_impl_.timeout_ms_){int64_t{0}}
+    , decltype(_impl_.method_id_){0u}
+    , decltype(_impl_.error_code_){0}
+    , decltype(_impl_.trace_id_){uint64_t{0u}}
+    , decltype(_impl_.span_id_){uint64_t{0u}}
   };
   _impl_.service_name_.InitDefault();
   #ifdef PROTOBUF_FORCE_COPY_DEFAULT_STRING
@@ -195,6 +258,10 @@ inline void Header::SharedCtor(
   #ifdef PROTOBUF_FORCE_COPY_DEFAULT_STRING
     _impl_.method_name_.Set("", GetArenaForAllocation());
   #endif // PROTOBUF_FORCE_COPY_DEFAULT_STRING
+  _impl_.error_text_.InitDefault();
+  #ifdef PROTOBUF_FORCE_COPY_DEFAULT_STRING
+    _impl_.error_text_.Set("", GetArenaForAllocation());
+  #endif // PROTOBUF_FORCE_COPY_DEFAULT_STRING
 }
 
 Header::~Header() {
@@ -210,6 +277,7 @@ inline void Header::SharedDtor() {
   GOOGLE_DCHECK(GetArenaForAllocation() == nullptr);
   _impl_.service_name_.Destroy();
   _impl_.method_name_.Destroy();
+  _impl_.error_text_.Destroy();
 }
 
 void Header::SetCachedSize(int size) const {
@@ -223,17 +291,25 @@ void Header::Clear() {
   (void) cached_has_bits;
 
   cached_has_bits = _impl_._has_bits_[0];
-  if (cached_has_bits & 0x00000003u) {
+  if (cached_has_bits & 0x00000007u) {
     if (cached_has_bits & 0x00000001u) {
       _impl_.service_name_.ClearNonDefaultToEmpty();
     }
     if (cached_has_bits & 0x00000002u) {
       _impl_.method_name_.ClearNonDefaultToEmpty();
     }
+    if (cached_has_bits & 0x00000004u) {
+      _impl_.error_text_.ClearNonDefaultToEmpty();
+    }
   }
   ::memset(&_impl_.magic_, 0, static_cast<size_t>(
       reinterpret_cast<char*>(&_impl_.request_id_) -
       reinterpret_cast<char*>(&_impl_.magic_)) + sizeof(_impl_.request_id_));
+  if (cached_has_bits & 0x000000f8u) {
+    ::memset(&_impl_.timeout_ms_, 0, static_cast<size_t>(
+        reinterpret_cast<char*>(&_impl_.span_id_) -
+        reinterpret_cast<char*>(&_impl_.timeout_ms_)) + sizeof(_impl_.span_id_));
+  }
   _impl_._has_bits_.Clear();
   _internal_metadata_.Clear<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>();
 }
@@ -298,6 +374,61 @@ const char* Header::_InternalParse(const char* ptr, ::_pbi::ParseContext* ctx) {
         } else
           goto handle_unusual;
         continue;
+      // optional int64 timeout_ms = 7;
+      case 7:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 56)) {
+          _Internal::set_has_timeout_ms(&has_bits);
+          _impl_.timeout_ms_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint64(&ptr);
+          CHK_(ptr);
+        } else
+          goto handle_unusual;
+        continue;
+      // optional fixed32 method_id = 8;
+      case 8:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 69)) {
+          _Internal::set_has_method_id(&has_bits);
+          _impl_.method_id_ = ::PROTOBUF_NAMESPACE_ID::internal::UnalignedLoad<uint32_t>(ptr);
+          ptr += sizeof(uint32_t);
+        } else
+          goto handle_unusual;
+        continue;
+      // optional int32 error_code = 9;
+      case 9:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 72)) {
+          _Internal::set_has_error_code(&has_bits);
+          _impl_.error_code_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint32(&ptr);
+          CHK_(ptr);
+        } else
+          goto handle_unusual;
+        continue;
+      // optional string error_text = 10;
+      case 10:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 82)) {
+          auto str = _internal_mutable_error_text();
+          ptr = ::_pbi::InlineGreedyStringParser(str, ptr, ctx);
+          CHK_(ptr);
+          CHK_(::_pbi::VerifyUTF8(str, "dRPC.proto.Header.error_text"));
+        } else
+          goto handle_unusual;
+        continue;
+      // optional fixed64 trace_id = 11;
+      case 11:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 89)) {
+          _Internal::set_has_trace_id(&has_bits);
+          _impl_.trace_id_ = ::PROTOBUF_NAMESPACE_ID::internal::UnalignedLoad<uint64_t>(ptr);
+          ptr += sizeof(uint64_t);
+        } else
+          goto handle_unusual;
+        continue;
+      // optional fixed64 span_id = 12;
+      case 12:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 97)) {
+          _Internal::set_has_span_id(&has_bits);
+          _impl_.span_id_ = ::PROTOBUF_NAMESPACE_ID::internal::UnalignedLoad<uint64_t>(ptr);
+          ptr += sizeof(uint64_t);
+        } else
+          goto handle_unusual;
+        continue;
       default:
         goto handle_unusual;
     }  // switch
@@ -373,6 +504,46 @@ uint8_t* Header::_InternalSerialize(
         6, this->_internal_method_name(), target);
   }
 
+  // optional int64 timeout_ms = 7;
+  if (_internal_has_timeout_ms()) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteInt64ToArray(7, this->_internal_timeout_ms(), target);
+  }
+
+  // optional fixed32 method_id = 8;
+  if (_internal_has_method_id()) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteFixed32ToArray(8, this->_internal_method_id(), target);
+  }
+
+  // optional int32 error_code = 9;
+  if (_internal_has_error_code()) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteInt32ToArray(9, this->_internal_error_code(), target);
+  }
+
+  // optional string error_text = 10;
+  if (_internal_has_error_text()) {
+    ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::VerifyUtf8String(
+      this->_internal_error_text().data(), static_cast<int>(this->_internal_error_text().length()),
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::SERIALIZE,
+      "dRPC.proto.Header.error_text");
+    target = stream->WriteStringMaybeAliased(
+        10, this->_internal_error_text(), target);
+  }
+
+  // optional fixed64 trace_id = 11;
+  if (_internal_has_trace_id()) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteFixed64ToArray(11, this->_internal_trace_id(), target);
+  }
+
+  // optional fixed64 span_id = 12;
+  if (_internal_has_span_id()) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteFixed64ToArray(12, this->_internal_span_id(), target);
+  }
+
   if (PROTOBUF_PREDICT_FALSE(_internal_metadata_.have_unknown_fields())) {
     target = ::_pbi::WireFormat::InternalSerializeUnknownFieldsToArray(
         _internal_metadata_.unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(::PROTOBUF_NAMESPACE_ID::UnknownFieldSet::default_instance), target, stream);
@@ -390,7 +561,7 @@ size_t Header::ByteSizeLong() const {
   (void) cached_has_bits;
 
   cached_has_bits = _impl_._has_bits_[0];
-  if (cached_has_bits & 0x00000003u) {
+  if (cached_has_bits & 0x00000007u) {
     // optional string service_name = 5;
     if (cached_has_bits & 0x00000001u) {
       total_size += 1 +
@@ -405,6 +576,13 @@ size_t Header::ByteSizeLong() const {
           this->_internal_method_name());
     }
 
+    // optional string error_text = 10;
+    if (cached_has_bits & 0x00000004u) {
+      total_size += 1 +
+        ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::StringSize(
+          this->_internal_error_text());
+    }
+
   }
   // uint64 magic = 1;
   if (this->_internal_magic() != 0) {
@@ -427,6 +605,33 @@ size_t Header::ByteSizeLong() const {
     total_size += ::_pbi::WireFormatLite::Int64SizePlusOne(this->_internal_request_id());
   }
 
+  if (cached_has_bits & 0x000000f8u) {
+    // optional int64 timeout_ms = 7;
+    if (cached_has_bits & 0x00000008u) {
+      total_size += ::_pbi::WireFormatLite::Int64SizePlusOne(this->_internal_timeout_ms());
+    }
+
+    // optional fixed32 method_id = 8;
+    if (cached_has_bits & 0x00000010u) {
+      total_size += 1 + 4;
+    }
+
+    // optional int32 error_code = 9;
+    if (cached_has_bits & 0x00000020u) {
+      total_size += ::_pbi::WireFormatLite::Int32SizePlusOne(this->_internal_error_code());
+    }
+
+    // optional fixed64 trace_id = 11;
+    if (cached_has_bits & 0x00000040u) {
+      total_size += 1 + 8;
+    }
+
+    // optional fixed64 span_id = 12;
+    if (cached_has_bits & 0x00000080u) {
+      total_size += 1 + 8;
+    }
+
+  }
   return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
 }
 
@@ -446,13 +651,16 @@ void Header::MergeImpl(::PROTOBUF_NAMESPACE_ID::Message& to_msg, const ::PROTOBU
   (void) cached_has_bits;
 
   cached_has_bits = from._impl_._has_bits_[0];
-  if (cached_has_bits & 0x00000003u) {
+  if (cached_has_bits & 0x00000007u) {
     if (cached_has_bits & 0x00000001u) {
       _this->_internal_set_service_name(from._internal_service_name());
     }
     if (cached_has_bits & 0x00000002u) {
       _this->_internal_set_method_name(from._internal_method_name());
     }
+    if (cached_has_bits & 0x00000004u) {
+      _this->_internal_set_error_text(from._internal_error_text());
+    }
   }
   if (from._internal_magic() != 0) {
     _this->_internal_set_magic(from._internal_magic());
@@ -466,6 +674,24 @@ void Header::MergeImpl(::PROTOBUF_NAMESPACE_ID::Message& to_msg, const ::PROTOBU
   if (from._internal_request_id() != 0) {
     _this->_internal_set_request_id(from._internal_request_id());
   }
+  if (cached_has_bits & 0x000000f8u) {
+    if (cached_has_bits & 0x00000008u) {
+      _this->_impl_.timeout_ms_ = from._impl_.timeout_ms_;
+    }
+    if (cached_has_bits & 0x00000010u) {
+      _this->_impl_.method_id_ = from._impl_.method_id_;
+    }
+    if (cached_has_bits & 0x00000020u) {
+      _this->_impl_.error_code_ = from._impl_.error_code_;
+    }
+    if (cached_has_bits & 0x00000040u) {
+      _this->_impl_.trace_id_ = from._impl_.trace_id_;
+    }
+    if (cached_has_bits & 0x00000080u) {
+      _this->_impl_.span_id_ = from._impl_.span_id_;
+    }
+    _this->_impl_._has_bits_[0] |= cached_has_bits;
+  }
   _this->_internal_metadata_.MergeFrom<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(from._internal_metadata_);
 }
 
@@ -494,9 +720,13 @@ void Header::InternalSwap(Header* other) {
       &_impl_.method_name_, lhs_arena,
       &other->_impl_.method_name_, rhs_arena
   );
+  ::PROTOBUF_NAMESPACE_ID::internal::ArenaStringPtr::InternalSwap(
+      &_impl_.error_text_, lhs_arena,
+      &other->_impl_.error_text_, rhs_arena
+  );
   ::PROTOBUF_NAMESPACE_ID::internal::memswap<
-      PROTOBUF_FIELD_OFFSET(Header, _impl_.request_id_)
-      + sizeof(Header::_impl_.request_id_)
+      PROTOBUF_FIELD_OFFSET(Header, _impl_.span_id_)
+      + sizeof(Header::_impl_.span_id_)
       - PROTOBUF_FIELD_OFFSET(Header, _impl_.magic_)>(
           reinterpret_cast<char*>(&_impl_.magic_),
           reinterpret_cast<char*>(&other->_impl_.magic_));
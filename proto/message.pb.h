@@ -62,12 +62,13 @@ enum MessageType : int {
   MESSAGE_TYPE_UNSPECIFIED = 0,
   REQUEST = 1,
   RESPONSE = 2,
+  CANCEL = 3,
   MessageType_INT_MIN_SENTINEL_DO_NOT_USE_ = std::numeric_limits<int32_t>::min(),
   MessageType_INT_MAX_SENTINEL_DO_NOT_USE_ = std::numeric_limits<int32_t>::max()
 };
 bool MessageType_IsValid(int value);
 constexpr MessageType MessageType_MIN = MESSAGE_TYPE_UNSPECIFIED;
-constexpr MessageType MessageType_MAX = RESPONSE;
+constexpr MessageType MessageType_MAX = CANCEL;
 constexpr int MessageType_ARRAYSIZE = MessageType_MAX + 1;
 
 const ::PROTOBUF_NAMESPACE_ID::EnumDescriptor* MessageType_descriptor();
@@ -209,10 +210,16 @@ class Header final :
   enum : int {
     kServiceNameFieldNumber = 5,
     kMethodNameFieldNumber = 6,
+    kErrorTextFieldNumber = 10,
     kMagicFieldNumber = 1,
     kVersionFieldNumber = 2,
     kMessageTypeFieldNumber = 3,
     kRequestIdFieldNumber = 4,
+    kTimeoutMsFieldNumber = 7,
+    kMethodIdFieldNumber = 8,
+    kErrorCodeFieldNumber = 9,
+    kTraceIdFieldNumber = 11,
+    kSpanIdFieldNumber = 12,
   };
   // optional string service_name = 5;
   bool has_service_name() const;
@@ -250,6 +257,24 @@ class Header final :
   std::string* _internal_mutable_method_name();
   public:
 
+  // optional string error_text = 10;
+  bool has_error_text() const;
+  private:
+  bool _internal_has_error_text() const;
+  public:
+  void clear_error_text();
+  const std::string& error_text() const;
+  template <typename ArgT0 = const std::string&, typename... ArgT>
+  void set_error_text(ArgT0&& arg0, ArgT... args);
+  std::string* mutable_error_text();
+  PROTOBUF_NODISCARD std::string* release_error_text();
+  void set_allocated_error_text(std::string* error_text);
+  private:
+  const std::string& _internal_error_text() const;
+  inline PROTOBUF_ALWAYS_INLINE void _internal_set_error_text(const std::string& value);
+  std::string* _internal_mutable_error_text();
+  public:
+
   // uint64 magic = 1;
   void clear_magic();
   uint64_t magic() const;
@@ -286,6 +311,71 @@ class Header final :
   void _internal_set_request_id(int64_t value);
   public:
 
+  // optional int64 timeout_ms = 7;
+  bool has_timeout_ms() const;
+  private:
+  bool _internal_has_timeout_ms() const;
+  public:
+  void clear_timeout_ms();
+  int64_t timeout_ms() const;
+  void set_timeout_ms(int64_t value);
+  private:
+  int64_t _internal_timeout_ms() const;
+  void _internal_set_timeout_ms(int64_t value);
+  public:
+
+  // optional fixed32 method_id = 8;
+  bool has_method_id() const;
+  private:
+  bool _internal_has_method_id() const;
+  public:
+  void clear_method_id();
+  uint32_t method_id() const;
+  void set_method_id(uint32_t value);
+  private:
+  uint32_t _internal_method_id() const;
+  void _internal_set_method_id(uint32_t value);
+  public:
+
+  // optional int32 error_code = 9;
+  bool has_error_code() const;
+  private:
+  bool _internal_has_error_code() const;
+  public:
+  void clear_error_code();
+  int32_t error_code() const;
+  void set_error_code(int32_t value);
+  private:
+  int32_t _internal_error_code() const;
+  void _internal_set_error_code(int32_t value);
+  public:
+
+  // optional fixed64 trace_id = 11;
+  bool has_trace_id() const;
+  private:
+  bool _internal_has_trace_id() const;
+  public:
+  void clear_trace_id();
+  uint64_t trace_id() const;
+  void set_trace_id(uint64_t value);
+  private:
+  uint64_t _internal_trace_id() const;
+  void _internal_set_trace_id(uint64_t value);
+  public:
+
+  // optional fixed64 span_id = 12;
+  bool has_span_id() const;
+  private:
+  bool _internal_has_span_id() const;
+  public:
+  void clear_span_id();
+  uint64_t span_id() const;
+  void set_span_id(uint64_t value);
+  private:
+  uint64_t _internal_span_id() const;
+  void _internal_set_span_id(uint64_t value);
+  public:
+
   // @@protoc_insertion_point(class_scope:dRPC.proto.Header)
  private:
   class _Internal;
@@ -298,10 +388,16 @@ class Header final :
     mutable ::PROTOBUF_NAMESPACE_ID::internal::CachedSize _cached_size_;
     ::PROTOBUF_NAMESPACE_ID::internal::ArenaStringPtr service_name_;
     ::PROTOBUF_NAMESPACE_ID::internal::ArenaStringPtr method_name_;
+    ::PROTOBUF_NAMESPACE_ID::internal::ArenaStringPtr error_text_;
     uint64_t magic_;
     int32_t version_;
     int message_type_;
     int64_t request_id_;
+    int64_t timeout_ms_;
+    uint32_t method_id_;
+    int32_t error_code_;
+    uint64_t trace_id_;
+    uint64_t span_id_;
   };
   union { Impl_ _impl_; };
   friend struct ::TableStruct_message_2eproto;
@@ -533,6 +629,214 @@ inline void Header::set_allocated_method_name(std::string* method_name) {
   // @@protoc_insertion_point(field_set_allocated:dRPC.proto.Header.method_name)
 }
 
+// optional int64 timeout_ms = 7;
+inline bool Header::_internal_has_timeout_ms() const {
+  bool value = (_impl_._has_bits_[0] & 0x00000008u) != 0;
+  return value;
+}
+inline bool Header::has_timeout_ms() const {
+  return _internal_has_timeout_ms();
+}
+inline void Header::clear_timeout_ms() {
+  _impl_.timeout_ms_ = int64_t{0};
+  _impl_._has_bits_[0] &= ~0x00000008u;
+}
+inline int64_t Header::_internal_timeout_ms() const {
+  return _impl_.timeout_ms_;
+}
+inline int64_t Header::timeout_ms() const {
+  // @@protoc_insertion_point(field_get:dRPC.proto.Header.timeout_ms)
+  return _internal_timeout_ms();
+}
+inline void Header::_internal_set_timeout_ms(int64_t value) {
+  _impl_._has_bits_[0] |= 0x00000008u;
+  _impl_.timeout_ms_ = value;
+}
+inline void Header::set_timeout_ms(int64_t value) {
+  _internal_set_timeout_ms(value);
+  // @@protoc_insertion_point(field_set:dRPC.proto.Header.timeout_ms)
+}
+
+// optional fixed32 method_id = 8;
+inline bool Header::_internal_has_method_id() const {
+  bool value = (_impl_._has_bits_[0] & 0x00000010u) != 0;
+  return value;
+}
+inline bool Header::has_method_id() const {
+  return _internal_has_method_id();
+}
+inline void Header::clear_method_id() {
+  _impl_.method_id_ = 0u;
+  _impl_._has_bits_[0] &= ~0x00000010u;
+}
+inline uint32_t Header::_internal_method_id() const {
+  return _impl_.method_id_;
+}
+inline uint32_t Header::method_id() const {
+  // @@protoc_insertion_point(field_get:dRPC.proto.Header.method_id)
+  return _internal_method_id();
+}
+inline void Header::_internal_set_method_id(uint32_t value) {
+  _impl_._has_bits_[0] |= 0x00000010u;
+  _impl_.method_id_ = value;
+}
+inline void Header::set_method_id(uint32_t value) {
+  _internal_set_method_id(value);
+  // @@protoc_insertion_point(field_set:dRPC.proto.Header.method_id)
+}
+
+// optional int32 error_code = 9;
+inline bool Header::_internal_has_error_code() const {
+  bool value = (_impl_._has_bits_[0] & 0x00000020u) != 0;
+  return value;
+}
+inline bool Header::has_error_code() const {
+  return _internal_has_error_code();
+}
+inline void Header::clear_error_code() {
+  _impl_.error_code_ = 0;
+  _impl_._has_bits_[0] &= ~0x00000020u;
+}
+inline int32_t Header::_internal_error_code() const {
+  return _impl_.error_code_;
+}
+inline int32_t Header::error_code() const {
+  // @@protoc_insertion_point(field_get:dRPC.proto.Header.error_code)
+  return _internal_error_code();
+}
+inline void Header::_internal_set_error_code(int32_t value) {
+  _impl_._has_bits_[0] |= 0x00000020u;
+  _impl_.error_code_ = value;
+}
+inline void Header::set_error_code(int32_t value) {
+  _internal_set_error_code(value);
+  // @@protoc_insertion_point(field_set:dRPC.proto.Header.error_code)
+}
+
+// optional string error_text = 10;
+inline bool Header::_internal_has_error_text() const {
+  bool value = (_impl_._has_bits_[0] & 0x00000004u) != 0;
+  return value;
+}
+inline bool Header::has_error_text() const {
+  return _internal_has_error_text();
+}
+inline void Header::clear_error_text() {
+  _impl_.error_text_.ClearToEmpty();
+  _impl_._has_bits_[0] &= ~0x00000004u;
+}
+inline const std::string& Header::error_text() const {
+  // @@protoc_insertion_point(field_get:dRPC.proto.Header.error_text)
+  return _internal_error_text();
+}
+template <typename ArgT0, typename... ArgT>
+inline PROTOBUF_ALWAYS_INLINE
+void Header::set_error_text(ArgT0&& arg0, ArgT... args) {
+ _impl_._has_bits_[0] |= 0x00000004u;
+ _impl_.error_text_.Set(static_cast<ArgT0 &&>(arg0), args..., GetArenaForAllocation());
+  // @@protoc_insertion_point(field_set:dRPC.proto.Header.error_text)
+}
+inline std::string* Header::mutable_error_text() {
+  std::string* _s = _internal_mutable_error_text();
+  // @@protoc_insertion_point(field_mutable:dRPC.proto.Header.error_text)
+  return _s;
+}
+inline const std::string& Header::_internal_error_text() const {
+  return _impl_.error_text_.Get();
+}
+inline void Header::_internal_set_error_text(const std::string& value) {
+  _impl_._has_bits_[0] |= 0x00000004u;
+  _impl_.error_text_.Set(value, GetArenaForAllocation());
+}
+inline std::string* Header::_internal_mutable_error_text() {
+  _impl_._has_bits_[0] |= 0x00000004u;
+  return _impl_.error_text_.Mutable(GetArenaForAllocation());
+}
+inline std::string* Header::release_error_text() {
+  // @@protoc_insertion_point(field_release:dRPC.proto.Header.error_text)
+  if (!_internal_has_error_text()) {
+    return nullptr;
+  }
+  _impl_._has_bits_[0] &= ~0x00000004u;
+  auto* p = _impl_.error_text_.Release();
+#ifdef PROTOBUF_FORCE_COPY_DEFAULT_STRING
+  if (_impl_.error_text_.IsDefault()) {
+    _impl_.error_text_.Set("", GetArenaForAllocation());
+  }
+#endif // PROTOBUF_FORCE_COPY_DEFAULT_STRING
+  return p;
+}
+inline void Header::set_allocated_error_text(std::string* error_text) {
+  if (error_text != nullptr) {
+    _impl_._has_bits_[0] |= 0x00000004u;
+  } else {
+    _impl_._has_bits_[0] &= ~0x00000004u;
+  }
+  _impl_.error_text_.SetAllocated(error_text, GetArenaForAllocation());
+#ifdef PROTOBUF_FORCE_COPY_DEFAULT_STRING
+  if (_impl_.error_text_.IsDefault()) {
+    _impl_.error_text_.Set("", GetArenaForAllocation());
+  }
+#endif // PROTOBUF_FORCE_COPY_DEFAULT_STRING
+  // @@protoc_insertion_point(field_set_allocated:dRPC.proto.Header.error_text)
+}
+
+// optional fixed64 trace_id = 11;
+inline bool Header::_internal_has_trace_id() const {
+  bool value = (_impl_._has_bits_[0] & 0x00000040u) != 0;
+  return value;
+}
+inline bool Header::has_trace_id() const {
+  return _internal_has_trace_id();
+}
+inline void Header::clear_trace_id() {
+  _impl_.trace_id_ = uint64_t{0u};
+  _impl_._has_bits_[0] &= ~0x00000040u;
+}
+inline uint64_t Header::_internal_trace_id() const {
+  return _impl_.trace_id_;
+}
+inline uint64_t Header::trace_id() const {
+  // @@protoc_insertion_point(field_get:dRPC.proto.Header.trace_id)
+  return _internal_trace_id();
+}
+inline void Header::_internal_set_trace_id(uint64_t value) {
+  _impl_._has_bits_[0] |= 0x00000040u;
+  _impl_.trace_id_ = value;
+}
+inline void Header::set_trace_id(uint64_t value) {
+  _internal_set_trace_id(value);
+  // @@protoc_insertion_point(field_set:dRPC.proto.Header.trace_id)
+}
+
+// optional fixed64 span_id = 12;
+inline bool Header::_internal_has_span_id() const {
+  bool value = (_impl_._has_bits_[0] & 0x00000080u) != 0;
+  return value;
+}
+inline bool Header::has_span_id() const {
+  return _internal_has_span_id();
+}
+inline void Header::clear_span_id() {
+  _impl_.span_id_ = uint64_t{0u};
+  _impl_._has_bits_[0] &= ~0x00000080u;
+}
+inline uint64_t Header::_internal_span_id() const {
+  return _impl_.span_id_;
+}
+inline uint64_t Header::span_id() const {
+  // @@protoc_insertion_point(field_get:dRPC.proto.Header.span_id)
+  return _internal_span_id();
+}
+inline void Header::_internal_set_span_id(uint64_t value) {
+  _impl_._has_bits_[0] |= 0x00000080u;
+  _impl_.span_id_ = value;
+}
+inline void Header::set_span_id(uint64_t value) {
+  _internal_set_span_id(value);
+  // @@protoc_insertion_point(field_set:dRPC.proto.Header.span_id)
+}
+
 #ifdef __GNUC__
   #pragma GCC diagnostic pop
 #endif  // __GNUC__
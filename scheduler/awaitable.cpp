@@ -2,6 +2,8 @@
 
 #include "scheduler.h"
 
+#include <errno.h>
+
 namespace dRPC
 {
     bool RegisterReadAwaiter::await_suspend(std::coroutine_handle<> handle) noexcept
@@ -38,4 +40,45 @@ namespace dRPC
     {
         conn_->set_write_handle(handle.address());
     }
-}
\ No newline at end of file
+
+    bool ConnectAwaiter::await_ready() const noexcept
+    {
+        return !conn_->connecting();
+    }
+
+    void ConnectAwaiter::await_suspend(std::coroutine_handle<> handle) noexcept
+    {
+        conn_->set_connect_handle(handle.address());
+        auto executor = conn_->executor();
+        if (!executor->add_event({EventType::CONNECT, conn_}))
+        {
+            conn_->fail_connect(errno);
+            executor->spawn([handle]()
+                            { handle.resume(); });
+            return;
+        }
+        if (timeout_ms_ >= 0)
+        {
+            auto conn = conn_;
+            timer_id_ = executor->run_after(timeout_ms_, [conn]()
+                                            {
+                                                if (!conn->connecting())
+                                                {
+                                                    return;
+                                                }
+                                                conn->executor()->add_event({EventType::DELETE, conn});
+                                                conn->fail_connect(ETIMEDOUT);
+                                                conn->resume_connect(); });
+        }
+    }
+
+    int ConnectAwaiter::await_resume() noexcept
+    {
+        if (timer_id_ != 0)
+        {
+            conn_->executor()->cancel_timer(timer_id_);
+        }
+        conn_->set_connect_handle(nullptr);
+        return conn_->connect_error();
+    }
+}
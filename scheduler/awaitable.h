@@ -1,6 +1,7 @@
 #pragma once
 
 #include <coroutine>
+#include <cstdint>
 
 namespace dRPC
 {
@@ -45,4 +46,15 @@ namespace dRPC
         void await_suspend(std::coroutine_handle<> handle) noexcept;
         void await_resume() const noexcept {}
     };
-}
\ No newline at end of file
+
+    struct ConnectAwaiter
+    {
+        dRPC::net::Connection *conn_;
+        int timeout_ms_;
+        uint64_t timer_id_ = 0;
+
+        bool await_ready() const noexcept;
+        void await_suspend(std::coroutine_handle<> handle) noexcept;
+        int await_resume() noexcept;
+    };
+}
@@ -1,15 +1,28 @@
 #include "epoll_executor.h"
 
+#include <algorithm>
 #include <sys/epoll.h>
 #include <string.h>
 #include <sys/eventfd.h>
 
 #include "util/common.h"
+#include "util/clock.h"
 
 namespace dRPC
 {
-    EpollExecutor::EpollExecutor(int timeout)
+    namespace
     {
+        // 当前线程是否运行某个executor的事件循环
+        thread_local bool executor_thread = false;
+    }
+
+    EpollExecutor::EpollExecutor(int timeout, const ExecutorOptions &options)
+    {
+        if (options.task_queue_capacity_ > 0)
+        {
+            bounded_queue_ = std::make_unique<util::BoundedMPMCQueue<QueuedTask>>(options.task_queue_capacity_);
+        }
+
         epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
         if (epoll_fd_ == -1)
         {
@@ -34,61 +47,122 @@ namespace dRPC
         }
 
         thread_ = std::make_unique<std::thread>([this, timeout]()
-                                                {
-                                                    while (!stop_)
-                                                    {
-                                                        Closure task;
-                                                        while (task_queue_.pop(task))
-                                                        {
-                                                            task();
-                                                        }
-
-                                                        should_notify_.store(true, std::memory_order_release);
-                                                        struct epoll_event events[MAX_EVENTS];
-                                                        int nready = epoll_wait(epoll_fd_, events, MAX_EVENTS, timeout);
-                                                        if (nready == -1)
-                                                        {
-                                                            error("epoll_wait failed: {}", strerror(errno));
-                                                            continue;
-                                                        }
-                                                        for (int i = 0; i < nready; ++i)
-                                                        {
-                                                            auto conn = static_cast<dRPC::net::Connection *>(events[i].data.ptr);
-                                                            if (!conn)
-                                                            {
-                                                                error("conn is null");
-                                                                continue;
-                                                                ;
-                                                            }
-                                                            if (conn->is_dummy())
-                                                            {
-                                                                uint64_t val=1;
-                                                                ::read(conn->fd(), &val, sizeof(uint64_t));
-                                                                should_notify_.store(false, std::memory_order_release);
-                                                                continue;
-                                                            }
-                                                            if(events[i].events&(EPOLLHUP|EPOLLRDHUP)){
-                                                                conn->close();
-                                                                if(epoll_ctl(epoll_fd_,EPOLL_CTL_DEL,conn->fd(),nullptr)==-1){
-                                                                    error("epoll_ctl failed: {}",strerror(errno));
-                                                                }
-                                                                continue;
-                                                            }
-                                                            if(events[i].events&EPOLLOUT){
-                                                                struct epoll_event ev;
-                                                                ev.data.ptr=conn;
-                                                                ev.events=EPOLLIN|EPOLLET;
-                                                                if(epoll_ctl(epoll_fd_,EPOLL_CTL_MOD,conn->fd(),&ev)==-1){
-                                                                    error("epoll_ctl failed: {}",strerror(errno));
-                                                                    continue;
-                                                                }
-                                                                conn->resume_write();
-                                                            }
-                                                            if(events[i].events&EPOLLIN){
-                                                                conn->resume_read();
-                                                            }
-                                                        }
-                                                    } });
+                                                { run_loop(timeout); });
+    }
+
+    void EpollExecutor::run_loop(int timeout)
+    {
+        // 最近1秒内的忙碌时间，窗口结束时发布busy_permille_
+        int64_t window_start_us = util::now_us();
+        int64_t window_wait_us = 0;
+        executor_thread = true;
+        while (!stop_)
+        {
+            util::bump(loops_);
+            queue_depths_.record(spawned_.load(std::memory_order_relaxed) - tasks_.load(std::memory_order_relaxed));
+            QueuedTask task;
+            while (pop_task(task))
+            {
+                int64_t task_start_us = util::now_us();
+                lag_us_.record(task_start_us - task.enqueue_us);
+                task.fn();
+                task_us_.record(util::now_us() - task_start_us);
+                util::bump(tasks_);
+            }
+
+            should_notify_.store(true, std::memory_order_release);
+            struct epoll_event events[MAX_EVENTS];
+            // epoll_wait超时取配置超时与最近定时器到期时间的较小值
+            int wait_timeout = timeout;
+            int timer_timeout = timers_.next_timeout_ms(util::now_us());
+            if (timer_timeout >= 0 && (wait_timeout < 0 || timer_timeout < wait_timeout))
+            {
+                wait_timeout = timer_timeout;
+            }
+            int64_t wait_start_us = util::now_us();
+            int nready = epoll_wait(epoll_fd_, events, MAX_EVENTS, wait_timeout);
+            int64_t wait_end_us = util::now_us();
+            wait_us_.record(wait_end_us - wait_start_us);
+            window_wait_us += wait_end_us - wait_start_us;
+            if (nready == -1)
+            {
+                error("epoll_wait failed: {}", strerror(errno));
+                continue;
+            }
+            ready_events_.record(nready);
+            util::bump(events_, nready);
+            for (int i = 0; i < nready; ++i)
+            {
+                auto conn = static_cast<dRPC::net::Connection *>(events[i].data.ptr);
+                if (!conn)
+                {
+                    error("conn is null");
+                    continue;
+                }
+                if (conn->is_dummy())
+                {
+                    uint64_t val = 1;
+                    ::read(conn->fd(), &val, sizeof(uint64_t));
+                    should_notify_.store(false, std::memory_order_release);
+                    util::bump(wakeups_);
+                    continue;
+                }
+                if (conn->connecting())
+                {
+                    // 连接完成(成功或失败)，移出epoll，由连接协程读取SO_ERROR
+                    if (epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, conn->fd(), nullptr) == -1)
+                    {
+                        error("epoll_ctl failed: {}", strerror(errno));
+                    }
+                    conn->finish_connect();
+                    conn->resume_connect();
+                    continue;
+                }
+                if (events[i].events & (EPOLLHUP | EPOLLERR | EPOLLRDHUP))
+                {
+                    if (epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, conn->fd(), nullptr) == -1)
+                    {
+                        error("epoll_ctl failed: {}", strerror(errno));
+                    }
+                    // 对端复位或连接出错：唤醒读写协程，协程看到closed()后退出(客户端据此重连)。
+                    // 已关闭的连接由关闭方负责唤醒
+                    if (!conn->closed())
+                    {
+                        conn->close();
+                        conn->resume_read();
+                        conn->resume_write();
+                    }
+                    continue;
+                }
+                if (events[i].events & EPOLLOUT)
+                {
+                    struct epoll_event ev;
+                    ev.data.ptr = conn;
+                    ev.events = EPOLLIN | EPOLLET;
+                    if (epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, conn->fd(), &ev) == -1)
+                    {
+                        error("epoll_ctl failed: {}", strerror(errno));
+                        continue;
+                    }
+                    conn->resume_write();
+                }
+                if (events[i].events & EPOLLIN)
+                {
+                    conn->resume_read();
+                }
+            }
+            timers_.run_expired(util::now_us());
+
+            int64_t now_us = util::now_us();
+            if (now_us - window_start_us >= 1000000)
+            {
+                int64_t window_us = now_us - window_start_us;
+                busy_permille_.store((window_us - window_wait_us) * 1000 / window_us, std::memory_order_relaxed);
+                busy_published_us_.store(now_us, std::memory_order_relaxed);
+                window_start_us = now_us;
+                window_wait_us = 0;
+            }
+        }
     }
 
     EpollExecutor::~EpollExecutor()
@@ -109,13 +183,76 @@ namespace dRPC
         stop_ = true;
     }
 
+    bool EpollExecutor::push_task(QueuedTask &&task)
+    {
+        if (!bounded_queue_)
+        {
+            return task_queue_.push(std::move(task));
+        }
+        // executor线程不能等待：本executor的队列要靠自己取空，等待其它executor可能互相阻塞
+        if (executor_thread)
+        {
+            if (overflow_size_.load(std::memory_order_acquire) == 0 && bounded_queue_->push(std::move(task)))
+            {
+                return true;
+            }
+            std::lock_guard<std::mutex> lock(overflow_mutex_);
+            overflow_.push_back(std::move(task));
+            overflow_size_.fetch_add(1, std::memory_order_release);
+            overflowed_.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+        // 其它线程等待队列出现空位，溢出链表未取空时也等待，避免溢出的任务一直得不到执行
+        bool waited = false;
+        while (overflow_size_.load(std::memory_order_acquire) > 0 || !bounded_queue_->push(std::move(task)))
+        {
+            if (stop_.load(std::memory_order_relaxed))
+            {
+                return false;
+            }
+            if (!waited)
+            {
+                waited = true;
+                spawn_waits_.fetch_add(1, std::memory_order_relaxed);
+            }
+            std::this_thread::yield();
+        }
+        return true;
+    }
+
+    bool EpollExecutor::pop_task(QueuedTask &task)
+    {
+        if (!bounded_queue_)
+        {
+            return task_queue_.pop(task);
+        }
+        if (bounded_queue_->pop(task))
+        {
+            return true;
+        }
+        if (overflow_size_.load(std::memory_order_acquire) == 0)
+        {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(overflow_mutex_);
+        if (overflow_.empty())
+        {
+            return false;
+        }
+        task = std::move(overflow_.front());
+        overflow_.pop_front();
+        overflow_size_.fetch_sub(1, std::memory_order_release);
+        return true;
+    }
+
     bool EpollExecutor::spawn(Closure &&task)
     {
-        if (!task_queue_.push(std::move(task)))
+        if (!push_task({std::move(task), util::now_us()}))
         {
-            error("task queue is full");
+            error("failed to spawn task: executor stopped");
             return false;
         }
+        spawned_.fetch_add(1, std::memory_order_relaxed);
 
         bool expect = true;
         if (should_notify_.compare_exchange_strong(expect, false, std::memory_order_release))
@@ -126,6 +263,39 @@ namespace dRPC
         return true;
     }
 
+    ExecutorStats EpollExecutor::stats() const
+    {
+        ExecutorStats result;
+        result.loops = loops_.load(std::memory_order_relaxed);
+        result.tasks = tasks_.load(std::memory_order_relaxed);
+        result.events = events_.load(std::memory_order_relaxed);
+        result.wakeups = wakeups_.load(std::memory_order_relaxed);
+        result.queue_depth = std::max<int64_t>(spawned_.load(std::memory_order_relaxed) - result.tasks, 0);
+        result.overflowed = overflowed_.load(std::memory_order_relaxed);
+        result.spawn_waits = spawn_waits_.load(std::memory_order_relaxed);
+        // 阻塞在epoll_wait中超过一个窗口时不会发布新值，按空闲处理
+        if (util::now_us() - busy_published_us_.load(std::memory_order_relaxed) <= 2000000)
+        {
+            result.busy_ratio = busy_permille_.load(std::memory_order_relaxed) / 1000.0;
+        }
+        result.task_us.merge(task_us_);
+        result.lag_us.merge(lag_us_);
+        result.wait_us.merge(wait_us_);
+        result.ready_events.merge(ready_events_);
+        result.queue_depths.merge(queue_depths_);
+        return result;
+    }
+
+    TimerId EpollExecutor::run_after(int64_t ms, Closure &&task)
+    {
+        return timers_.add(util::now_us() + ms * 1000, std::move(task));
+    }
+
+    void EpollExecutor::cancel_timer(TimerId id)
+    {
+        timers_.cancel(id);
+    }
+
     bool EpollExecutor::add_event(const EventItem &item)
     {
         struct epoll_event ev;
@@ -148,6 +318,14 @@ namespace dRPC
                 return false;
             }
             break;
+        case EventType::CONNECT:
+            ev.events = EPOLLOUT | EPOLLET;
+            if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, item.conn->fd(), &ev) == -1)
+            {
+                error("epoll_ctl failed: {}", strerror(errno));
+                return false;
+            }
+            break;
         case EventType::DELETE:
             if (epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, item.conn->fd(), nullptr) == -1)
             {
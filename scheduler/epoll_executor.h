@@ -1,14 +1,19 @@
 #pragma once
 
+#include <mutex>
+#include <deque>
+
 #include "scheduler.h"
 #include "util/mpmc_queue.h"
+#include "util/bounded_mpmc_queue.h"
+#include "util/timer_queue.h"
 
 namespace dRPC
 {
     class EpollExecutor : public Executor
     {
     public:
-        EpollExecutor(int timeout);
+        EpollExecutor(int timeout, const ExecutorOptions &options = {});
         ~EpollExecutor();
 
         bool add_event(const EventItem &item) override;
@@ -17,8 +22,49 @@ namespace dRPC
 
         bool spawn(Closure &&task) override;
 
+        bool in_executor_thread() const override { return std::this_thread::get_id() == thread_->get_id(); }
+
+        TimerId run_after(int64_t ms, Closure &&task) override;
+        void cancel_timer(TimerId id) override;
+
+        ExecutorStats stats() const override;
+
     private:
-        dRPC::util::MPMCQueue<Closure> task_queue_;
+        // 记录入队时间，用于统计调度延迟
+        struct QueuedTask
+        {
+            Closure fn;
+            int64_t enqueue_us = 0;
+        };
+
+        void run_loop(int timeout);
+        bool push_task(QueuedTask &&task);
+        bool pop_task(QueuedTask &task);
+
+        dRPC::util::MPMCQueue<QueuedTask> task_queue_;
+        // 配置了容量时代替task_queue_
+        std::unique_ptr<dRPC::util::BoundedMPMCQueue<QueuedTask>> bounded_queue_;
+        // 有界队列满时executor线程spawn的任务，队列取空后才执行，保持同一线程spawn的顺序
+        std::mutex overflow_mutex_;
+        std::deque<QueuedTask> overflow_;
+        std::atomic<size_t> overflow_size_{0};
+        dRPC::util::TimerQueue timers_;
+
+        // 循环统计，除spawned_、overflowed_和spawn_waits_外只由executor线程写
+        std::atomic<uint64_t> spawned_{0};
+        std::atomic<uint64_t> overflowed_{0};
+        std::atomic<uint64_t> spawn_waits_{0};
+        std::atomic<uint64_t> loops_{0};
+        std::atomic<uint64_t> tasks_{0};
+        std::atomic<uint64_t> events_{0};
+        std::atomic<uint64_t> wakeups_{0};
+        std::atomic<uint64_t> busy_permille_{0};
+        std::atomic<int64_t> busy_published_us_{0};
+        util::Histogram task_us_;
+        util::Histogram lag_us_;
+        util::Histogram wait_us_;
+        util::Histogram ready_events_;
+        util::Histogram queue_depths_;
 
         std::atomic<bool> should_notify_{false};
         std::unique_ptr<dRPC::net::Connection> dummy_conn_;
@@ -27,7 +73,7 @@ namespace dRPC
 
         std::unique_ptr<std::thread> thread_;
         int epoll_fd_;
-        bool stop_;
+        std::atomic<bool> stop_{false};
 
         EpollExecutor(const EpollExecutor &) = delete;
         EpollExecutor &operator=(const EpollExecutor &) = delete;
@@ -1,11 +1,17 @@
 #include "scheduler.h"
 
+#include <algorithm>
+
 #include "epoll_executor.h"
 
 namespace dRPC
 {
-    Scheduler::Scheduler(int timeout)
+    Scheduler::Scheduler(int timeout, int executor_num, const ExecutorOptions &options)
     {
-        executor_ = std::make_unique<EpollExecutor>(timeout);
+        executor_num = std::max(executor_num, 1);
+        for (int i = 0; i < executor_num; ++i)
+        {
+            executors_.push_back(std::make_unique<EpollExecutor>(timeout, options));
+        }
     }
 }
\ No newline at end of file
@@ -1,8 +1,11 @@
 #pragma once
 
 #include <cstdint>
+#include <atomic>
+#include <vector>
 
 #include "util/common.h"
+#include "util/metrics.h"
 #include "net/connection.h"
 
 namespace dRPC
@@ -16,6 +19,7 @@ namespace dRPC
         READ,
         WRITE,
         DELETE,
+        CONNECT,
         UNKNOWN,
     };
 
@@ -25,6 +29,33 @@ namespace dRPC
         dRPC::net::Connection *conn;
     };
 
+    using TimerId = uint64_t;
+
+    // executor事件循环统计快照，耗时单位微秒
+    struct ExecutorStats
+    {
+        uint64_t loops = 0;   // 循环轮数
+        uint64_t tasks = 0;   // 执行的spawn任务数
+        uint64_t events = 0;  // epoll返回的就绪事件数
+        uint64_t wakeups = 0; // eventfd唤醒次数
+        int64_t queue_depth = 0; // 当前任务队列长度
+        uint64_t overflowed = 0;  // 有界队列满时由executor线程放入溢出链表的任务数
+        uint64_t spawn_waits = 0; // 有界队列满时其它线程等待空位的spawn次数
+        double busy_ratio = 0;   // 最近1秒非epoll_wait时间占比
+        util::HistogramSnapshot task_us;      // 单个任务执行时间
+        util::HistogramSnapshot lag_us;       // 任务从spawn到开始执行的调度延迟
+        util::HistogramSnapshot wait_us;      // 每次epoll_wait阻塞时间
+        util::HistogramSnapshot ready_events; // 每次唤醒的就绪事件数
+        util::HistogramSnapshot queue_depths; // 每轮开始执行任务时的队列长度
+    };
+
+    struct ExecutorOptions
+    {
+        // 任务队列容量，0为无界队列。有界时executor线程中的spawn不阻塞，队列满时放入溢出链表，
+        // 避免executor之间互相等待；其它线程的spawn等待队列出现空位，以此限制spawn风暴
+        size_t task_queue_capacity_ = 0;
+    };
+
     class Executor
     {
     public:
@@ -35,24 +66,47 @@ namespace dRPC
 
         virtual void stop() = 0;
 
+        // executor已停止或任务无法入队时返回false
         virtual bool spawn(Closure &&task) = 0;
+
+        // 当前线程是否为executor线程
+        virtual bool in_executor_thread() const = 0;
+
+        // 定时器接口只能在executor线程中调用
+        virtual TimerId run_after(int64_t ms, Closure &&task) = 0;
+        virtual void cancel_timer(TimerId id) = 0;
+
+        // 可在任意线程调用
+        virtual ExecutorStats stats() const { return {}; }
     };
 
     class Scheduler
     {
     public:
-        Scheduler(int timeout);
+        Scheduler(int timeout, int executor_num = 1, const ExecutorOptions &options = {});
         ~Scheduler() = default;
 
         void stop()
         {
-            executor_->stop();
+            for (auto &executor : executors_)
+            {
+                executor->stop();
+            }
+        }
+
+        // 轮询分配executor
+        Executor *alloc_executor()
+        {
+            size_t index = next_executor_.fetch_add(1, std::memory_order_relaxed);
+            return executors_[index % executors_.size()].get();
         }
 
-        Executor *alloc_executor() { return executor_.get(); }
+        size_t executor_num() const { return executors_.size(); }
+        Executor *executor(size_t index) const { return executors_[index].get(); }
 
     private:
-        std::unique_ptr<Executor> executor_;
+        std::vector<std::unique_ptr<Executor>> executors_;
+        std::atomic<size_t> next_executor_{0};
 
         Scheduler(const Scheduler &) = delete;
         Scheduler &operator=(const Scheduler &) = delete;
@@ -1,14 +1,100 @@
 #include "rpc_server.h"
 
 #include "util/common.h"
+#include "util/clock.h"
+#include "util/service.h"
 #include "proto/message.pb.h"
 
 namespace dRPC
 {
+    namespace
+    {
+        // 请求结束时写入rpcz，耗时为负表示该阶段不适用
+        void record_rpcz(util::MethodMetrics *metrics,net::Connection *conn,int64_t request_id,int64_t recv_us,
+                         int64_t queue_us,int64_t handler_us,int64_t end_us,uint32_t request_bytes,
+                         size_t response_bytes,ErrorCode code,uint64_t trace_id)
+        {
+            auto &rpcz=util::Rpcz::instance();
+            if(!rpcz.enabled()){
+                return;
+            }
+            util::RpcRecord record;
+            record.method=metrics;
+            record.request_id=request_id;
+            record.start_us=recv_us;
+            record.queue_us=queue_us;
+            record.handler_us=handler_us;
+            record.total_us=end_us-recv_us;
+            record.trace_id=trace_id;
+            record.request_bytes=request_bytes;
+            record.response_bytes=static_cast<uint32_t>(response_bytes);
+            record.error_code=static_cast<int32_t>(code);
+            record.set_peer(conn->socket()->peer_addr(),conn->socket()->peer_port());
+            rpcz.record(record);
+        }
+    }
+
     RpcServer::RpcServer(const RpcServerOptions &options)
         : options_(options), accepter_(options.port_, options.backlog_, options.nodelay_)
     {
-        scheduler_ = std::make_unique<dRPC::Scheduler>(options.timeout_);
+        scheduler_ = std::make_unique<dRPC::Scheduler>(options.timeout_, options.executor_num_, options.executor_);
+        if (options.limit_concurrency_)
+        {
+            limiter_ = std::make_unique<util::ConcurrencyLimiter>(options.limiter_);
+        }
+        start_us_ = util::now_us();
+
+        add_status_page("/metrics", "text/plain; version=0.0.4", []()
+                        { return util::MetricsRegistry::instance().dump_prometheus(); });
+        add_status_page("/connections", "text/plain; charset=utf-8", [this]()
+                        { return render_connections(); });
+        add_status_page("/status", "text/plain; charset=utf-8", [this]()
+                        { return render_status(); });
+        add_status_page("/executors", "text/plain; charset=utf-8", [this]()
+                        { return render_executors(); });
+        add_status_page("/rpcz", "text/plain; charset=utf-8", []()
+                        { return util::Rpcz::instance().dump(); });
+    }
+
+    RpcServer::~RpcServer()
+    {
+        scheduler_->stop();
+    }
+
+    void RpcServer::register_service(const std::string &service_name, google::protobuf::Service *service)
+    {
+        service_registry_[service_name] = service;
+        auto descriptor = service->GetDescriptor();
+        for (int i = 0; i < descriptor->method_count(); ++i)
+        {
+            auto method = descriptor->method(i);
+            method_metrics_[method] = util::MetricsRegistry::instance().method("server", method->full_name());
+        }
+    }
+
+    bool RpcServer::register_service(dRPC::GeneratedService *service)
+    {
+        // 先检查所有方法ID，冲突时整个服务都不注册，避免请求被静默分发到另一个方法
+        auto methods=service->methods();
+        for(size_t i=0;i<methods.size();++i){
+            auto &info=methods[i];
+            auto iter=method_registry_.find(info.id);
+            if(iter!=method_registry_.end()){
+                error("method id conflict: {} and {}",info.full_name,iter->second.info->full_name);
+                return false;
+            }
+            for(size_t j=0;j<i;++j){
+                if(methods[j].id==info.id){
+                    error("method id conflict: {} and {}",info.full_name,methods[j].full_name);
+                    return false;
+                }
+            }
+        }
+        for(auto &info:methods){
+            auto metrics=util::MetricsRegistry::instance().method("server",info.full_name);
+            method_registry_.emplace(info.id,MethodEntry{service,&info,metrics});
+        }
+        return true;
     }
 
     void RpcServer::start()
@@ -27,18 +113,28 @@ namespace dRPC
 
             auto executor = scheduler_->alloc_executor();
             auto conn = std::make_shared<dRPC::net::Connection>(connfd, executor);
+            auto ctx = std::make_shared<ConnContext>();
+            ctx->conn = conn;
+            ctx->accepted_us = util::now_us();
 
-            executor->spawn([this, conn]()
-                            { send_fn(conn); });
-            executor->spawn([this, conn]()
-                            { recv_fn(conn); });
+            executor->spawn([this, ctx]()
+                            { send_fn(ctx); });
+            executor->spawn([this, ctx]()
+                            { recv_fn(ctx); });
         }
     }
 
-    dRPC::Task RpcServer::recv_fn(std::shared_ptr<net::Connection> conn)
+    dRPC::Task RpcServer::recv_fn(std::shared_ptr<ConnContext> ctx)
     {
+        auto conn=ctx->conn;
+        {
+            std::lock_guard<std::mutex> lock(conns_mutex_);
+            conns_.insert(ctx.get());
+        }
+
         co_await dRPC::RegisterReadAwaiter{conn.get()};
 
+        bool first_frame=true;
         while (true)
         {
             auto input_stream = conn->get_input_stream();
@@ -51,6 +147,31 @@ namespace dRPC
             {
                 break;
             }
+
+            // 新连接以HTTP请求行开头时作为诊断页面连接处理
+            if(first_frame){
+                first_frame=false;
+                char prefix[sizeof(uint32_t)];
+                input_stream.peek(prefix,sizeof(prefix));
+                ctx->http=StatusPages::is_http(prefix,sizeof(prefix));
+            }
+            if(ctx->http){
+                // 响应带Connection: close，send_fn写完响应后关闭连接，之后的请求不再处理
+                ctx->close_after_write=true;
+                if(serve_http(conn.get())){
+                    while(!conn->closed()){
+                        co_await conn->async_read();
+                    }
+                    break;
+                }
+                if(conn->closed()||conn->to_read_bytes()>=StatusPages::MAX_REQUEST_HEAD){
+                    break;
+                }
+                co_await conn->async_read();
+                continue;
+            }
+            // 以读入帧首部的时间近似请求到达时间
+            int64_t recv_us = conn->last_read_us();
             uint32_t header_len;
             if (!input_stream.read(&header_len, sizeof(uint32_t)))
             {
@@ -83,6 +204,11 @@ namespace dRPC
                 break;
             }
 
+            int64_t deadline_us=-1;
+            if(header.has_timeout_ms()){
+                deadline_us=recv_us+header.timeout_ms()*1000;
+            }
+
             while(conn->to_read_bytes()<sizeof(uint32_t)&&!conn->closed()){
                 co_await conn->async_read();
             }
@@ -95,71 +221,374 @@ namespace dRPC
                 break;
             }
 
-            const auto& service_name=header.service_name();
-            const auto& method_name=header.method_name();
-
-            auto iter=service_registry_.find(service_name);
-            if(iter==service_registry_.end()){
-                error("Service not found: {}",service_name);
-                break;
-            }
-            auto service=iter->second;
-            auto method=service->GetDescriptor()->FindMethodByName(method_name);
-            if(method==nullptr){
-                error("Method not found: {}",method_name);
-                break;
+            if(header.message_type()==proto::MessageType::CANCEL){
+                while(conn->to_read_bytes()<request_len&&!conn->closed()){
+                    co_await conn->async_read();
+                }
+                input_stream.skip(request_len);
+                auto iter=ctx->calls.find(header.request_id());
+                if(iter!=ctx->calls.end()){
+                    iter->second->controller.StartCancel();
+                }
+                continue;
             }
 
-            std::unique_ptr<google::protobuf::Message> request(service->GetRequestPrototype(method).New());
-            std::unique_ptr<google::protobuf::Message> response(service->GetResponsePrototype(method).New());
+            // 生成代码的请求按方法ID查找，否则按service/method名查找描述符。
+            // 单个请求出错只向该请求返回错误，连接上的其它请求不受影响
+            const MethodEntry *entry=nullptr;
+            google::protobuf::Service *service=nullptr;
+            const google::protobuf::MethodDescriptor *method=nullptr;
+            std::string reason;
+            if(header.has_method_id()){
+                auto iter=method_registry_.find(header.method_id());
+                if(iter==method_registry_.end()){
+                    reason=std::format("method id not found: 0x{:08x}",header.method_id());
+                }else{
+                    entry=&iter->second;
+                }
+            }else{
+                const auto& service_name=header.service_name();
+                const auto& method_name=header.method_name();
+
+                auto iter=service_registry_.find(service_name);
+                if(iter==service_registry_.end()){
+                    reason="service not found: "+service_name;
+                }else{
+                    service=iter->second;
+                    method=service->GetDescriptor()->FindMethodByName(method_name);
+                    if(method==nullptr){
+                        reason="method not found: "+service_name+"."+method_name;
+                    }
+                }
+            }
 
-            while(conn->to_read_bytes()<request_len){
+            while(conn->to_read_bytes()<request_len&&!conn->closed()){
                 co_await conn->async_read();
             }
             if(conn->closed()&&conn->to_read_bytes()<request_len){
                 break;
             }
-            input_stream.push_limit(request_len);
-            if(!request->ParseFromZeroCopyStream(&input_stream)){
-                error("Failed to parse request");
-                break;
+
+            if(!reason.empty()){
+                error("{}",reason);
+                input_stream.skip(request_len);
+                write_response(conn.get(),header.request_id(),ErrorCode::NOT_FOUND,reason,nullptr);
+                continue;
             }
-            input_stream.pop_limit();
 
-            service->CallMethod(method,nullptr,request.get(),response.get(),nullptr);
+            ctx->requests.fetch_add(1,std::memory_order_relaxed);
+            util::MethodMetrics *metrics=entry?entry->metrics:method_metrics_.find(method)->second;
+            uint32_t request_bytes=2*sizeof(uint32_t)+header_len+request_len;
+            metrics->on_request(request_bytes);
 
-            auto output_stream=conn->get_output_stream();
+            // 请求在缓冲区中等待期间客户端已超时，跳过反序列化和处理
+            if(deadline_us>=0&&util::now_us()>=deadline_us){
+                input_stream.skip(request_len);
+                int64_t now_us=util::now_us();
+                metrics->on_response(0,true,now_us-recv_us,-1,now_us-recv_us);
+                record_rpcz(metrics,conn.get(),header.request_id(),recv_us,now_us-recv_us,-1,now_us,request_bytes,0,
+                            ErrorCode::TIMEOUT,header.trace_id());
+                continue;
+            }
 
-            proto::Header resp_header;
-            resp_header.set_magic(MAGIC_NUM);
-            resp_header.set_version(VERSION);
-            resp_header.set_message_type(proto::MessageType::RESPONSE);
-            resp_header.set_request_id(header.request_id());
-            uint32_t resp_header_len=resp_header.ByteSizeLong();
-            output_stream.write(&resp_header_len,sizeof(resp_header_len));
-            resp_header.SerializeToZeroCopyStream(&output_stream);
+            // 超过并发上限立即拒绝，客户端可以换一个节点重试
+            if(limiter_&&!limiter_->try_acquire()){
+                input_stream.skip(request_len);
+                size_t bytes=write_response(conn.get(),header.request_id(),ErrorCode::OVERLOADED,"server overloaded",nullptr);
+                int64_t now_us=util::now_us();
+                metrics->on_response(bytes,true,now_us-recv_us,-1,now_us-recv_us);
+                record_rpcz(metrics,conn.get(),header.request_id(),recv_us,now_us-recv_us,-1,now_us,request_bytes,bytes,
+                            ErrorCode::OVERLOADED,header.trace_id());
+                continue;
+            }
 
-            uint32_t response_len=response->ByteSizeLong();
-            output_stream.write(&response_len,sizeof(response_len));
-            response->SerializeToZeroCopyStream(&output_stream);
+            auto call=new ServerCall(ctx,header.request_id());
+            call->controller.set_deadline_us(deadline_us);
+            call->limiter=limiter_.get();
+            call->metrics=metrics;
+            call->recv_us=recv_us;
+            call->start_us=util::now_us();
+            call->request_bytes=request_bytes;
+            if(header.has_trace_id()){
+                call->trace={header.trace_id(),util::Tracer::random_id()};
+                call->parent_span_id=header.span_id();
+                call->controller.set_trace_context(call->trace);
+            }
+            if(entry){
+                call->request.reset(entry->info->request_prototype->New());
+                call->response.reset(entry->info->response_prototype->New());
+            }else{
+                call->request.reset(service->GetRequestPrototype(method).New());
+                call->response.reset(service->GetResponsePrototype(method).New());
+            }
 
-            conn->resume_write();
+            int64_t start=input_stream.ByteCount();
+            input_stream.push_limit(request_len);
+            bool parsed=call->request->ParseFromZeroCopyStream(&input_stream);
+            input_stream.pop_limit();
+            input_stream.skip(request_len-(input_stream.ByteCount()-start));
+            if(call->trace.sampled()){
+                call->parsed_us=util::now_us();
+            }
+            if(!parsed){
+                error("Failed to parse request");
+                call->controller.SetFailed(ErrorCode::BAD_REQUEST,"failed to parse request");
+                call->finish();
+                continue;
+            }
+
+            // 响应在handler调用done时发送，handler可以异步完成
+            ctx->calls[call->request_id]=call;
+            ctx->inflight.fetch_add(1,std::memory_order_relaxed);
+            // handler同步执行期间发起的下游调用属于同一trace
+            util::ScopedTrace trace_scope(call->trace);
+            if(entry){
+                entry->service->call_method(entry->info->id,&call->controller,call->request.get(),call->response.get(),call);
+            }else{
+                service->CallMethod(method,&call->controller,call->request.get(),call->response.get(),call);
+            }
+        }
+
+        // 连接断开，取消仍在处理的请求
+        std::vector<ServerCall *> pending;
+        for(auto &[request_id,call]:ctx->calls){
+            pending.push_back(call);
+        }
+        for(auto call:pending){
+            call->controller.StartCancel();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(conns_mutex_);
+            conns_.erase(ctx.get());
         }
 
         if(!conn->closed()){
+            // 主动断开(如协议错误)：移出epoll，避免之后的事件访问已释放的连接
             conn->close();
+            conn->executor()->add_event({EventType::DELETE,conn.get()});
         }
+        // 协程结束，唤醒send_fn退出
+        conn->set_read_handle(nullptr);
+        conn->resume_write();
         info("connection[{}] closed by peer: {}:{}",conn->fd(),conn->socket()->peer_addr(),conn->socket()->peer_port());
         info("connection[{}] recv_fn done",conn->fd());
     }
 
-    dRPC::Task RpcServer::send_fn(std::shared_ptr<net::Connection> conn)
+    void RpcServer::ServerCall::Run()
+    {
+        auto executor=ctx->conn->executor();
+        if(executor->in_executor_thread()){
+            finish();
+        }else{
+            executor->spawn([this]()
+                            { finish(); });
+        }
+    }
+
+    void RpcServer::ServerCall::finish()
+    {
+        auto iter=ctx->calls.find(request_id);
+        if(iter!=ctx->calls.end()&&iter->second==this){
+            ctx->calls.erase(iter);
+            ctx->inflight.fetch_sub(1,std::memory_order_relaxed);
+        }
+
+        // 已取消的请求客户端不再等待响应
+        auto &conn=ctx->conn;
+        int64_t finish_us=trace.sampled()?util::now_us():0;
+        size_t bytes=0;
+        if(!conn->closed()&&!controller.IsCanceled()){
+            if(controller.Failed()){
+                bytes=write_response(conn.get(),request_id,controller.error_code(),controller.ErrorText(),nullptr);
+            }else{
+                bytes=write_response(conn.get(),request_id,ErrorCode::OK,{},response.get());
+            }
+        }
+
+        int64_t now_us=util::now_us();
+        if(limiter){
+            limiter->release(now_us-start_us,!controller.Failed(),now_us);
+        }
+        if(metrics){
+            metrics->on_response(bytes,controller.Failed()||controller.IsCanceled(),start_us-recv_us,now_us-start_us,now_us-recv_us);
+            record_rpcz(metrics,conn.get(),request_id,recv_us,start_us-recv_us,now_us-start_us,now_us,request_bytes,bytes,
+                        controller.IsCanceled()?ErrorCode::CANCELED:controller.error_code(),trace.trace_id);
+        }
+        if(trace.sampled()){
+            record_spans(finish_us,util::now_us());
+        }
+        controller.finish();
+        delete this;
+    }
+
+    void RpcServer::ServerCall::record_spans(int64_t finish_us, int64_t end_us)
+    {
+        auto &tracer=util::Tracer::instance();
+        if(!tracer.enabled()){
+            return;
+        }
+        util::Span span;
+        span.trace_id=trace.trace_id;
+        span.id=trace.span_id;
+        span.parent_id=parent_span_id;
+        span.start_us=recv_us;
+        span.end_us=end_us;
+        span.error_code=static_cast<int32_t>(controller.IsCanceled()?ErrorCode::CANCELED:controller.error_code());
+        span.kind=util::SpanKind::SERVER;
+        span.set_name(metrics->name());
+        auto socket=ctx->conn->socket();
+        span.set_peer(socket->peer_addr(),socket->peer_port());
+        tracer.record(span);
+
+        struct Phase
+        {
+            const char *name;
+            int64_t start_us;
+            int64_t end_us;
+        };
+        const Phase phases[]={
+            {"queue",recv_us,start_us},
+            {"parse",start_us,parsed_us},
+            {"handler",parsed_us,finish_us},
+            {"serialize",finish_us,end_us},
+        };
+        util::Span child;
+        child.trace_id=trace.trace_id;
+        child.parent_id=trace.span_id;
+        for(auto &phase:phases){
+            child.id=util::Tracer::random_id();
+            child.start_us=phase.start_us;
+            child.end_us=phase.end_us;
+            child.set_name(phase.name);
+            tracer.record(child);
+        }
+    }
+
+    size_t RpcServer::write_response(net::Connection *conn, int64_t request_id, ErrorCode code,
+                                   const std::string &reason, const google::protobuf::Message *response)
     {
+        auto output_stream=conn->get_output_stream();
+
+        proto::Header resp_header;
+        resp_header.set_magic(MAGIC_NUM);
+        resp_header.set_version(VERSION);
+        resp_header.set_message_type(proto::MessageType::RESPONSE);
+        resp_header.set_request_id(request_id);
+        if(code!=ErrorCode::OK){
+            resp_header.set_error_code(static_cast<int32_t>(code));
+            resp_header.set_error_text(reason);
+        }
+        uint32_t resp_header_len=resp_header.ByteSizeLong();
+        output_stream.write(&resp_header_len,sizeof(resp_header_len));
+        resp_header.SerializeToZeroCopyStream(&output_stream);
+
+        uint32_t response_len=response?response->ByteSizeLong():0;
+        output_stream.write(&response_len,sizeof(response_len));
+        if(response){
+            response->SerializeToZeroCopyStream(&output_stream);
+        }
+
+        conn->resume_write();
+        return 2*sizeof(uint32_t)+resp_header_len+response_len;
+    }
+
+    bool RpcServer::serve_http(net::Connection *conn)
+    {
+        std::string head(std::min(conn->to_read_bytes(),StatusPages::MAX_REQUEST_HEAD),'\0');
+        auto input_stream=conn->get_input_stream();
+        input_stream.peek(head.data(),head.size());
+        size_t end=head.find("\r\n\r\n");
+        if(end==std::string::npos){
+            return false;
+        }
+        head.resize(end+4);
+        input_stream.skip(head.size());
+
+        std::string response=status_pages_.respond(head);
+        conn->get_output_stream().write(response.data(),response.size());
+        conn->resume_write();
+        return true;
+    }
+
+    std::string RpcServer::render_connections()
+    {
+        int64_t now_us=util::now_us();
+        std::string out=std::format("{:<6} {:<22} {:<5} {:>8} {:>10} {:>9} {:>8}\n",
+                                    "fd","peer","type","executor","requests","inflight","age_s");
+        std::lock_guard<std::mutex> lock(conns_mutex_);
+        for(auto ctx:conns_){
+            auto socket=ctx->conn->socket();
+            size_t executor=0;
+            while(executor<scheduler_->executor_num()&&scheduler_->executor(executor)!=ctx->conn->executor()){
+                ++executor;
+            }
+            std::format_to(std::back_inserter(out),"{:<6} {:<22} {:<5} {:>8} {:>10} {:>9} {:>8}\n",
+                           ctx->conn->fd(),std::format("{}:{}",socket->peer_addr(),socket->peer_port()),
+                           ctx->http?"http":"rpc",executor,ctx->requests.load(std::memory_order_relaxed),
+                           ctx->inflight.load(std::memory_order_relaxed),(now_us-ctx->accepted_us)/1000000);
+        }
+        return out;
+    }
+
+    std::string RpcServer::render_status()
+    {
+        size_t connections=0;
+        int64_t inflight=0;
+        {
+            std::lock_guard<std::mutex> lock(conns_mutex_);
+            connections=conns_.size();
+            for(auto ctx:conns_){
+                inflight+=ctx->inflight.load(std::memory_order_relaxed);
+            }
+        }
+        std::string out=std::format("port: {}\nuptime_s: {}\nexecutors: {}\nconnections: {}\ninflight: {}\n",
+                                    options_.port_,(util::now_us()-start_us_)/1000000,scheduler_->executor_num(),
+                                    connections,inflight);
+        if(limiter_){
+            std::format_to(std::back_inserter(out),"concurrency_limit: {}\nconcurrency_inflight: {}\nrejected: {}\n",
+                           limiter_->limit(),limiter_->inflight(),limiter_->rejected());
+        }
+        return out;
+    }
+
+    std::string RpcServer::render_executors()
+    {
+        // 调度延迟高而任务耗时低说明循环饱和，任务耗时高说明handler阻塞了循环
+        std::string out=std::format("{:<4} {:>6} {:>10} {:>10} {:>6} {:>9} {:>9} {:>9} {:>9} {:>9} {:>7} {:>9} {:>9} {:>9}\n",
+                                    "id","busy%","loops","tasks","queue","lag_p50","lag_p99","lag_max",
+                                    "task_p99","wait_p50","ev/loop","wakeups","overflow","spawn_wait");
+        for(size_t i=0;i<scheduler_->executor_num();++i){
+            auto stats=scheduler_->executor(i)->stats();
+            double events_per_loop=stats.ready_events.count?static_cast<double>(stats.events)/stats.ready_events.count:0;
+            std::format_to(std::back_inserter(out),"{:<4} {:>6.1f} {:>10} {:>10} {:>6} {:>9} {:>9} {:>9} {:>9} {:>9} {:>7.2f} {:>9} {:>9} {:>9}\n",
+                           i,stats.busy_ratio*100,stats.loops,stats.tasks,stats.queue_depth,
+                           stats.lag_us.percentile(0.5),stats.lag_us.percentile(0.99),stats.lag_us.percentile(1.0),
+                           stats.task_us.percentile(0.99),stats.wait_us.percentile(0.5),events_per_loop,stats.wakeups,
+                           stats.overflowed,stats.spawn_waits);
+        }
+        out.append("(latencies in microseconds, bucket upper bounds)\n");
+        return out;
+    }
+
+    dRPC::Task RpcServer::send_fn(std::shared_ptr<ConnContext> ctx)
+    {
+        auto conn = ctx->conn;
         while (!conn->closed())
         {
             co_await dRPC::WaitWriteAwaiter{conn.get()};
             co_await conn->async_write();
+            if (ctx->close_after_write && conn->to_write_bytes() == 0 && !conn->closed())
+            {
+                // 可能在recv_fn中同步执行，recv_fn挂起后再唤醒它退出
+                conn->close();
+                conn->executor()->add_event({EventType::DELETE, conn.get()});
+                conn->executor()->spawn([conn]()
+                                        { conn->resume_read(); });
+            }
         }
+        // 协程结束，避免之后的resume_write访问已销毁的协程
+        conn->set_write_handle(nullptr);
         info("connection[{}] send_fn done", conn->fd());
     }
 }
\ No newline at end of file
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <mutex>
 #include <unordered_map>
+#include <unordered_set>
 #include <google/protobuf/service.h>
 #include <queue>
 
@@ -8,6 +10,12 @@
 #include "scheduler/task.h"
 #include "net/accepter.h"
 #include "scheduler/scheduler.h"
+#include "util/service.h"
+#include "util/generated_service.h"
+#include "util/concurrency_limiter.h"
+#include "util/metrics.h"
+#include "util/rpcz.h"
+#include "server/status_pages.h"
 
 namespace dRPC
 {
@@ -17,6 +25,11 @@ namespace dRPC
         int backlog_;
         int nodelay_;
         int timeout_;
+        int executor_num_ = 1; // 处理连接的executor数，连接按轮询分配
+        dRPC::ExecutorOptions executor_; // 如task_queue_capacity_限制每个executor的任务队列长度
+        // 自适应并发限制，超过上限的请求直接以OVERLOADED拒绝，不在服务端排队
+        bool limit_concurrency_ = false;
+        util::ConcurrencyLimiterOptions limiter_;
 
         RpcServerOptions(int port, int backlog = 256, int nodelay = 1, int timeout = -1)
             : port_(port), backlog_(backlog), nodelay_(nodelay), timeout_(timeout) {}
@@ -26,18 +39,81 @@ namespace dRPC
     {
     public:
         RpcServer(const RpcServerOptions &options);
-        ~RpcServer() = default;
+        // 停止处理连接的executor
+        ~RpcServer();
 
-        void register_service(const std::string &service_name, google::protobuf::Service *service)
+        void register_service(const std::string &service_name, google::protobuf::Service *service);
+
+        // 注册protoc-gen-drpc生成的服务，请求按header中的method_id分发。
+        // 方法ID与已注册的方法(或本服务的其它方法)冲突时不注册并返回false
+        bool register_service(dRPC::GeneratedService *service);
+
+        // 在RPC端口上提供HTTP诊断页面，内置/metrics、/connections、/status、/executors和/rpcz，需在start之前注册
+        void add_status_page(std::string path, std::string content_type, StatusPages::Render render)
         {
-            service_registry_[service_name] = service;
+            status_pages_.add(std::move(path), std::move(content_type), std::move(render));
         }
 
         void start();
 
     private:
-        dRPC::Task recv_fn(std::shared_ptr<net::Connection> conn);
-        dRPC::Task send_fn(std::shared_ptr<net::Connection> conn);
+        struct ServerCall;
+
+        // 连接上正在处理的请求，用于响应CANCEL帧
+        struct ConnContext
+        {
+            std::shared_ptr<net::Connection> conn;
+            std::unordered_map<int64_t, ServerCall *> calls;
+            bool close_after_write=false; // HTTP连接：响应全部写出后由send_fn关闭连接
+
+            // 以下供状态页面在其它线程读取
+            int64_t accepted_us = 0;
+            std::atomic<bool> http{false};
+            std::atomic<uint64_t> requests{0};
+            std::atomic<int64_t> inflight{0};
+        };
+
+        // 从接收缓冲区取出一个完整的HTTP请求首部并写入响应，首部不完整返回false
+        bool serve_http(net::Connection *conn);
+        std::string render_connections();
+        std::string render_status();
+        std::string render_executors();
+
+        // 单个请求的上下文，作为done传给CallMethod，handler调用done时发送响应并释放自身
+        struct ServerCall : public google::protobuf::Closure
+        {
+            ServerCall(std::shared_ptr<ConnContext> context, int64_t id)
+                : ctx(std::move(context)), request_id(id) {}
+
+            // 可在任意线程调用，响应总是在连接所属的executor上发送
+            void Run() override;
+            void finish();
+
+            std::shared_ptr<ConnContext> ctx;
+            int64_t request_id;
+            dRPC::RpcController controller;
+            std::unique_ptr<google::protobuf::Message> request;
+            std::unique_ptr<google::protobuf::Message> response;
+            util::ConcurrencyLimiter *limiter = nullptr; // 非空时完成后归还并发配额
+            util::MethodMetrics *metrics = nullptr;
+            int64_t recv_us = 0;  // 帧首部读入时间
+            int64_t start_us = 0; // 开始执行handler的时间
+            uint32_t request_bytes = 0;
+            // 以下仅采样的请求设置
+            util::TraceContext trace; // 服务端span
+            uint64_t parent_span_id = 0;
+            int64_t parsed_us = 0;    // 请求反序列化完成的时间
+
+            // 记录服务端span及queue/parse/handler/serialize子span
+            void record_spans(int64_t finish_us, int64_t end_us);
+        };
+
+        // 写入响应帧，code不为OK时只携带错误码和原因，不携带消息体。返回帧的字节数
+        static size_t write_response(net::Connection *conn, int64_t request_id, ErrorCode code,
+                                   const std::string &reason, const google::protobuf::Message *response);
+
+        dRPC::Task recv_fn(std::shared_ptr<ConnContext> ctx);
+        dRPC::Task send_fn(std::shared_ptr<ConnContext> ctx);
 
         RpcServerOptions options_;
 
@@ -45,8 +121,23 @@ namespace dRPC
 
         net::Accepter accepter_;
         std::unique_ptr<dRPC::Scheduler> scheduler_;
+        std::unique_ptr<util::ConcurrencyLimiter> limiter_;
+
+        StatusPages status_pages_;
+        int64_t start_us_;
+        std::mutex conns_mutex_;
+        std::unordered_set<ConnContext *> conns_;
 
         std::unordered_map<std::string, google::protobuf::Service *> service_registry_;
+        std::unordered_map<const google::protobuf::MethodDescriptor *, util::MethodMetrics *> method_metrics_;
+
+        struct MethodEntry
+        {
+            dRPC::GeneratedService *service;
+            const dRPC::MethodInfo *info;
+            util::MethodMetrics *metrics;
+        };
+        std::unordered_map<uint32_t, MethodEntry> method_registry_;
 
         RpcServer(const RpcServer &) = delete;
         RpcServer &operator=(const RpcServer &) = delete;
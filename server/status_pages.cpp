@@ -0,0 +1,79 @@
+#include "status_pages.h"
+
+#include <format>
+
+namespace dRPC
+{
+    namespace
+    {
+        std::string make_response(int status, std::string_view reason, std::string_view content_type,
+                                  const std::string &body, bool head_only)
+        {
+            std::string out = std::format("HTTP/1.1 {} {}\r\nContent-Type: {}\r\nContent-Length: {}\r\nConnection: close\r\n\r\n",
+                                          status, reason, content_type, body.size());
+            if (!head_only)
+            {
+                out.append(body);
+            }
+            return out;
+        }
+    }
+
+    void StatusPages::add(std::string path, std::string content_type, Render render)
+    {
+        pages_.push_back({std::move(path), std::move(content_type), std::move(render)});
+    }
+
+    bool StatusPages::is_http(const char *prefix, size_t len)
+    {
+        if (len < 4)
+        {
+            return false;
+        }
+        std::string_view method(prefix, 4);
+        return method == "GET " || method == "HEAD" || method == "POST" || method == "PUT ";
+    }
+
+    std::string StatusPages::respond(std::string_view head) const
+    {
+        // 请求行: METHOD SP target SP version
+        std::string_view line = head.substr(0, head.find("\r\n"));
+        size_t first = line.find(' ');
+        size_t second = line.find(' ', first + 1);
+        if (first == std::string_view::npos || second == std::string_view::npos)
+        {
+            return make_response(400, "Bad Request", "text/plain", "bad request line\n", false);
+        }
+        std::string_view method = line.substr(0, first);
+        std::string_view target = line.substr(first + 1, second - first - 1);
+        target = target.substr(0, target.find('?'));
+
+        bool head_only = method == "HEAD";
+        if (method != "GET" && !head_only)
+        {
+            return make_response(405, "Method Not Allowed", "text/plain", "only GET is supported\n", false);
+        }
+        if (target == "/")
+        {
+            return make_response(200, "OK", "text/plain; charset=utf-8", index(), head_only);
+        }
+        for (auto &page : pages_)
+        {
+            if (page.path == target)
+            {
+                return make_response(200, "OK", page.content_type, page.render(), head_only);
+            }
+        }
+        return make_response(404, "Not Found", "text/plain", index(), head_only);
+    }
+
+    std::string StatusPages::index() const
+    {
+        std::string out = "dRPC status pages:\n";
+        for (auto &page : pages_)
+        {
+            out.append("  ").append(page.path).push_back('\n');
+        }
+        return out;
+    }
+}
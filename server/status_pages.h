@@ -0,0 +1,41 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <string_view>
+
+namespace dRPC
+{
+    // RPC端口上的只读HTTP诊断页面。连接首部为HTTP方法时由RpcServer转交处理，
+    // 页面在连接所属的executor上生成，应只做快速的内存读取
+    class StatusPages
+    {
+    public:
+        using Render = std::function<std::string()>;
+
+        // 在RpcServer::start之前注册
+        void add(std::string path, std::string content_type, Render render);
+
+        // 连接的前4个字节是否为HTTP请求行，dRPC帧首部为小端长度，不会是可打印字母
+        static bool is_http(const char *prefix, size_t len);
+
+        // 请求首部的最大长度，超过后关闭连接
+        static constexpr size_t MAX_REQUEST_HEAD = 8192;
+
+        // head为以空行结束的完整请求首部，返回完整的HTTP响应
+        std::string respond(std::string_view head) const;
+
+    private:
+        struct Page
+        {
+            std::string path;
+            std::string content_type;
+            Render render;
+        };
+
+        std::string index() const;
+
+        std::vector<Page> pages_;
+    };
+}
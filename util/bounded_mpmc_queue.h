@@ -0,0 +1,142 @@
+#pragma once
+
+#include <new>
+#include <atomic>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace dRPC::util
+{
+    // 有界MPMC环形队列(Vyukov)。每个槽位带序号：序号等于入队位置时可写，等于入队位置+1时可读，
+    // 生产者和消费者各自只CAS一个位置计数器，满时push失败、空时pop失败，不分配内存也不自旋等待。
+    // 与无界的MPMCQueue相比，队列长度有上限，由调用方决定满时丢弃、重试还是让生产者等待
+    template <typename T>
+    class BoundedMPMCQueue
+    {
+    private:
+        struct Cell
+        {
+            std::atomic<size_t> sequence;
+            alignas(T) unsigned char storage[sizeof(T)];
+
+            T *data_ptr() { return std::launder(reinterpret_cast<T *>(storage)); }
+        };
+
+    public:
+        // 容量向上取整为2的幂，至少为2
+        explicit BoundedMPMCQueue(size_t capacity)
+        {
+            size_t size = 2;
+            while (size < capacity)
+            {
+                size <<= 1;
+            }
+            mask_ = size - 1;
+            cells_ = std::make_unique<Cell[]>(size);
+            for (size_t i = 0; i < size; ++i)
+            {
+                cells_[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        ~BoundedMPMCQueue()
+        {
+            T value;
+            while (pop(value))
+            {
+            }
+        }
+
+        // 禁用拷贝和移动
+        BoundedMPMCQueue(const BoundedMPMCQueue &) = delete;
+        BoundedMPMCQueue &operator=(const BoundedMPMCQueue &) = delete;
+        BoundedMPMCQueue(BoundedMPMCQueue &&) = delete;
+        BoundedMPMCQueue &operator=(BoundedMPMCQueue &&) = delete;
+
+        // 队列满时返回false，value保持不变
+        bool push(T &&value)
+        {
+            size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+            while (true)
+            {
+                Cell &cell = cells_[pos & mask_];
+                size_t seq = cell.sequence.load(std::memory_order_acquire);
+                intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+                if (diff == 0)
+                {
+                    if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    {
+                        new (cell.storage) T(std::move(value));
+                        cell.sequence.store(pos + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (diff < 0)
+                {
+                    // 槽位上一轮的数据还未被取走
+                    return false;
+                }
+                else
+                {
+                    pos = enqueue_pos_.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        bool push(const T &value)
+        {
+            T copy(value);
+            return push(std::move(copy));
+        }
+
+        bool pop(T &out)
+        {
+            size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+            while (true)
+            {
+                Cell &cell = cells_[pos & mask_];
+                size_t seq = cell.sequence.load(std::memory_order_acquire);
+                intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+                if (diff == 0)
+                {
+                    if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    {
+                        out = std::move(*cell.data_ptr());
+                        cell.data_ptr()->~T();
+                        // 下一轮写入该槽位的入队位置为pos+容量
+                        cell.sequence.store(pos + mask_ + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (diff < 0)
+                {
+                    return false;
+                }
+                else
+                {
+                    pos = dequeue_pos_.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        size_t capacity() const { return mask_ + 1; }
+
+        // 并发修改时只是近似值
+        size_t size_approx() const
+        {
+            size_t enqueued = enqueue_pos_.load(std::memory_order_relaxed);
+            size_t dequeued = dequeue_pos_.load(std::memory_order_relaxed);
+            return enqueued > dequeued ? enqueued - dequeued : 0;
+        }
+
+    private:
+        std::unique_ptr<Cell[]> cells_;
+        size_t mask_;
+
+        // 生产者和消费者的位置分别独占缓存行
+        alignas(64) std::atomic<size_t> enqueue_pos_{0};
+        alignas(64) std::atomic<size_t> dequeue_pos_{0};
+    };
+}
@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+
+#include <set>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bounded_mpmc_queue.h"
+
+using dRPC::util::BoundedMPMCQueue;
+
+// 容量向上取整为2的幂，满时push失败
+TEST(BoundedMPMCQueueTest, FullAndEmpty)
+{
+    BoundedMPMCQueue<int> queue(5);
+    EXPECT_EQ(queue.capacity(), 8u);
+
+    for (int i = 0; i < 8; ++i)
+    {
+        EXPECT_TRUE(queue.push(i));
+    }
+    EXPECT_FALSE(queue.push(8));
+    EXPECT_EQ(queue.size_approx(), 8u);
+
+    int value;
+    for (int i = 0; i < 8; ++i)
+    {
+        EXPECT_TRUE(queue.pop(value));
+        EXPECT_EQ(value, i);
+    }
+    EXPECT_FALSE(queue.pop(value));
+    EXPECT_EQ(queue.size_approx(), 0u);
+}
+
+// 多轮回绕后仍保持FIFO
+TEST(BoundedMPMCQueueTest, WrapAround)
+{
+    BoundedMPMCQueue<std::string> queue(4);
+    std::string value;
+    for (int round = 0; round < 100; ++round)
+    {
+        EXPECT_TRUE(queue.push("a" + std::to_string(round)));
+        EXPECT_TRUE(queue.push("b" + std::to_string(round)));
+        EXPECT_TRUE(queue.pop(value));
+        EXPECT_EQ(value, "a" + std::to_string(round));
+        EXPECT_TRUE(queue.pop(value));
+        EXPECT_EQ(value, "b" + std::to_string(round));
+    }
+}
+
+// 满时不消费传入的值，析构时释放队列中剩余的元素
+TEST(BoundedMPMCQueueTest, MoveOnlyValues)
+{
+    auto tracked = std::make_shared<int>(7);
+    {
+        BoundedMPMCQueue<std::unique_ptr<std::shared_ptr<int>>> queue(2);
+        EXPECT_TRUE(queue.push(std::make_unique<std::shared_ptr<int>>(tracked)));
+        EXPECT_TRUE(queue.push(std::make_unique<std::shared_ptr<int>>(tracked)));
+
+        auto rejected = std::make_unique<std::shared_ptr<int>>(tracked);
+        EXPECT_FALSE(queue.push(std::move(rejected)));
+        EXPECT_NE(rejected, nullptr);
+        EXPECT_EQ(tracked.use_count(), 4);
+    }
+    EXPECT_EQ(tracked.use_count(), 1);
+}
+
+// 多生产者多消费者，容量远小于元素数，生产者满时重试
+TEST(BoundedMPMCQueueTest, MultipleProducersMultipleConsumers)
+{
+    BoundedMPMCQueue<int> queue(16);
+    const int NUM_PRODUCERS = 4;
+    const int NUM_CONSUMERS = 4;
+    const int ITEMS_PER_PRODUCER = 5000;
+    const int TOTAL_ITEMS = NUM_PRODUCERS * ITEMS_PER_PRODUCER;
+
+    std::atomic<int> consumed_count{0};
+    std::vector<std::thread> producers;
+    std::vector<std::thread> consumers;
+    std::vector<std::vector<int>> consumed_lists(NUM_CONSUMERS);
+
+    for (int i = 0; i < NUM_PRODUCERS; ++i)
+    {
+        producers.emplace_back([&, producer_id = i]()
+                               {
+            for (int j = 0; j < ITEMS_PER_PRODUCER; ++j) {
+                while (!queue.push(producer_id * ITEMS_PER_PRODUCER + j)) {
+                    std::this_thread::yield();
+                }
+            } });
+    }
+    for (int i = 0; i < NUM_CONSUMERS; ++i)
+    {
+        consumers.emplace_back([&, consumer_id = i]()
+                               {
+            int last[NUM_PRODUCERS];
+            std::fill(last, last + NUM_PRODUCERS, -1);
+            while (consumed_count.load() < TOTAL_ITEMS) {
+                int item;
+                if (queue.pop(item)) {
+                    // 同一生产者的元素按入队顺序被取出
+                    int producer_id = item / ITEMS_PER_PRODUCER;
+                    EXPECT_GT(item, last[producer_id]);
+                    last[producer_id] = item;
+                    consumed_lists[consumer_id].push_back(item);
+                    consumed_count.fetch_add(1);
+                } else {
+                    std::this_thread::yield();
+                }
+            } });
+    }
+
+    for (auto &producer : producers)
+    {
+        producer.join();
+    }
+    for (auto &consumer : consumers)
+    {
+        consumer.join();
+    }
+
+    std::set<int> all_consumed;
+    size_t total_consumed = 0;
+    for (const auto &list : consumed_lists)
+    {
+        total_consumed += list.size();
+        all_consumed.insert(list.begin(), list.end());
+    }
+    EXPECT_EQ(total_consumed, static_cast<size_t>(TOTAL_ITEMS));
+    EXPECT_EQ(all_consumed.size(), static_cast<size_t>(TOTAL_ITEMS));
+}
@@ -77,9 +77,14 @@ namespace dRPC::util
 
             while (head_ && read < len)
             {
+                skip_exhausted_head();
                 util::BufferBlock<BlockSize> &block = head_->block;
 
                 auto [read_ptr, read_len] = block.read_view();
+                if (read_len == 0)
+                {
+                    break;
+                }
                 size_t to_read = std::min(len - read, read_len);
                 std::memcpy(dest + read, read_ptr, to_read);
                 block.read(to_read);
@@ -88,8 +93,8 @@ namespace dRPC::util
                 consumed_bytes_ += to_read;
                 total_size_ -= to_read;
 
-                // 如果当前块空了，移除并回收
-                if (block.empty())
+                // 如果当前块空了，移除并回收，最后一个块保留用于后续写入
+                if (block.empty() && head_->next)
                 {
                     remove_head();
                 }
@@ -98,6 +103,19 @@ namespace dRPC::util
             return read;
         }
 
+        // 复制头部最多len字节，不消费数据
+        size_t peek(void *buf, size_t len) const
+        {
+            char *dest = static_cast<char *>(buf);
+            size_t copied = 0;
+            for_each_block([&](const char *data, size_t size)
+                           {
+                               size_t n = std::min(len - copied, size);
+                               std::memcpy(dest + copied, data, n);
+                               copied += n; });
+            return copied;
+        }
+
         void commit_resv(int resv)
         {
             if (resv > 0)
@@ -153,16 +171,22 @@ namespace dRPC::util
             return block.read_view();
         }
 
-        std::vector<iovec> get_iovecs()
+        // 填充待发送数据的iovec，返回个数，不分配内存
+        size_t get_iovecs(iovec *iovs, size_t max_iovs)
         {
-            std::vector<iovec> iovs;
-            for (dRPC::util::ChainedBuffer<>::Node *block = head_; block && iovs.size() < IOV_MAX; block = block->next)
+            size_t count = 0;
+            for (Node *block = head_; block && count < max_iovs; block = block->next)
             {
-                void *data = block->block.data_ + block->block.read_pos;
                 size_t size = block->block.size();
-                iovs.emplace_back(data, size);
+                if (size == 0)
+                {
+                    continue;
+                }
+                iovs[count].iov_base = block->block.data_ + block->block.read_pos;
+                iovs[count].iov_len = size;
+                ++count;
             }
-            return iovs;
+            return count;
         }
 
         // 零拷贝遍历
@@ -195,13 +219,16 @@ namespace dRPC::util
             return count;
         }
 
+        // 清空数据，保留一个空块供后续写入
         void clear()
         {
             while (head_)
             {
                 remove_head();
             }
+            append_node();
             total_size_ = 0;
+            consumed_bytes_ = 0;
         }
 
         int64_t input_byte_count() const { return consumed_bytes_; }
@@ -209,6 +236,7 @@ namespace dRPC::util
 
         bool input_next(const void **data, int *size)
         {
+            skip_exhausted_head();
             util::BufferBlock<BlockSize> &block = head_->block;
 
             if (block.empty() || limit_ == 0)
@@ -241,15 +269,19 @@ namespace dRPC::util
 
         bool input_skip(int n)
         {
-            util::BufferBlock<BlockSize> &block = head_->block;
-
             if (n > input_byte_count())
             {
                 return false;
             }
             while (n > 0)
             {
+                skip_exhausted_head();
+                util::BufferBlock<BlockSize> &block = head_->block;
                 int to_skip = std::min(n, (int)block.size());
+                if (to_skip == 0)
+                {
+                    return false;
+                }
                 block.read_pos += to_skip;
                 n -= to_skip;
                 consumed_bytes_ += to_skip;
@@ -265,13 +297,12 @@ namespace dRPC::util
 
         bool output_next(void **data, int *size)
         {
-            util::BufferBlock<BlockSize> &block = tail_->block;
-
-            if (block.full())
+            if (tail_->block.full())
             {
                 append_node();
-                block = tail_->block;
             }
+            util::BufferBlock<BlockSize> &block = tail_->block;
+
             *data = block.data_ + block.write_pos;
             *size = block.available();
             total_size_ += *size;
@@ -345,6 +376,16 @@ namespace dRPC::util
             }
         }
 
+        // 头部块经input_next读到末尾时没有后继，也不像read()那样重置，之后write才追加新块。
+        // 读取前先移除这样的块，否则后续数据读不到，消息被解析为空
+        void skip_exhausted_head()
+        {
+            if (head_->block.empty() && head_->next)
+            {
+                remove_head();
+            }
+        }
+
         void remove_head()
         {
             if (head_)
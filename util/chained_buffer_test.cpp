@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <cstring>
+
+#include "chained_buffer.h"
+#include "stream.h"
+#include "example/echo.pb.h"
+
+using dRPC::util::ChainedBuffer;
+using dRPC::util::InputStream;
+
+namespace
+{
+    constexpr size_t BLOCK_SIZE = 4096;
+
+    // 写满恰好一个块并像解析消息一样经input_next全部读出：读完的头部块没有后继，
+    // 也不会像read()那样重置，之后的write才追加新块
+    void drain_one_block(ChainedBuffer<> &buffer)
+    {
+        std::string block(BLOCK_SIZE, 'a');
+        ASSERT_EQ(buffer.write(block.data(), block.size()), BLOCK_SIZE);
+        const void *data = nullptr;
+        int size = 0;
+        ASSERT_TRUE(buffer.input_next(&data, &size));
+        ASSERT_EQ(std::string(static_cast<const char *>(data), size), block);
+        ASSERT_TRUE(buffer.empty());
+    }
+}
+
+// 读完的头部块之后追加的数据可以通过input_next读到
+TEST(ChainedBufferTest, InputNextSkipsExhaustedHead)
+{
+    ChainedBuffer<> buffer;
+    drain_one_block(buffer);
+    buffer.write("hello", 5);
+    EXPECT_EQ(buffer.block_count(), 2u);
+
+    const void *data = nullptr;
+    int size = 0;
+    ASSERT_TRUE(buffer.input_next(&data, &size));
+    EXPECT_EQ(std::string(static_cast<const char *>(data), size), "hello");
+    EXPECT_TRUE(buffer.empty());
+}
+
+// 按接收路径的方式解析帧：长度前缀加消息体，消息从块边界之后开始
+TEST(ChainedBufferTest, ParsesMessageAfterBlockBoundary)
+{
+    ChainedBuffer<> buffer;
+    drain_one_block(buffer);
+
+    EchoRequest request;
+    request.set_message(std::string(100, 'x'));
+    std::string body = request.SerializeAsString();
+    uint32_t body_len = body.size();
+    buffer.write(&body_len, sizeof(body_len));
+    buffer.write(body.data(), body.size());
+
+    InputStream input_stream(&buffer);
+    uint32_t len = 0;
+    ASSERT_EQ(input_stream.read(&len, sizeof(len)), sizeof(len));
+    ASSERT_EQ(len, body_len);
+    EchoRequest parsed;
+    input_stream.push_limit(len);
+    ASSERT_TRUE(parsed.ParseFromZeroCopyStream(&input_stream));
+    input_stream.pop_limit();
+    EXPECT_EQ(parsed.message(), request.message());
+    EXPECT_TRUE(buffer.empty());
+}
+
+// 消息恰好在块末尾结束，下一条消息从新块开始
+TEST(ChainedBufferTest, ParsesMessageEndingOnBlockBoundary)
+{
+    ChainedBuffer<> buffer;
+    EchoRequest request;
+    request.set_message("y");
+    std::string body = request.SerializeAsString();
+    std::string filler(BLOCK_SIZE - body.size(), 'f');
+    buffer.write(filler.data(), filler.size());
+    buffer.write(body.data(), body.size());
+
+    std::string out(filler.size(), '\0');
+    ASSERT_EQ(buffer.read(out.data(), out.size()), filler.size());
+    EchoRequest first;
+    InputStream input_stream(&buffer);
+    input_stream.push_limit(body.size());
+    ASSERT_TRUE(first.ParseFromZeroCopyStream(&input_stream));
+    input_stream.pop_limit();
+    EXPECT_EQ(first.message(), "y");
+
+    request.set_message("second");
+    body = request.SerializeAsString();
+    buffer.write(body.data(), body.size());
+    EchoRequest second;
+    input_stream.push_limit(body.size());
+    ASSERT_TRUE(second.ParseFromZeroCopyStream(&input_stream));
+    input_stream.pop_limit();
+    EXPECT_EQ(second.message(), "second");
+}
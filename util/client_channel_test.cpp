@@ -0,0 +1,271 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include <poll.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+#include "scheduler/scheduler.h"
+#include "client/client_channel.h"
+#include "example/echo.pb.h"
+
+using namespace dRPC;
+
+namespace
+{
+    // 测试用服务端：reset为true时收到请求后以RST断开(SO_LINGER为0时close发送RST)，模拟滚动重启中
+    // 被杀掉的服务端；为false时接受连接但从不响应，模拟卡住的后端
+    class TestPeer
+    {
+    public:
+        explicit TestPeer(bool reset) : reset_(reset)
+        {
+            listen_fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            addr.sin_port = 0;
+            ::bind(listen_fd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr));
+            ::listen(listen_fd_, 16);
+            socklen_t len = sizeof(addr);
+            ::getsockname(listen_fd_, reinterpret_cast<sockaddr *>(&addr), &len);
+            port_ = ntohs(addr.sin_port);
+            thread_ = std::thread([this]()
+                                  { run(); });
+        }
+
+        ~TestPeer()
+        {
+            stop_ = true;
+            thread_.join();
+            for (int fd : idle_)
+            {
+                ::close(fd);
+            }
+            ::close(listen_fd_);
+        }
+
+        int port() const { return port_; }
+        int accepted() const { return accepted_.load(); }
+
+    private:
+        void run()
+        {
+            while (!stop_)
+            {
+                pollfd pfd{listen_fd_, POLLIN, 0};
+                if (::poll(&pfd, 1, 10) <= 0)
+                {
+                    continue;
+                }
+                int fd = ::accept(listen_fd_, nullptr, nullptr);
+                if (fd < 0)
+                {
+                    continue;
+                }
+                ++accepted_;
+                // 不复位或没有请求的连接保持打开，直到测试结束
+                pollfd conn{fd, POLLIN, 0};
+                if (!reset_ || ::poll(&conn, 1, 1000) <= 0)
+                {
+                    idle_.push_back(fd);
+                    continue;
+                }
+                char buf[4096];
+                ::recv(fd, buf, sizeof(buf), 0);
+                linger lg{1, 0};
+                ::setsockopt(fd, SOL_SOCKET, SO_LINGER, &lg, sizeof(lg));
+                ::close(fd);
+            }
+        }
+
+        bool reset_;
+        int listen_fd_ = -1;
+        int port_ = 0;
+        std::atomic<int> accepted_{0};
+        std::atomic<bool> stop_{false};
+        std::vector<int> idle_;
+        std::thread thread_;
+    };
+
+    struct Done : google::protobuf::Closure
+    {
+        RpcController *controller;
+        std::promise<ErrorCode> result;
+
+        void Run() override
+        {
+            result.set_value(controller->error_code());
+        }
+    };
+
+    // 发起一次协程调用，timeout_ms<0时不设置超时
+    dRPC::Task call_echo(ClientChannel *channel, int timeout_ms, std::promise<ErrorCode> *result)
+    {
+        EchoRequest request;
+        request.set_message("wait");
+        RpcController controller;
+        if (timeout_ms >= 0)
+        {
+            controller.SetTimeout(timeout_ms);
+        }
+        auto method = EchoService::descriptor()->FindMethodByName("Echo");
+        auto response = co_await channel->call<EchoResponse>(method, request, &controller);
+        result->set_value(response.code);
+    }
+
+    dRPC::Task wait_connected(ClientChannel *channel, std::promise<int> *result)
+    {
+        int err = co_await channel->wait_connected();
+        result->set_value(err);
+    }
+
+    bool wait_until(const std::function<bool()> &cond, int timeout_ms)
+    {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+        while (!cond())
+        {
+            if (std::chrono::steady_clock::now() > deadline)
+            {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        return true;
+    }
+}
+
+// 对端复位连接时已发出的请求立即以UNAVAILABLE失败(未设置调用超时)，channel随后重连
+TEST(ClientChannelTest, ResetByPeer)
+{
+    TestPeer peer(true);
+    Scheduler scheduler(100);
+    ClientOptions options;
+    options.ip_ = "127.0.0.1";
+    options.port_ = peer.port();
+    options.reconnect_initial_backoff_ms_ = 10;
+    auto channel = ClientChannel::create(options, scheduler.alloc_executor());
+    ASSERT_TRUE(wait_until([&]()
+                           { return peer.accepted() == 1; },
+                           2000));
+
+    auto method = EchoService::descriptor()->FindMethodByName("Echo");
+    for (int i = 0; i < 3; ++i)
+    {
+        auto request = new EchoRequest;
+        request->set_message("reset");
+        auto controller = new RpcController;
+        EchoResponse response;
+        Done done;
+        done.controller = controller;
+        auto result = done.result.get_future();
+        channel->CallMethod(method, controller, request, &response, &done);
+        ASSERT_EQ(result.wait_for(std::chrono::seconds(2)), std::future_status::ready);
+        EXPECT_EQ(result.get(), ErrorCode::UNAVAILABLE);
+        // 每次复位后重连，下一个请求发往新连接
+        EXPECT_TRUE(wait_until([&]()
+                               { return peer.accepted() == i + 2; },
+                               2000));
+    }
+
+    channel.reset();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    scheduler.stop();
+}
+
+// 后端卡住时达到未完成请求上限，排队等待容量的协程调用按自己的超时失败，close时以UNAVAILABLE失败
+TEST(ClientChannelTest, CapacityWaitersTimeoutAndClose)
+{
+    TestPeer peer(false);
+    Scheduler scheduler(100);
+    ClientOptions options;
+    options.ip_ = "127.0.0.1";
+    options.port_ = peer.port();
+    options.max_inflight_ = 1;
+    auto channel = ClientChannel::create(options, scheduler.alloc_executor());
+
+    std::promise<ErrorCode> blocked;
+    auto blocked_result = blocked.get_future();
+    call_echo(channel.get(), -1, &blocked);
+
+    std::promise<ErrorCode> queued;
+    auto queued_result = queued.get_future();
+    auto start = std::chrono::steady_clock::now();
+    call_echo(channel.get(), 100, &queued);
+    ASSERT_EQ(queued_result.wait_for(std::chrono::seconds(2)), std::future_status::ready);
+    EXPECT_EQ(queued_result.get(), ErrorCode::TIMEOUT);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(1000));
+
+    std::promise<ErrorCode> waiting;
+    auto waiting_result = waiting.get_future();
+    call_echo(channel.get(), -1, &waiting);
+    EXPECT_EQ(waiting_result.wait_for(std::chrono::milliseconds(50)), std::future_status::timeout);
+
+    channel->close();
+    ASSERT_EQ(waiting_result.wait_for(std::chrono::seconds(2)), std::future_status::ready);
+    EXPECT_EQ(waiting_result.get(), ErrorCode::UNAVAILABLE);
+    ASSERT_EQ(blocked_result.wait_for(std::chrono::seconds(2)), std::future_status::ready);
+    EXPECT_EQ(blocked_result.get(), ErrorCode::UNAVAILABLE);
+
+    channel.reset();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    scheduler.stop();
+}
+
+// 连接尚未建立时关闭或释放channel，中止连接而不是等到连接超时，超时定时器不再访问已释放的连接
+TEST(ClientChannelTest, ReleaseWhileConnecting)
+{
+    // backlog为0且不accept，队列占满后新连接的SYN被丢弃，connect一直进行中
+    int listen_fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ::bind(listen_fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr));
+    ::listen(listen_fd, 0);
+    socklen_t len = sizeof(addr);
+    ::getsockname(listen_fd, reinterpret_cast<sockaddr *>(&addr), &len);
+    std::vector<int> fillers;
+    for (int i = 0; i < 4; ++i)
+    {
+        int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+        ::connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr));
+        fillers.push_back(fd);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    Scheduler scheduler(100);
+    ClientOptions options;
+    options.ip_ = "127.0.0.1";
+    options.port_ = ntohs(addr.sin_port);
+    options.connect_timeout_ms_ = 300;
+    auto channel = ClientChannel::create(options, scheduler.alloc_executor());
+    std::promise<int> connected;
+    auto connected_result = connected.get_future();
+    wait_connected(channel.get(), &connected);
+    ASSERT_EQ(connected_result.wait_for(std::chrono::milliseconds(50)), std::future_status::timeout);
+
+    channel->close();
+    ASSERT_EQ(connected_result.wait_for(std::chrono::milliseconds(200)), std::future_status::ready);
+    EXPECT_EQ(connected_result.get(), ECANCELED);
+
+    // 另一个channel在连接中直接释放，等待超过连接超时
+    auto released = ClientChannel::create(options, scheduler.alloc_executor());
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    released.reset();
+    channel.reset();
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    scheduler.stop();
+    for (int fd : fillers)
+    {
+        ::close(fd);
+    }
+    ::close(listen_fd);
+}
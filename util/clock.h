@@ -0,0 +1,21 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace dRPC::util
+{
+    // 单调时钟，单位微秒
+    inline int64_t now_us()
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    // 单调时钟，单位毫秒
+    inline int64_t now_ms()
+    {
+        return now_us() / 1000;
+    }
+}
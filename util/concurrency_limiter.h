@@ -0,0 +1,120 @@
+#pragma once
+
+#include <mutex>
+#include <cmath>
+#include <atomic>
+#include <cstdint>
+#include <algorithm>
+
+namespace dRPC::util
+{
+    struct ConcurrencyLimiterOptions
+    {
+        int initial_limit_ = 40;
+        int min_limit_ = 4;
+        int max_limit_ = 1000;
+        int window_ms_ = 100;   // 采样窗口长度
+        int min_samples_ = 20;  // 窗口内样本不足时继续累积
+        double tolerance_ = 1.5; // 平均延迟超过基线的倍数后开始收缩
+        double smoothing_ = 0.2; // 新旧上限的平滑系数
+    };
+
+    // 自适应并发限制(gradient)：以窗口内最低的平均处理延迟为无负载基线，
+    // 每个窗口按 gradient = tolerance * 基线 / 平均延迟 (限制在[0.5, 1]) 调整上限，
+    // new_limit = limit * gradient + sqrt(limit)，延迟接近基线时缓慢增长，排队导致延迟上升时收缩。
+    // try_acquire/release可在多线程中并发调用，统计锁被占用时丢弃该样本
+    class ConcurrencyLimiter
+    {
+    public:
+        explicit ConcurrencyLimiter(const ConcurrencyLimiterOptions &options = {})
+            : options_(options), limit_(std::clamp(options.initial_limit_, options.min_limit_, options.max_limit_)) {}
+
+        // 超过当前上限返回false，请求应被立即拒绝
+        bool try_acquire()
+        {
+            int64_t inflight = inflight_.fetch_add(1, std::memory_order_relaxed) + 1;
+            if (inflight > limit_.load(std::memory_order_relaxed))
+            {
+                inflight_.fetch_sub(1, std::memory_order_relaxed);
+                rejected_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            return true;
+        }
+
+        // 请求处理完成，失败的请求不计入延迟样本
+        void release(int64_t latency_us, bool success, int64_t now_us)
+        {
+            int64_t inflight = inflight_.fetch_sub(1, std::memory_order_relaxed);
+            if (!success)
+            {
+                return;
+            }
+            std::unique_lock lock(mutex_, std::try_to_lock);
+            if (!lock.owns_lock())
+            {
+                return;
+            }
+            if (window_start_us_ == 0)
+            {
+                window_start_us_ = now_us;
+            }
+            ++samples_;
+            total_latency_us_ += latency_us;
+            max_inflight_ = std::max(max_inflight_, inflight);
+            if (now_us - window_start_us_ >= options_.window_ms_ * 1000LL && samples_ >= options_.min_samples_)
+            {
+                update();
+                window_start_us_ = now_us;
+                samples_ = 0;
+                total_latency_us_ = 0;
+                max_inflight_ = 0;
+            }
+        }
+
+        int64_t limit() const { return limit_.load(std::memory_order_relaxed); }
+        int64_t inflight() const { return inflight_.load(std::memory_order_relaxed); }
+        int64_t rejected() const { return rejected_.load(std::memory_order_relaxed); }
+
+    private:
+        // 持有mutex_时调用
+        void update()
+        {
+            double avg = static_cast<double>(total_latency_us_) / samples_;
+            // 基线取最低平均延迟，并缓慢向当前值靠拢以适应负载特征变化
+            if (baseline_us_ <= 0 || avg < baseline_us_)
+            {
+                baseline_us_ = avg;
+            }
+            else
+            {
+                baseline_us_ += (avg - baseline_us_) / 64;
+            }
+
+            double limit = static_cast<double>(limit_.load(std::memory_order_relaxed));
+            double gradient = std::clamp(options_.tolerance_ * baseline_us_ / std::max(avg, 1.0), 0.5, 1.0);
+            double new_limit = limit * gradient + std::sqrt(limit);
+            // 并发没有接近上限时延迟不能反映上限是否合适，不继续增长
+            if (new_limit > limit && max_inflight_ < limit / 2)
+            {
+                new_limit = limit;
+            }
+            limit = limit * (1 - options_.smoothing_) + new_limit * options_.smoothing_;
+            limit_.store(std::clamp(static_cast<int64_t>(limit), static_cast<int64_t>(options_.min_limit_),
+                                    static_cast<int64_t>(options_.max_limit_)),
+                         std::memory_order_relaxed);
+        }
+
+        const ConcurrencyLimiterOptions options_;
+        std::atomic<int64_t> limit_;
+        std::atomic<int64_t> inflight_{0};
+        std::atomic<int64_t> rejected_{0};
+
+        std::mutex mutex_;
+        int64_t window_start_us_ = 0;
+        int64_t samples_ = 0;
+        int64_t total_latency_us_ = 0;
+        int64_t max_inflight_ = 0;
+        double baseline_us_ = 0;
+    };
+}
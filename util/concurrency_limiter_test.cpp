@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+
+#include "concurrency_limiter.h"
+
+using dRPC::util::ConcurrencyLimiter;
+using dRPC::util::ConcurrencyLimiterOptions;
+
+namespace
+{
+    // 以固定并发和延迟跑一个采样窗口
+    void run_window(ConcurrencyLimiter &limiter, int64_t &now_us, int concurrency, int64_t latency_us)
+    {
+        for (int i = 0; i < 20; ++i)
+        {
+            int acquired = 0;
+            while (acquired < concurrency && limiter.try_acquire())
+            {
+                ++acquired;
+            }
+            now_us += 10 * 1000;
+            for (int j = 0; j < acquired; ++j)
+            {
+                limiter.release(latency_us, true, now_us);
+            }
+        }
+    }
+}
+
+TEST(ConcurrencyLimiterTest, RejectOverLimit)
+{
+    ConcurrencyLimiterOptions options;
+    options.initial_limit_ = 2;
+    options.min_limit_ = 1;
+    ConcurrencyLimiter limiter(options);
+    EXPECT_TRUE(limiter.try_acquire());
+    EXPECT_TRUE(limiter.try_acquire());
+    EXPECT_FALSE(limiter.try_acquire());
+    EXPECT_EQ(limiter.rejected(), 1);
+    limiter.release(100, true, 1);
+    EXPECT_TRUE(limiter.try_acquire());
+}
+
+TEST(ConcurrencyLimiterTest, GrowWhenLatencyStable)
+{
+    ConcurrencyLimiter limiter;
+    int64_t now_us = 1;
+    for (int i = 0; i < 10; ++i)
+    {
+        run_window(limiter, now_us, 1000, 1000);
+    }
+    EXPECT_GT(limiter.limit(), 40);
+}
+
+TEST(ConcurrencyLimiterTest, ShrinkWhenLatencyRises)
+{
+    ConcurrencyLimiter limiter;
+    int64_t now_us = 1;
+    run_window(limiter, now_us, 1000, 1000);
+    int64_t limit = limiter.limit();
+    for (int i = 0; i < 10; ++i)
+    {
+        run_window(limiter, now_us, 1000, 5000);
+    }
+    EXPECT_LT(limiter.limit(), limit);
+    EXPECT_GE(limiter.limit(), 4);
+}
+
+TEST(ConcurrencyLimiterTest, IdleDoesNotGrow)
+{
+    ConcurrencyLimiter limiter;
+    int64_t now_us = 1;
+    for (int i = 0; i < 10; ++i)
+    {
+        run_window(limiter, now_us, 2, 1000);
+    }
+    EXPECT_EQ(limiter.limit(), 40);
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <google/protobuf/message.h>
+#include <google/protobuf/service.h>
+
+#include "util/service.h"
+
+namespace dRPC
+{
+    // 方法ID：方法全名(package.Service.Method)的FNV-1a哈希，编译期计算
+    constexpr uint32_t method_id(std::string_view full_name)
+    {
+        uint32_t hash = 2166136261u;
+        for (char c : full_name)
+        {
+            hash ^= static_cast<uint8_t>(c);
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    struct MethodInfo
+    {
+        uint32_t id;
+        const char *full_name;
+        const google::protobuf::Message *request_prototype;
+        const google::protobuf::Message *response_prototype;
+    };
+
+    // protoc-gen-drpc生成的服务基类的公共接口，服务端按方法ID分发
+    class GeneratedService
+    {
+    public:
+        virtual ~GeneratedService() = default;
+
+        virtual std::string_view service_name() const = 0;
+        virtual std::span<const MethodInfo> methods() const = 0;
+        // request/response由methods()中对应的prototype创建，生成代码直接static_cast为具体类型
+        virtual void call_method(uint32_t method_id,
+                                 dRPC::RpcController *controller,
+                                 const google::protobuf::Message *request,
+                                 google::protobuf::Message *response,
+                                 google::protobuf::Closure *done) = 0;
+    };
+}
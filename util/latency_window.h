@@ -0,0 +1,50 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <algorithm>
+
+namespace dRPC::util
+{
+    // 最近CAPACITY个延迟样本的环形窗口，add可在多个线程并发调用，
+    // percentile读取一份快照后用nth_element计算，适合低频查询并由调用方缓存
+    class LatencyWindow
+    {
+    public:
+        static constexpr size_t CAPACITY = 1024;
+        static_assert((CAPACITY & (CAPACITY - 1)) == 0, "capacity must be power of 2");
+
+        void add(int64_t value)
+        {
+            uint64_t index = count_.fetch_add(1, std::memory_order_relaxed);
+            samples_[index & (CAPACITY - 1)].store(value, std::memory_order_relaxed);
+        }
+
+        // 累计样本数(含已被覆盖的)
+        uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+
+        // p取值(0, 1]，样本数少于min_samples时返回-1
+        int64_t percentile(double p, size_t min_samples = 1) const
+        {
+            size_t n = std::min<uint64_t>(count(), CAPACITY);
+            if (n == 0 || n < min_samples)
+            {
+                return -1;
+            }
+            std::array<int64_t, CAPACITY> snapshot;
+            for (size_t i = 0; i < n; ++i)
+            {
+                snapshot[i] = samples_[i].load(std::memory_order_relaxed);
+            }
+            size_t rank = static_cast<size_t>(std::clamp(p, 0.0, 1.0) * n);
+            rank = std::min(rank == 0 ? 0 : rank - 1, n - 1);
+            std::nth_element(snapshot.begin(), snapshot.begin() + rank, snapshot.begin() + n);
+            return snapshot[rank];
+        }
+
+    private:
+        std::atomic<uint64_t> count_{0};
+        std::array<std::atomic<int64_t>, CAPACITY> samples_{};
+    };
+}
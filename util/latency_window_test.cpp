@@ -0,0 +1,36 @@
+#include <gtest/gtest.h>
+
+#include "latency_window.h"
+
+using dRPC::util::LatencyWindow;
+
+TEST(LatencyWindowTest, Percentile)
+{
+    LatencyWindow window;
+    EXPECT_EQ(window.percentile(0.5), -1);
+
+    for (int i = 1; i <= 100; ++i)
+    {
+        window.add(i);
+    }
+    EXPECT_EQ(window.percentile(0.5), 50);
+    EXPECT_EQ(window.percentile(0.99), 99);
+    EXPECT_EQ(window.percentile(1.0), 100);
+    EXPECT_EQ(window.percentile(0.5, 101), -1);
+}
+
+// 超过容量后只保留最近的样本
+TEST(LatencyWindowTest, Wraparound)
+{
+    LatencyWindow window;
+    for (size_t i = 0; i < LatencyWindow::CAPACITY; ++i)
+    {
+        window.add(1000000);
+    }
+    for (size_t i = 0; i < LatencyWindow::CAPACITY; ++i)
+    {
+        window.add(10);
+    }
+    EXPECT_EQ(window.count(), 2 * LatencyWindow::CAPACITY);
+    EXPECT_EQ(window.percentile(1.0), 10);
+}
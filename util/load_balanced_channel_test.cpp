@@ -0,0 +1,262 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+#include "util/common.h"
+#include "scheduler/scheduler.h"
+#include "client/load_balanced_channel.h"
+#include "proto/message.pb.h"
+#include "example/echo.pb.h"
+
+using namespace dRPC;
+
+namespace
+{
+    // 测试用echo后端：按帧格式解析请求并原样回显消息。kill_after>0时收到第kill_after个请求后
+    // 以RST关闭所有连接并停止监听，模拟被杀掉的后端，之后的重连被拒绝
+    class EchoBackend
+    {
+    public:
+        explicit EchoBackend(int kill_after = 0) : kill_after_(kill_after)
+        {
+            listen_fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            ::bind(listen_fd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr));
+            ::listen(listen_fd_, 16);
+            socklen_t len = sizeof(addr);
+            ::getsockname(listen_fd_, reinterpret_cast<sockaddr *>(&addr), &len);
+            port_ = ntohs(addr.sin_port);
+            thread_ = std::thread([this]()
+                                  { run(); });
+        }
+
+        ~EchoBackend()
+        {
+            stop_ = true;
+            thread_.join();
+            kill();
+        }
+
+        int port() const { return port_; }
+        int requests() const { return requests_.load(); }
+
+    private:
+        struct Conn
+        {
+            int fd;
+            std::string buffer;
+        };
+
+        void run()
+        {
+            while (!stop_)
+            {
+                std::vector<pollfd> fds;
+                if (listen_fd_ >= 0)
+                {
+                    fds.push_back({listen_fd_, POLLIN, 0});
+                }
+                for (auto &conn : conns_)
+                {
+                    fds.push_back({conn.fd, POLLIN, 0});
+                }
+                if (::poll(fds.data(), fds.size(), 10) <= 0)
+                {
+                    continue;
+                }
+                size_t first_conn = 0;
+                if (listen_fd_ >= 0)
+                {
+                    first_conn = 1;
+                    if (fds[0].revents & POLLIN)
+                    {
+                        int fd = ::accept(listen_fd_, nullptr, nullptr);
+                        if (fd >= 0)
+                        {
+                            conns_.push_back({fd, {}});
+                        }
+                    }
+                }
+                for (size_t i = first_conn; i < fds.size() && listen_fd_ >= 0; ++i)
+                {
+                    if (fds[i].revents == 0)
+                    {
+                        continue;
+                    }
+                    auto &conn = conns_[i - first_conn];
+                    char buf[4096];
+                    ssize_t n = ::recv(conn.fd, buf, sizeof(buf), 0);
+                    if (n <= 0)
+                    {
+                        ::close(conn.fd);
+                        conn.fd = -1;
+                        continue;
+                    }
+                    conn.buffer.append(buf, n);
+                    serve(conn);
+                }
+                std::erase_if(conns_, [](const Conn &conn)
+                              { return conn.fd < 0; });
+            }
+        }
+
+        // 处理缓冲区中所有完整的请求帧：[header_len][Header][body_len][body]
+        void serve(Conn &conn)
+        {
+            while (true)
+            {
+                uint32_t header_len = 0;
+                uint32_t body_len = 0;
+                if (conn.buffer.size() < sizeof(uint32_t))
+                {
+                    return;
+                }
+                memcpy(&header_len, conn.buffer.data(), sizeof(uint32_t));
+                size_t body_pos = sizeof(uint32_t) + header_len + sizeof(uint32_t);
+                if (conn.buffer.size() < body_pos)
+                {
+                    return;
+                }
+                memcpy(&body_len, conn.buffer.data() + body_pos - sizeof(uint32_t), sizeof(uint32_t));
+                if (conn.buffer.size() < body_pos + body_len)
+                {
+                    return;
+                }
+                proto::Header header;
+                header.ParseFromArray(conn.buffer.data() + sizeof(uint32_t), header_len);
+                EchoRequest request;
+                request.ParseFromArray(conn.buffer.data() + body_pos, body_len);
+                conn.buffer.erase(0, body_pos + body_len);
+
+                if (++requests_ == kill_after_)
+                {
+                    kill();
+                    return;
+                }
+                proto::Header resp_header;
+                resp_header.set_magic(MAGIC_NUM);
+                resp_header.set_version(VERSION);
+                resp_header.set_message_type(proto::MessageType::RESPONSE);
+                resp_header.set_request_id(header.request_id());
+                EchoResponse response;
+                response.set_message(request.message());
+                std::string frame;
+                uint32_t len = resp_header.ByteSizeLong();
+                frame.append(reinterpret_cast<char *>(&len), sizeof(len));
+                frame += resp_header.SerializeAsString();
+                len = response.ByteSizeLong();
+                frame.append(reinterpret_cast<char *>(&len), sizeof(len));
+                frame += response.SerializeAsString();
+                ::send(conn.fd, frame.data(), frame.size(), MSG_NOSIGNAL);
+            }
+        }
+
+        void kill()
+        {
+            for (auto &conn : conns_)
+            {
+                if (conn.fd >= 0)
+                {
+                    linger lg{1, 0};
+                    ::setsockopt(conn.fd, SOL_SOCKET, SO_LINGER, &lg, sizeof(lg));
+                    ::close(conn.fd);
+                    conn.fd = -1;
+                }
+            }
+            if (listen_fd_ >= 0)
+            {
+                ::close(listen_fd_);
+                listen_fd_ = -1;
+            }
+        }
+
+        int kill_after_;
+        int listen_fd_ = -1;
+        int port_ = 0;
+        std::atomic<int> requests_{0};
+        std::atomic<bool> stop_{false};
+        std::vector<Conn> conns_;
+        std::thread thread_;
+    };
+
+    struct Done : google::protobuf::Closure
+    {
+        RpcController *controller;
+        std::promise<ErrorCode> result;
+
+        void Run() override
+        {
+            result.set_value(controller->error_code());
+        }
+    };
+
+    dRPC::Task call_echo(LoadBalancedChannel *channel, std::promise<ErrorCode> *result)
+    {
+        EchoRequest request;
+        request.set_message("retry");
+        RpcController controller;
+        controller.SetTimeout(3000);
+        auto method = EchoService::descriptor()->FindMethodByName("Echo");
+        auto response = co_await channel->call<EchoResponse>(method, request, &controller);
+        result->set_value(response.ok() && response.response.message() == "retry" ? ErrorCode::OK : response.code);
+    }
+}
+
+// 两个后端之一在处理请求时被杀掉：已发出的请求以UNAVAILABLE失败后在另一个endpoint上重试成功，
+// 而不是在已断开的子channel上耗尽重试次数
+TEST(LoadBalancedChannelTest, RetriesOnAnotherEndpointWhenBackendDies)
+{
+    EchoBackend alive;
+    EchoBackend dying(1);
+    Scheduler scheduler(100);
+    LoadBalancedOptions options;
+    options.endpoints_ = {{"127.0.0.1", alive.port()}, {"127.0.0.1", dying.port()}};
+    options.client_.retry_.methods_ = {{"EchoService.Echo", 1}};
+    options.client_.retry_.initial_backoff_ms_ = 1;
+    options.client_.retry_.budget_ratio_ = 1.0;
+    options.client_.reconnect_initial_backoff_ms_ = 10;
+    auto channel = std::make_unique<LoadBalancedChannel>(options, &scheduler);
+
+    auto method = EchoService::descriptor()->FindMethodByName("Echo");
+    for (int i = 0; i < 4; ++i)
+    {
+        auto request = new EchoRequest;
+        request->set_message("retry");
+        auto controller = new RpcController;
+        controller->SetTimeout(3000);
+        EchoResponse response;
+        Done done;
+        done.controller = controller;
+        auto result = done.result.get_future();
+        channel->CallMethod(method, controller, request, &response, &done);
+        ASSERT_EQ(result.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+        EXPECT_EQ(result.get(), ErrorCode::OK) << "call " << i;
+        EXPECT_EQ(response.message(), "retry");
+
+        std::promise<ErrorCode> coro;
+        auto coro_result = coro.get_future();
+        call_echo(channel.get(), &coro);
+        ASSERT_EQ(coro_result.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+        EXPECT_EQ(coro_result.get(), ErrorCode::OK) << "co_await call " << i;
+    }
+    EXPECT_EQ(dying.requests(), 1);
+    EXPECT_EQ(alive.requests(), 8);
+
+    channel.reset();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    scheduler.stop();
+}
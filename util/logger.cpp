@@ -0,0 +1,203 @@
+#include "logger.h"
+
+#include <ctime>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+namespace dRPC::util
+{
+    namespace
+    {
+        // logger析构后置位，之后的日志同步写出。不随静态对象析构，可在任意时刻读取
+        constinit std::atomic<bool> closed{false};
+
+        char level_char(LogLevel level)
+        {
+            switch (level)
+            {
+            case LogLevel::DEBUG:
+                return 'D';
+            case LogLevel::INFO:
+                return 'I';
+            case LogLevel::WARN:
+                return 'W';
+            default:
+                return 'E';
+            }
+        }
+
+        // 格式: [I 2024-01-01 12:00:00.123456 tid] message
+        void append_prefix(std::string &out, LogLevel level, int64_t time_us, int tid)
+        {
+            time_t seconds = time_us / 1000000;
+            struct tm tm;
+            localtime_r(&seconds, &tm);
+            char buf[64];
+            int len = snprintf(buf, sizeof(buf), "[%c %04d-%02d-%02d %02d:%02d:%02d.%06d %d] ",
+                               level_char(level), tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday,
+                               tm.tm_hour, tm.tm_min, tm.tm_sec, static_cast<int>(time_us % 1000000), tid);
+            out.append(buf, len);
+        }
+
+        int current_tid()
+        {
+            return static_cast<int>(::syscall(SYS_gettid));
+        }
+
+        int64_t wall_time_us()
+        {
+            return std::chrono::duration_cast<std::chrono::microseconds>(
+                       std::chrono::system_clock::now().time_since_epoch())
+                .count();
+        }
+
+        void write_all(FILE *file, const std::string &data)
+        {
+            if (!data.empty())
+            {
+                fwrite(data.data(), 1, data.size(), file);
+                fflush(file);
+            }
+        }
+    }
+
+    struct Logger::Impl
+    {
+        RingRegistry<LogRing> rings;
+
+        // writer线程和flush()都会消费环形缓冲，用drain_mutex保证单消费者
+        std::mutex drain_mutex;
+        std::atomic<FILE *> output{nullptr};
+        std::atomic<bool> stop{false};
+        std::thread writer;
+
+        // 空闲时writer阻塞等待，有线程提交日志或到达刷新间隔时醒来
+        static constexpr int FLUSH_INTERVAL_MS = 100;
+        std::mutex wake_mutex;
+        std::condition_variable wake_cv;
+        bool wake = false;
+
+        std::string out;
+        std::string err;
+
+        // 返回本轮写出的日志条数
+        size_t drain()
+        {
+            std::lock_guard<std::mutex> drain_lock(drain_mutex);
+            FILE *file = output.load(std::memory_order_relaxed);
+            size_t count = 0;
+            rings.for_each([&](LogRing &ring)
+                           {
+                               count += ring.consume([&](LogRecord &record)
+                                                     {
+                                                         std::string &buf = (file || record.level < LogLevel::WARN) ? out : err;
+                                                         append_prefix(buf, record.level, record.time_us, ring.tid());
+                                                         record.format(record, buf);
+                                                         buf.push_back('\n'); });
+                               if (int64_t dropped = ring.take_dropped(); dropped > 0)
+                               {
+                                   append_prefix(file ? out : err, LogLevel::WARN, wall_time_us(), ring.tid());
+                                   (file ? out : err).append(std::format("{} log messages dropped\n", dropped));
+                               } });
+
+            write_all(file ? file : stdout, out);
+            write_all(file ? file : stderr, err);
+            out.clear();
+            err.clear();
+            return count;
+        }
+
+        void run()
+        {
+            while (!stop.load(std::memory_order_relaxed))
+            {
+                if (drain() > 0)
+                {
+                    continue;
+                }
+                // 先声明空闲再检查一次，之后提交日志的线程负责唤醒
+                writer_idle_.store(true, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (drain() == 0)
+                {
+                    std::unique_lock<std::mutex> lock(wake_mutex);
+                    wake_cv.wait_for(lock, std::chrono::milliseconds(FLUSH_INTERVAL_MS), [this]()
+                                     { return wake || stop.load(std::memory_order_relaxed); });
+                    wake = false;
+                }
+                writer_idle_.store(false, std::memory_order_relaxed);
+            }
+            drain();
+        }
+    };
+
+    Logger::Logger() : impl_(new Impl)
+    {
+        impl_->writer = std::thread([this]()
+                                    { impl_->run(); });
+    }
+
+    Logger::~Logger()
+    {
+        closed.store(true, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(impl_->wake_mutex);
+            impl_->stop.store(true, std::memory_order_relaxed);
+        }
+        impl_->wake_cv.notify_one();
+        impl_->writer.join();
+        // 不释放impl_：其它线程可能正在注册环形缓冲或调用flush()
+    }
+
+    Logger &Logger::instance()
+    {
+        static Logger logger;
+        return logger;
+    }
+
+    LogRing *Logger::thread_ring()
+    {
+        thread_local RingRegistry<LogRing>::Holder holder;
+        if (closed.load(std::memory_order_relaxed))
+        {
+            return nullptr;
+        }
+        if (LogRing *ring = holder.get())
+        {
+            return ring;
+        }
+        return instance().impl_->rings.attach(holder, current_tid());
+    }
+
+    void Logger::write_now(LogLevel level, std::string_view message)
+    {
+        std::string line;
+        append_prefix(line, level, wall_time_us(), current_tid());
+        line.append(message);
+        line.push_back('\n');
+        write_all(level < LogLevel::WARN ? stdout : stderr, line);
+    }
+
+    void Logger::wake_writer()
+    {
+        auto &impl = *instance().impl_;
+        {
+            std::lock_guard<std::mutex> lock(impl.wake_mutex);
+            impl.wake = true;
+        }
+        impl.wake_cv.notify_one();
+    }
+
+    void Logger::set_output(FILE *file)
+    {
+        impl_->output.store(file, std::memory_order_relaxed);
+    }
+
+    void Logger::flush()
+    {
+        impl_->drain();
+    }
+}
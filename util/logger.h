@@ -0,0 +1,171 @@
+#pragma once
+
+#include <new>
+#include <tuple>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <format>
+#include <cstdint>
+#include <utility>
+#include <iterator>
+#include <string_view>
+#include <type_traits>
+
+#include "spsc_ring.h"
+
+// 编译期日志级别，低于该级别的日志语句连同参数求值一起被消除
+#define DRPC_LOG_LEVEL_DEBUG 0
+#define DRPC_LOG_LEVEL_INFO 1
+#define DRPC_LOG_LEVEL_WARN 2
+#define DRPC_LOG_LEVEL_ERROR 3
+
+#ifndef DRPC_LOG_LEVEL
+#define DRPC_LOG_LEVEL DRPC_LOG_LEVEL_INFO
+#endif
+
+namespace dRPC::util
+{
+    enum class LogLevel : int
+    {
+        DEBUG = DRPC_LOG_LEVEL_DEBUG,
+        INFO = DRPC_LOG_LEVEL_INFO,
+        WARN = DRPC_LOG_LEVEL_WARN,
+        ERROR = DRPC_LOG_LEVEL_ERROR,
+    };
+
+    // 一条日志：参数按值保存在inline存储中，由后台线程格式化
+    struct LogRecord
+    {
+        static constexpr size_t STORAGE_SIZE = 192;
+
+        // 格式化参数追加到out并析构参数
+        void (*format)(LogRecord &record, std::string &out);
+        std::string_view fmt;
+        int64_t time_us; // 墙上时钟
+        LogLevel level;
+        alignas(std::max_align_t) unsigned char args[STORAGE_SIZE];
+    };
+
+    // 每个写日志的线程一个，满时丢弃并计数
+    class LogRing : public SpscRing<LogRecord, 1024>
+    {
+    public:
+        explicit LogRing(int tid) : tid_(tid) {}
+
+        int tid() const { return tid_; }
+
+    private:
+        const int tid_;
+    };
+
+    // 后台写日志：各线程的环形缓冲由一个writer线程轮询，格式化后批量写出。
+    // 同一线程的日志保持顺序，不同线程之间按轮询顺序输出
+    class Logger
+    {
+    public:
+        static Logger &instance();
+
+        // 当前线程的环形缓冲，首次使用时注册；logger已关闭时返回nullptr
+        static LogRing *thread_ring();
+
+        // 同步输出一条已格式化的日志，logger关闭后或参数过大时使用
+        static void write_now(LogLevel level, std::string_view message);
+
+        // 提交日志后调用，writer线程空闲等待时唤醒它
+        static void notify()
+        {
+            // 与writer置位writer_idle_后再检查环形缓冲配对，保证不丢失唤醒
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (writer_idle_.load(std::memory_order_relaxed) && writer_idle_.exchange(false, std::memory_order_relaxed))
+            {
+                wake_writer();
+            }
+        }
+
+        // 输出到指定文件，nullptr表示INFO及以下写stdout，其余写stderr
+        void set_output(FILE *file);
+        // 等待此前提交的日志全部写出
+        void flush();
+
+        ~Logger();
+
+    private:
+        Logger();
+        static void wake_writer();
+
+        struct Impl;
+        Impl *impl_;
+        static inline std::atomic<bool> writer_idle_{false};
+    };
+
+    template <typename T>
+    using log_arg_t = std::conditional_t<std::is_convertible_v<const std::decay_t<T> &, std::string_view>,
+                                         std::string, std::decay_t<T>>;
+
+    template <typename... Args>
+    void format_record(LogRecord &record, std::string &out)
+    {
+        using Tuple = std::tuple<Args...>;
+        auto &args = *std::launder(reinterpret_cast<Tuple *>(record.args));
+        std::apply([&](auto &...arg)
+                   { std::vformat_to(std::back_inserter(out), record.fmt, std::make_format_args(arg...)); },
+                   args);
+        args.~Tuple();
+    }
+
+    // 参数拷贝进当前线程的环形缓冲，格式化推迟到writer线程。
+    // 字符串类参数复制为std::string，避免引用已释放的缓冲(如strerror、临时对象)
+    template <typename... Args>
+    void log(LogLevel level, std::format_string<Args...> fmt, Args &&...args)
+    {
+        using Tuple = std::tuple<log_arg_t<Args>...>;
+        LogRing *ring = Logger::thread_ring();
+        if (!ring)
+        {
+            Logger::write_now(level, std::format(fmt, std::forward<Args>(args)...));
+            return;
+        }
+        LogRecord *record = ring->reserve();
+        if (!record)
+        {
+            return;
+        }
+        if constexpr (sizeof(Tuple) <= LogRecord::STORAGE_SIZE && alignof(Tuple) <= alignof(std::max_align_t))
+        {
+            new (record->args) Tuple(std::forward<Args>(args)...);
+            record->format = &format_record<log_arg_t<Args>...>;
+            record->fmt = fmt.get();
+        }
+        else
+        {
+            // 参数放不进记录时退化为在调用线程格式化
+            new (record->args) std::tuple<std::string>(std::format(fmt, std::forward<Args>(args)...));
+            record->format = &format_record<std::string>;
+            record->fmt = "{}";
+        }
+        record->level = level;
+        record->time_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                              std::chrono::system_clock::now().time_since_epoch())
+                              .count();
+        ring->commit();
+        Logger::notify();
+    }
+}
+
+#define DRPC_LOG(level, fmt, ...)                                                                  \
+    do                                                                                             \
+    {                                                                                              \
+        if constexpr (static_cast<int>(level) >= DRPC_LOG_LEVEL)                                   \
+        {                                                                                          \
+            ::dRPC::util::log(level, fmt, ##__VA_ARGS__);                                          \
+        }                                                                                          \
+    } while (0)
+
+#define info(fmt, ...) DRPC_LOG(::dRPC::util::LogLevel::INFO, fmt, ##__VA_ARGS__)
+#define error(fmt, ...) DRPC_LOG(::dRPC::util::LogLevel::ERROR, fmt, ##__VA_ARGS__)
+
+// 新增级别带前缀，不占用debug、warn这类常见标识符(glibc <err.h>中有warn())
+#define DRPC_DEBUG(fmt, ...) DRPC_LOG(::dRPC::util::LogLevel::DEBUG, fmt, ##__VA_ARGS__)
+#define DRPC_WARN(fmt, ...) DRPC_LOG(::dRPC::util::LogLevel::WARN, fmt, ##__VA_ARGS__)
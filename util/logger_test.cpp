@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <sys/stat.h>
+
+#include "logger.h"
+// 日志宏不能与之后包含的系统头文件冲突
+#include <err.h>
+
+using dRPC::util::Logger;
+
+namespace
+{
+    // 把日志写到临时文件，读出全部内容
+    class LoggerTest : public ::testing::Test
+    {
+    protected:
+        void SetUp() override
+        {
+            file_ = tmpfile();
+            Logger::instance().set_output(file_);
+        }
+
+        void TearDown() override
+        {
+            Logger::instance().flush();
+            Logger::instance().set_output(nullptr);
+            fclose(file_);
+        }
+
+        std::vector<std::string> lines()
+        {
+            Logger::instance().flush();
+            std::vector<std::string> result;
+            rewind(file_);
+            char buf[512];
+            while (fgets(buf, sizeof(buf), file_))
+            {
+                std::string line(buf);
+                // 去掉"[I 2024-01-01 12:00:00.123456 tid] "前缀
+                result.push_back(line.substr(line.find("] ") + 2, line.size() - line.find("] ") - 3));
+            }
+            return result;
+        }
+
+        FILE *file_ = nullptr;
+    };
+}
+
+TEST_F(LoggerTest, DeferredArgumentsAreCopied)
+{
+    char buf[16];
+    strcpy(buf, "before");
+    info("value {} {} {}", 42, buf, std::string("temporary"));
+    strcpy(buf, "after");
+    error("error {:.1f}", 1.25);
+
+    auto result = lines();
+    ASSERT_EQ(result.size(), 2u);
+    EXPECT_EQ(result[0], "value 42 before temporary");
+    EXPECT_EQ(result[1], "error 1.2");
+}
+
+TEST_F(LoggerTest, DisabledLevelIsNotEvaluated)
+{
+    int evaluated = 0;
+    DRPC_DEBUG("debug {}", ++evaluated);
+    EXPECT_EQ(evaluated, 0);
+    EXPECT_TRUE(lines().empty());
+}
+
+TEST_F(LoggerTest, KeepsPerThreadOrder)
+{
+    constexpr int THREADS = 4;
+    constexpr int COUNT = 500;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; ++t)
+    {
+        threads.emplace_back([t]()
+                             {
+                                 for (int i = 0; i < COUNT; ++i)
+                                 {
+                                     info("{} {}", t, i);
+                                     if (i % 100 == 0)
+                                     {
+                                         std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                                     }
+                                 } });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    std::vector<int> next(THREADS, 0);
+    for (auto &line : lines())
+    {
+        int t = 0, i = 0;
+        ASSERT_EQ(sscanf(line.c_str(), "%d %d", &t, &i), 2);
+        EXPECT_EQ(i, next[t]);
+        next[t] = i + 1;
+    }
+    for (int t = 0; t < THREADS; ++t)
+    {
+        EXPECT_EQ(next[t], COUNT);
+    }
+}
+
+// 空闲的writer阻塞等待，提交日志后立即被唤醒，不必等到刷新间隔
+TEST_F(LoggerTest, WakesIdleWriter)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    auto start = std::chrono::steady_clock::now();
+    info("wake");
+    struct stat st{};
+    while (fstat(fileno(file_), &st) == 0 && st.st_size == 0 &&
+           std::chrono::steady_clock::now() - start < std::chrono::seconds(1))
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(50));
+    auto result = lines();
+    ASSERT_EQ(result.size(), 1u);
+    EXPECT_EQ(result[0], "wake");
+}
@@ -0,0 +1,179 @@
+#include "metrics.h"
+
+#include <format>
+#include <iterator>
+
+namespace dRPC::util
+{
+    void HistogramSnapshot::merge(const Histogram &histogram)
+    {
+        for (int i = 0; i < Histogram::BUCKETS; ++i)
+        {
+            uint64_t n = histogram.counts[i].load(std::memory_order_relaxed);
+            counts[i] += n;
+            count += n;
+        }
+        sum += histogram.sum.load(std::memory_order_relaxed);
+    }
+
+    uint64_t HistogramSnapshot::percentile(double p) const
+    {
+        if (count == 0)
+        {
+            return 0;
+        }
+        uint64_t rank = std::max<uint64_t>(static_cast<uint64_t>(p * count + 0.5), 1);
+        uint64_t seen = 0;
+        for (int i = 0; i < Histogram::BUCKETS; ++i)
+        {
+            seen += counts[i];
+            if (seen >= rank)
+            {
+                return Histogram::upper_bound(i);
+            }
+        }
+        return Histogram::upper_bound(Histogram::BUCKETS - 1);
+    }
+
+    uint64_t HistogramSnapshot::count_le(uint64_t value) const
+    {
+        uint64_t n = 0;
+        for (int i = 0; i < Histogram::BUCKETS && Histogram::upper_bound(i) <= value + 1; ++i)
+        {
+            n += counts[i];
+        }
+        return n;
+    }
+
+    MethodShard &MethodMetrics::local()
+    {
+        // 按方法id索引当前线程的分片，方法对象不释放，缓存的指针一直有效
+        thread_local std::vector<MethodShard *> shards;
+        if (id_ >= shards.size())
+        {
+            shards.resize(id_ + 1, nullptr);
+        }
+        if (!shards[id_])
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            shards_.push_back(std::make_unique<MethodShard>());
+            shards[id_] = shards_.back().get();
+        }
+        return *shards[id_];
+    }
+
+    MethodSnapshot MethodMetrics::snapshot() const
+    {
+        MethodSnapshot result;
+        result.side = side_;
+        result.name = name_;
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto &shard : shards_)
+        {
+            result.requests += shard->requests.load(std::memory_order_relaxed);
+            result.responses += shard->responses.load(std::memory_order_relaxed);
+            result.errors += shard->errors.load(std::memory_order_relaxed);
+            result.request_bytes += shard->request_bytes.load(std::memory_order_relaxed);
+            result.response_bytes += shard->response_bytes.load(std::memory_order_relaxed);
+            result.queue.merge(shard->queue);
+            result.handler.merge(shard->handler);
+            result.total.merge(shard->total);
+        }
+        return result;
+    }
+
+    MetricsRegistry &MetricsRegistry::instance()
+    {
+        // 不析构：退出时其它线程可能仍在记录
+        static MetricsRegistry *registry = new MetricsRegistry;
+        return *registry;
+    }
+
+    MethodMetrics *MetricsRegistry::method(std::string_view side, std::string_view name)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto &method : methods_)
+        {
+            if (method->side() == side && method->name() == name)
+            {
+                return method.get();
+            }
+        }
+        methods_.push_back(std::make_unique<MethodMetrics>(methods_.size(), std::string(side), std::string(name)));
+        return methods_.back().get();
+    }
+
+    std::vector<MethodSnapshot> MetricsRegistry::snapshot() const
+    {
+        std::vector<MethodMetrics *> methods;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (auto &method : methods_)
+            {
+                methods.push_back(method.get());
+            }
+        }
+        std::vector<MethodSnapshot> result;
+        for (auto method : methods)
+        {
+            result.push_back(method->snapshot());
+        }
+        return result;
+    }
+
+    namespace
+    {
+        // 导出的直方图边界(微秒)，由细粒度桶按上界近似累计
+        constexpr uint64_t EXPORT_BOUNDS[] = {50, 100, 250, 500, 1000, 2500, 5000, 10000, 25000,
+                                              50000, 100000, 250000, 500000, 1000000, 2500000, 10000000};
+
+        void append_counter(std::string &out, const std::vector<MethodSnapshot> &methods, const char *name,
+                            const char *help, uint64_t MethodSnapshot::*field)
+        {
+            std::format_to(std::back_inserter(out), "# HELP drpc_{} {}\n# TYPE drpc_{} counter\n", name, help, name);
+            for (auto &method : methods)
+            {
+                std::format_to(std::back_inserter(out), "drpc_{}{{side=\"{}\",method=\"{}\"}} {}\n",
+                               name, method.side, method.name, method.*field);
+            }
+        }
+
+        void append_histogram(std::string &out, const MethodSnapshot &method, const char *phase,
+                              const HistogramSnapshot &histogram)
+        {
+            if (histogram.count == 0)
+            {
+                return;
+            }
+            auto labels = std::format("side=\"{}\",method=\"{}\",phase=\"{}\"", method.side, method.name, phase);
+            for (uint64_t bound : EXPORT_BOUNDS)
+            {
+                std::format_to(std::back_inserter(out), "drpc_latency_us_bucket{{{},le=\"{}\"}} {}\n",
+                               labels, bound, histogram.count_le(bound));
+            }
+            std::format_to(std::back_inserter(out), "drpc_latency_us_bucket{{{},le=\"+Inf\"}} {}\n", labels, histogram.count);
+            std::format_to(std::back_inserter(out), "drpc_latency_us_sum{{{}}} {}\n", labels, histogram.sum);
+            std::format_to(std::back_inserter(out), "drpc_latency_us_count{{{}}} {}\n", labels, histogram.count);
+        }
+    }
+
+    std::string MetricsRegistry::dump_prometheus() const
+    {
+        auto methods = snapshot();
+        std::string out;
+        append_counter(out, methods, "requests_total", "Requests sent or received.", &MethodSnapshot::requests);
+        append_counter(out, methods, "responses_total", "Calls completed.", &MethodSnapshot::responses);
+        append_counter(out, methods, "errors_total", "Calls completed with an error.", &MethodSnapshot::errors);
+        append_counter(out, methods, "request_bytes_total", "Request frame bytes.", &MethodSnapshot::request_bytes);
+        append_counter(out, methods, "response_bytes_total", "Response frame bytes.", &MethodSnapshot::response_bytes);
+
+        out.append("# HELP drpc_latency_us Call latency by phase in microseconds.\n# TYPE drpc_latency_us histogram\n");
+        for (auto &method : methods)
+        {
+            append_histogram(out, method, "queue", method.queue);
+            append_histogram(out, method, "handler", method.handler);
+            append_histogram(out, method, "total", method.total);
+        }
+        return out;
+    }
+}
@@ -0,0 +1,180 @@
+#pragma once
+
+#include <bit>
+#include <algorithm>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <string_view>
+
+namespace dRPC::util
+{
+    // 单写者计数：每个分片只由所属线程写，读线程合并，普通load/store即可，不需要原子读改写
+    inline void bump(std::atomic<uint64_t> &counter, uint64_t n = 1)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    // 对数分桶直方图(HDR风格)：每个2的幂区间再分SUB_BUCKETS个子桶，相对误差约12.5%，单位微秒
+    struct Histogram
+    {
+        static constexpr int SUB_BITS = 3;
+        static constexpr int SUB_BUCKETS = 1 << SUB_BITS;
+        static constexpr int MAX_BITS = 40; // 约12天
+        static constexpr int BUCKETS = (MAX_BITS - SUB_BITS + 1) * SUB_BUCKETS;
+
+        static int bucket_of(uint64_t value)
+        {
+            if (value < SUB_BUCKETS)
+            {
+                return static_cast<int>(value);
+            }
+            int exp = std::bit_width(value) - 1;
+            int index = (exp - SUB_BITS + 1) * SUB_BUCKETS + static_cast<int>((value >> (exp - SUB_BITS)) & (SUB_BUCKETS - 1));
+            return std::min(index, BUCKETS - 1);
+        }
+        // 桶的取值范围[lower, upper)
+        static uint64_t lower_bound(int bucket)
+        {
+            if (bucket < SUB_BUCKETS)
+            {
+                return bucket;
+            }
+            int exp = bucket / SUB_BUCKETS + SUB_BITS - 1;
+            return static_cast<uint64_t>(SUB_BUCKETS + bucket % SUB_BUCKETS) << (exp - SUB_BITS);
+        }
+        static uint64_t upper_bound(int bucket)
+        {
+            return bucket + 1 < BUCKETS ? lower_bound(bucket + 1) : UINT64_MAX;
+        }
+
+        void record(int64_t value)
+        {
+            uint64_t v = value > 0 ? static_cast<uint64_t>(value) : 0;
+            bump(counts[bucket_of(v)]);
+            bump(sum, v);
+        }
+
+        std::atomic<uint64_t> counts[BUCKETS] = {};
+        std::atomic<uint64_t> sum{0};
+    };
+
+    // 合并后的直方图
+    struct HistogramSnapshot
+    {
+        std::vector<uint64_t> counts = std::vector<uint64_t>(Histogram::BUCKETS);
+        uint64_t count = 0;
+        uint64_t sum = 0;
+
+        void merge(const Histogram &histogram);
+        // 返回所在桶的上界，没有样本返回0
+        uint64_t percentile(double p) const;
+        // 小于等于value的样本数，按桶上界近似
+        uint64_t count_le(uint64_t value) const;
+    };
+
+    // 单个方法在一个线程上的统计
+    struct MethodShard
+    {
+        std::atomic<uint64_t> requests{0};
+        std::atomic<uint64_t> responses{0};
+        std::atomic<uint64_t> errors{0};
+        std::atomic<uint64_t> request_bytes{0};
+        std::atomic<uint64_t> response_bytes{0};
+        Histogram queue;   // 到达/发起到开始处理/发送
+        Histogram handler; // handler执行时间，仅服务端
+        Histogram total;   // 完整耗时
+    };
+
+    struct MethodSnapshot
+    {
+        std::string side;
+        std::string name;
+        uint64_t requests = 0;
+        uint64_t responses = 0;
+        uint64_t errors = 0;
+        uint64_t request_bytes = 0;
+        uint64_t response_bytes = 0;
+        HistogramSnapshot queue;
+        HistogramSnapshot handler;
+        HistogramSnapshot total;
+    };
+
+    // 一个方法的统计，按线程分片记录，读取时合并。由MetricsRegistry创建，进程内不释放
+    class MethodMetrics
+    {
+    public:
+        MethodMetrics(size_t id, std::string side, std::string name)
+            : id_(id), side_(std::move(side)), name_(std::move(name)) {}
+
+        void on_request(uint64_t request_bytes)
+        {
+            MethodShard &shard = local();
+            bump(shard.requests);
+            bump(shard.request_bytes, request_bytes);
+        }
+        // 耗时为负表示该阶段不适用
+        void on_response(uint64_t response_bytes, bool failed, int64_t queue_us, int64_t handler_us, int64_t total_us)
+        {
+            MethodShard &shard = local();
+            bump(shard.responses);
+            bump(shard.response_bytes, response_bytes);
+            if (failed)
+            {
+                bump(shard.errors);
+            }
+            if (queue_us >= 0)
+            {
+                shard.queue.record(queue_us);
+            }
+            if (handler_us >= 0)
+            {
+                shard.handler.record(handler_us);
+            }
+            if (total_us >= 0)
+            {
+                shard.total.record(total_us);
+            }
+        }
+
+        // 当前线程的分片
+        MethodShard &local();
+        MethodSnapshot snapshot() const;
+
+        size_t id() const { return id_; }
+        const std::string &side() const { return side_; }
+        const std::string &name() const { return name_; }
+
+    private:
+        const size_t id_;
+        const std::string side_;
+        const std::string name_;
+
+        mutable std::mutex mutex_;
+        std::vector<std::unique_ptr<MethodShard>> shards_;
+    };
+
+    // 进程内所有方法的统计，side为"server"或"client"，字节数包含帧头
+    class MetricsRegistry
+    {
+    public:
+        static MetricsRegistry &instance();
+
+        // 查找或创建，返回的指针在进程内一直有效。加锁，调用方应缓存结果
+        MethodMetrics *method(std::string_view side, std::string_view name);
+
+        std::vector<MethodSnapshot> snapshot() const;
+
+        // Prometheus文本格式
+        std::string dump_prometheus() const;
+
+    private:
+        MetricsRegistry() = default;
+
+        mutable std::mutex mutex_;
+        std::vector<std::unique_ptr<MethodMetrics>> methods_;
+    };
+}
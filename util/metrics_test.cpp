@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+#include "metrics.h"
+
+using dRPC::util::Histogram;
+using dRPC::util::HistogramSnapshot;
+using dRPC::util::MetricsRegistry;
+
+TEST(MetricsTest, HistogramBuckets)
+{
+    // 桶连续且覆盖每个取值
+    for (uint64_t v : {0ull, 1ull, 7ull, 8ull, 15ull, 16ull, 100ull, 1000ull, 123456ull, 1ull << 35})
+    {
+        int bucket = Histogram::bucket_of(v);
+        EXPECT_LE(Histogram::lower_bound(bucket), v);
+        EXPECT_LT(v, Histogram::upper_bound(bucket));
+    }
+    for (int i = 0; i + 1 < Histogram::BUCKETS; ++i)
+    {
+        EXPECT_EQ(Histogram::upper_bound(i), Histogram::lower_bound(i + 1));
+    }
+}
+
+TEST(MetricsTest, Percentile)
+{
+    Histogram histogram;
+    for (int i = 1; i <= 1000; ++i)
+    {
+        histogram.record(i);
+    }
+    HistogramSnapshot snapshot;
+    snapshot.merge(histogram);
+    EXPECT_EQ(snapshot.count, 1000u);
+    EXPECT_EQ(snapshot.sum, 500500u);
+    // 相对误差不超过一个子桶(12.5%)
+    EXPECT_NEAR(static_cast<double>(snapshot.percentile(0.5)), 500, 500 * 0.125);
+    EXPECT_NEAR(static_cast<double>(snapshot.percentile(0.99)), 990, 990 * 0.125);
+    EXPECT_EQ(snapshot.count_le(7), 7u);
+}
+
+TEST(MetricsTest, MergeThreadShards)
+{
+    auto metrics = MetricsRegistry::instance().method("server", "Test.Merge");
+    EXPECT_EQ(metrics, MetricsRegistry::instance().method("server", "Test.Merge"));
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([metrics]()
+                             {
+                                 for (int i = 0; i < 1000; ++i)
+                                 {
+                                     metrics->on_request(10);
+                                     metrics->on_response(20, i % 10 == 0, 5, 50, 100);
+                                 } });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    auto snapshot = metrics->snapshot();
+    EXPECT_EQ(snapshot.requests, 4000u);
+    EXPECT_EQ(snapshot.responses, 4000u);
+    EXPECT_EQ(snapshot.errors, 400u);
+    EXPECT_EQ(snapshot.request_bytes, 40000u);
+    EXPECT_EQ(snapshot.response_bytes, 80000u);
+    EXPECT_EQ(snapshot.handler.count, 4000u);
+
+    auto text = MetricsRegistry::instance().dump_prometheus();
+    EXPECT_NE(text.find("drpc_requests_total{side=\"server\",method=\"Test.Merge\"} 4000"), std::string::npos);
+    EXPECT_NE(text.find("drpc_latency_us_bucket{side=\"server\",method=\"Test.Merge\",phase=\"total\",le=\"250\"} 4000"),
+              std::string::npos);
+}
@@ -2,6 +2,7 @@
 
 #include <atomic>
 #include <memory>
+#include <mutex>
 #include <thread>
 #include <optional>
 #include <type_traits>
@@ -9,6 +10,8 @@
 
 namespace dRPC::util
 {
+    // 无界MPMC队列：元素存放在按块链接的槽位中，push总是成功，队列空时pop返回false。
+    // 生产者和消费者都可以有多个；消费完的块在没有线程访问后放回空闲列表复用
     template <typename T>
     class MPMCQueue
     {
@@ -54,12 +57,16 @@ namespace dRPC::util
             size_t size;
             std::atomic<size_t> push_index;
             std::atomic<size_t> pop_index;
+            // 正在访问本块的生产者/消费者数，块摘下(retired)后两者都归零才回收，
+            // 避免持有旧指针的线程写入或读取已被复用的块
+            std::atomic<size_t> active_writers;
             std::atomic<size_t> active_readers;
             std::atomic<bool> retired;
 
             Chunk(size_t chunk_size) : next(nullptr), size(chunk_size), push_index(0), pop_index(0)
             {
                 nodes = new Node[chunk_size];
+                active_writers.store(0, std::memory_order_relaxed);
                 active_readers.store(0, std::memory_order_relaxed);
                 retired.store(false, std::memory_order_relaxed);
             }
@@ -78,7 +85,8 @@ namespace dRPC::util
 
         alignas(64) std::atomic<Chunk *> head_chunk;
         alignas(64) std::atomic<Chunk *> tail_chunk;
-        alignas(64) std::atomic<Chunk *> free_list;
+        alignas(64) std::mutex free_mutex; // 空闲块很少分配，用锁避免无锁栈的ABA问题
+        Chunk *free_list;
         std::atomic<size_t> chunk_count;
 
     public:
@@ -103,7 +111,7 @@ namespace dRPC::util
             }
 
             // 清理空闲列表
-            current = free_list.load(std::memory_order_relaxed);
+            current = free_list;
             while (current)
             {
                 Chunk *next = current->next.load(std::memory_order_relaxed);
@@ -122,38 +130,37 @@ namespace dRPC::util
         {
             while (true)
             {
-                Chunk *tail = tail_chunk.load(std::memory_order_acquire);
+                Chunk *tail = enter(tail_chunk, &Chunk::active_writers);
                 size_t index = tail->push_index.fetch_add(1, std::memory_order_relaxed);
 
                 if (index < tail->size)
                 {
-                    // 当前块还有空间
-                    Node &node = tail->nodes[index];
-                    if (!node.occupied.load(std::memory_order_acquire))
-                    {
-                        node.construct(std::move(value));
-                        return true;
-                    }
+                    // 当前块还有空间，槽位由本线程独占
+                    tail->nodes[index].construct(std::move(value));
+                    leave(tail, &Chunk::active_writers);
+                    return true;
                 }
-                else
+
+                // 当前块已满，链接新块(或其它线程已链接的块)并推进tail
+                Chunk *next = tail->next.load(std::memory_order_acquire);
+                if (!next)
                 {
-                    // 当前块已满，需要新块
                     Chunk *new_chunk = allocate_chunk();
                     Chunk *expected = nullptr;
-                    if (tail->next.compare_exchange_strong(expected, new_chunk, std::memory_order_release, std::memory_order_relaxed))
+                    if (tail->next.compare_exchange_strong(expected, new_chunk, std::memory_order_acq_rel, std::memory_order_acquire))
                     {
-                        tail_chunk.store(new_chunk, std::memory_order_release);
+                        next = new_chunk;
                     }
                     else
                     {
                         // 其它线程已经添加了新块，释放我们创建的块
                         release_chunk(new_chunk);
-                        if (expected)
-                        {
-                            tail_chunk.compare_exchange_strong(tail, expected, std::memory_order_release, std::memory_order_relaxed);
-                        }
+                        next = expected;
                     }
                 }
+                Chunk *expected_tail = tail;
+                tail_chunk.compare_exchange_strong(expected_tail, next);
+                leave(tail, &Chunk::active_writers);
             }
         }
 
@@ -161,49 +168,41 @@ namespace dRPC::util
         {
             while (true)
             {
-                Chunk *head = head_chunk.load(std::memory_order_acquire);
-                if (!head)
-                    return false;
-
+                Chunk *head = enter(head_chunk, &Chunk::active_readers);
                 size_t index = head->pop_index.load(std::memory_order_acquire);
-                size_t push_idx = head->push_index.load(std::memory_order_acquire);
 
                 if (index >= head->size)
                 {
-                    // 当前块已经消费完，移动到下一个块
+                    // 当前块的槽位都已被领取，移动到下一个块；下一个块尚未链接时队列为空
                     Chunk *next = head->next.load(std::memory_order_acquire);
-                    if (next && head_chunk.compare_exchange_strong(head, next, std::memory_order_release, std::memory_order_relaxed))
+                    if (!next)
                     {
-                        retire_chunk(head);
+                        leave(head, &Chunk::active_readers);
+                        return false;
                     }
-                    else if (!next)
+                    Chunk *expected = head;
+                    if (head_chunk.compare_exchange_strong(expected, next))
                     {
-                        return false;
+                        retire_chunk(head, next);
                     }
+                    leave(head, &Chunk::active_readers);
                     continue;
                 }
 
-                if (index >= push_idx)
+                // 只领取生产者已预留的槽位，其余情况队列为空
+                if (index >= head->push_index.load(std::memory_order_acquire))
                 {
-                    Chunk *next = head->next.load(std::memory_order_acquire);
-                    if (!next)
-                    {
-                        return false;
-                    }
-                    if (head_chunk.compare_exchange_strong(head, next, std::memory_order_release, std::memory_order_relaxed))
-                    {
-                        retire_chunk(head);
-                    }
-                    continue;
+                    leave(head, &Chunk::active_readers);
+                    return false;
                 }
 
                 if (!head->pop_index.compare_exchange_weak(index, index + 1, std::memory_order_acq_rel, std::memory_order_relaxed))
                 {
+                    leave(head, &Chunk::active_readers);
                     continue;
                 }
 
-                head->active_readers.fetch_add(1, std::memory_order_acquire);
-
+                // 槽位已预留，等待生产者写入
                 Node &node = head->nodes[index];
                 while (!node.occupied.load(std::memory_order_acquire))
                 {
@@ -215,28 +214,47 @@ namespace dRPC::util
                 // 调用析构函数
                 node.destroy();
 
-                head->active_readers.fetch_sub(1, std::memory_order_release);
-                try_release_chunk(head);
-
+                leave(head, &Chunk::active_readers);
                 return true;
             }
         }
 
     private:
+        // 登记为当前head/tail块的访问者。登记后再次确认块仍是head/tail，否则块可能已被摘下或复用；
+        // 与retire_chunk先移动head/tail再检查计数相配合(均为seq_cst)，回收时不会漏掉访问者
+        Chunk *enter(std::atomic<Chunk *> &slot, std::atomic<size_t> Chunk::*counter)
+        {
+            while (true)
+            {
+                Chunk *chunk = slot.load();
+                (chunk->*counter).fetch_add(1);
+                if (slot.load() == chunk)
+                {
+                    return chunk;
+                }
+                leave(chunk, counter);
+            }
+        }
+
+        void leave(Chunk *chunk, std::atomic<size_t> Chunk::*counter)
+        {
+            (chunk->*counter).fetch_sub(1);
+            try_release_chunk(chunk);
+        }
+
         Chunk *allocate_chunk()
         {
             // 首先尝试从空闲列表获取
-            Chunk *chunk = free_list.load(std::memory_order_acquire);
-            while (chunk)
             {
-                if (free_list.compare_exchange_weak(chunk, chunk->next.load(std::memory_order_relaxed), std::memory_order_release, std::memory_order_relaxed))
+                std::lock_guard<std::mutex> lock(free_mutex);
+                Chunk *chunk = free_list;
+                if (chunk)
                 {
-                    // 重置块状态
+                    free_list = chunk->next.load(std::memory_order_relaxed);
+                    // 重置块状态；访问计数可能仍有未能登记的线程在增减，保持不变
                     chunk->push_index.store(0, std::memory_order_relaxed);
                     chunk->pop_index.store(0, std::memory_order_relaxed);
                     chunk->next.store(nullptr, std::memory_order_relaxed);
-                    chunk->active_readers.store(0, std::memory_order_relaxed);
-                    chunk->retired.store(false, std::memory_order_relaxed);
                     return chunk;
                 }
             }
@@ -252,31 +270,27 @@ namespace dRPC::util
                 return;
 
             // 将块加入空闲列表
-            Chunk *old_head = free_list.load(std::memory_order_acquire);
-            chunk->next.store(old_head, std::memory_order_relaxed);
-
-            while (!free_list.compare_exchange_weak(old_head, chunk, std::memory_order_release, std::memory_order_relaxed))
-            {
-                chunk->next.store(old_head, std::memory_order_relaxed);
-            }
+            std::lock_guard<std::mutex> lock(free_mutex);
+            chunk->next.store(free_list, std::memory_order_relaxed);
+            free_list = chunk;
         }
 
-        void retire_chunk(Chunk *chunk)
+        // head已从chunk移到next，推进仍停在chunk上的tail，之后不会再有线程登记到chunk
+        void retire_chunk(Chunk *chunk, Chunk *next)
         {
-            if (!chunk)
-                return;
-            chunk->retired.store(true, std::memory_order_release);
+            Chunk *expected = chunk;
+            tail_chunk.compare_exchange_strong(expected, next);
+            chunk->retired.store(true);
             try_release_chunk(chunk);
         }
 
+        // 已摘下且没有访问者时回收，retired标记保证只回收一次
         void try_release_chunk(Chunk *chunk)
         {
-            if (!chunk)
-                return;
-            if (chunk->active_readers.load(std::memory_order_acquire) == 0)
+            if (chunk->active_writers.load() == 0 && chunk->active_readers.load() == 0)
             {
                 bool expected = true;
-                if (chunk->retired.compare_exchange_strong(expected, false, std::memory_order_acq_rel, std::memory_order_relaxed))
+                if (chunk->retired.compare_exchange_strong(expected, false))
                 {
                     release_chunk(chunk);
                 }
@@ -408,4 +408,54 @@ TEST_F(MPMCQueueTest, LongRunningTest)
     consumer.join();
 
     std::cout << "Long running test completed successfully" << std::endl;
-}
\ No newline at end of file
+}
+// 多消费者反复跨块：块被摘下复用时持有旧指针的线程不能写入或领取复用后的槽位，元素不丢失不重复
+TEST_F(MPMCQueueTest, ChunkReuseWithMultipleConsumers)
+{
+    dRPC::util::MPMCQueue<int> queue;
+    const int NUM_PRODUCERS = 8;
+    const int NUM_CONSUMERS = 8;
+    const int ITEMS_PER_PRODUCER = 20000;
+    const int TOTAL_ITEMS = NUM_PRODUCERS * ITEMS_PER_PRODUCER;
+
+    std::atomic<int> consumed_count{0};
+    std::vector<std::atomic<int>> seen(TOTAL_ITEMS);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < NUM_PRODUCERS; ++i)
+    {
+        threads.emplace_back([&, producer_id = i]()
+                             {
+            for (int j = 0; j < ITEMS_PER_PRODUCER; ++j) {
+                queue.push(producer_id * ITEMS_PER_PRODUCER + j);
+            } });
+    }
+    for (int i = 0; i < NUM_CONSUMERS; ++i)
+    {
+        threads.emplace_back([&]()
+                             {
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+            while (consumed_count.load() < TOTAL_ITEMS && std::chrono::steady_clock::now() < deadline) {
+                int item;
+                if (queue.pop(item)) {
+                    seen[item].fetch_add(1, std::memory_order_relaxed);
+                    consumed_count.fetch_add(1, std::memory_order_relaxed);
+                } else {
+                    std::this_thread::yield();
+                }
+            } });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    EXPECT_EQ(consumed_count.load(), TOTAL_ITEMS);
+    int wrong = 0;
+    for (auto &count : seen)
+    {
+        wrong += count.load() != 1;
+    }
+    EXPECT_EQ(wrong, 0);
+    int item;
+    EXPECT_FALSE(queue.pop(item));
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <algorithm>
+
+namespace dRPC::util
+{
+    // 重试预算：每个正常请求存入ratio个令牌，每次重试消耗1个令牌，
+    // 令牌不足时不再重试，保证重试流量不超过正常流量的ratio倍，避免重试放大故障。
+    // 令牌以千分之一为单位存放，可在多线程中并发使用
+    class RetryBudget
+    {
+    public:
+        explicit RetryBudget(double ratio = 0.1, int min_tokens = 10, int max_tokens = 100)
+            : deposit_(static_cast<int64_t>(std::max(ratio, 0.0) * UNIT)),
+              max_(static_cast<int64_t>(std::max(max_tokens, min_tokens)) * UNIT),
+              balance_(static_cast<int64_t>(min_tokens) * UNIT) {}
+
+        void deposit()
+        {
+            int64_t balance = balance_.load(std::memory_order_relaxed);
+            while (balance < max_ &&
+                   !balance_.compare_exchange_weak(balance, std::min(balance + deposit_, max_), std::memory_order_relaxed))
+            {
+            }
+        }
+
+        bool try_withdraw()
+        {
+            int64_t balance = balance_.load(std::memory_order_relaxed);
+            while (balance >= UNIT)
+            {
+                if (balance_.compare_exchange_weak(balance, balance - UNIT, std::memory_order_relaxed))
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // 当前可用的重试次数
+        int64_t tokens() const { return balance_.load(std::memory_order_relaxed) / UNIT; }
+
+    private:
+        static constexpr int64_t UNIT = 1000;
+
+        const int64_t deposit_;
+        const int64_t max_;
+        std::atomic<int64_t> balance_;
+    };
+}
@@ -0,0 +1,33 @@
+#include <gtest/gtest.h>
+
+#include "retry_budget.h"
+
+using dRPC::util::RetryBudget;
+
+TEST(RetryBudgetTest, WithdrawUntilEmpty)
+{
+    RetryBudget budget(0.1, 2, 10);
+    EXPECT_EQ(budget.tokens(), 2);
+    EXPECT_TRUE(budget.try_withdraw());
+    EXPECT_TRUE(budget.try_withdraw());
+    EXPECT_FALSE(budget.try_withdraw());
+
+    // 10个正常请求换1次重试
+    for (int i = 0; i < 9; ++i)
+    {
+        budget.deposit();
+    }
+    EXPECT_FALSE(budget.try_withdraw());
+    budget.deposit();
+    EXPECT_TRUE(budget.try_withdraw());
+}
+
+TEST(RetryBudgetTest, CappedAtMax)
+{
+    RetryBudget budget(1.0, 0, 3);
+    for (int i = 0; i < 100; ++i)
+    {
+        budget.deposit();
+    }
+    EXPECT_EQ(budget.tokens(), 3);
+}
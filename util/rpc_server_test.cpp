@@ -0,0 +1,57 @@
+#include <gtest/gtest.h>
+
+#include <span>
+#include <string_view>
+
+#include "server/rpc_server.h"
+#include "example/echo.pb.h"
+
+using namespace dRPC;
+
+namespace
+{
+    // 方法ID由构造参数给出，用于构造FNV-1a冲突
+    class FakeService : public GeneratedService
+    {
+    public:
+        FakeService(const char *first, uint32_t first_id, const char *second, uint32_t second_id)
+            : methods_{MethodInfo{first_id, first, &EchoRequest::default_instance(), &EchoResponse::default_instance()},
+                       MethodInfo{second_id, second, &EchoRequest::default_instance(), &EchoResponse::default_instance()}} {}
+
+        std::string_view service_name() const override { return "test.FakeService"; }
+        std::span<const MethodInfo> methods() const override { return methods_; }
+        void call_method(uint32_t, dRPC::RpcController *, const google::protobuf::Message *,
+                         google::protobuf::Message *, google::protobuf::Closure *done) override
+        {
+            done->Run();
+        }
+
+    private:
+        MethodInfo methods_[2];
+    };
+}
+
+// 方法ID冲突时注册失败，而不是保留先注册的方法把请求分发到错误的handler
+TEST(RpcServerTest, RejectsConflictingMethodIds)
+{
+    RpcServer server(RpcServerOptions(0));
+
+    FakeService first("test.A.Foo", method_id("test.A.Foo"), "test.A.Bar", method_id("test.A.Bar"));
+    EXPECT_TRUE(server.register_service(&first));
+
+    // 与已注册的方法冲突
+    FakeService other("test.B.Foo", method_id("test.A.Foo"), "test.B.Baz", method_id("test.B.Baz"));
+    EXPECT_FALSE(server.register_service(&other));
+    // 冲突的服务整个未注册，其中不冲突的方法仍可由其它服务注册
+    FakeService retry("test.C.Baz", method_id("test.B.Baz"), "test.C.Qux", method_id("test.C.Qux"));
+    EXPECT_TRUE(server.register_service(&retry));
+
+    // 同一服务内部冲突
+    FakeService self("test.D.One", 42, "test.D.Two", 42);
+    EXPECT_FALSE(server.register_service(&self));
+    FakeService after("test.E.One", 42, "test.E.Two", 43);
+    EXPECT_TRUE(server.register_service(&after));
+
+    // 重复注册同一服务
+    EXPECT_FALSE(server.register_service(&first));
+}
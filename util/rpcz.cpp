@@ -0,0 +1,339 @@
+#include "rpcz.h"
+
+#include <ctime>
+#include <thread>
+#include <format>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <algorithm>
+#include <signal.h>
+#include <semaphore.h>
+
+#include "clock.h"
+
+namespace dRPC::util
+{
+    namespace
+    {
+        bool slower(const RpcRecord &a, const RpcRecord &b)
+        {
+            return a.total_us > b.total_us;
+        }
+
+        int64_t wall_time_us()
+        {
+            return std::chrono::duration_cast<std::chrono::microseconds>(
+                       std::chrono::system_clock::now().time_since_epoch())
+                .count();
+        }
+
+        void append_header(std::string &out)
+        {
+            std::format_to(std::back_inserter(out), "{:<15} {:<6} {:<36} {:<21} {:>6} {:>8} {:>8} {:>8} {:>10} {:>10} {:>6} {:<16}\n",
+                           "time", "side", "method", "peer", "status", "req_b", "resp_b", "queue_us", "handler_us",
+                           "total_us", "id", "trace_id");
+        }
+
+        void append_record(std::string &out, const RpcRecord &record, int64_t wall_offset_us)
+        {
+            int64_t wall_us = record.start_us + wall_offset_us;
+            time_t seconds = wall_us / 1000000;
+            struct tm tm;
+            localtime_r(&seconds, &tm);
+            char time[32];
+            snprintf(time, sizeof(time), "%02d:%02d:%02d.%06d", tm.tm_hour, tm.tm_min, tm.tm_sec,
+                     static_cast<int>(wall_us % 1000000));
+            std::string trace = record.trace_id ? std::format("{:016x}", record.trace_id) : "-";
+            std::format_to(std::back_inserter(out), "{:<15} {:<6} {:<36} {:<21} {:>6} {:>8} {:>8} {:>8} {:>10} {:>10} {:>6} {:<16}\n",
+                           time, record.method->side(), record.method->name(),
+                           std::format("{}:{}", record.peer_ip, record.peer_port), record.error_code,
+                           record.request_bytes, record.response_bytes, record.queue_us, record.handler_us,
+                           record.total_us, record.request_id, trace);
+        }
+
+        // 信号处理函数只能调用异步信号安全的函数，转储由等待线程完成
+        sem_t dump_sem;
+
+        void on_dump_signal(int)
+        {
+            sem_post(&dump_sem);
+        }
+    }
+
+    void RpcRecord::set_peer(std::string_view ip, int port)
+    {
+        size_t len = std::min(ip.size(), sizeof(peer_ip) - 1);
+        memcpy(peer_ip, ip.data(), len);
+        peer_ip[len] = '\0';
+        peer_port = static_cast<uint16_t>(port);
+    }
+
+    Rpcz &Rpcz::instance()
+    {
+        // 不析构：退出时其它线程可能仍在记录
+        static Rpcz *rpcz = new Rpcz;
+        return *rpcz;
+    }
+
+    void Rpcz::configure(const RpczOptions &options)
+    {
+        recent_per_thread_.store(std::max<size_t>(options.recent_per_thread_, 1), std::memory_order_relaxed);
+        slowest_per_method_.store(std::max<size_t>(options.slowest_per_method_, 1), std::memory_order_relaxed);
+        int64_t window_ms = std::max<int64_t>(options.slowest_window_ms_, 1);
+        if (slowest_window_ms_.exchange(window_ms, std::memory_order_relaxed) == window_ms)
+        {
+            return;
+        }
+        // 窗口长度改变后窗口编号不可比较，清空已保留的最慢调用
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto &set : slowest_)
+        {
+            if (set)
+            {
+                std::lock_guard<std::mutex> set_lock(set->mutex);
+                set->records.clear();
+                set->previous.clear();
+                set->threshold.store(-1, std::memory_order_relaxed);
+                set->window.store(-1, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    Rpcz::RecentRing &Rpcz::local_ring()
+    {
+        thread_local RecentRing *ring = nullptr;
+        if (!ring)
+        {
+            auto owned = std::make_unique<RecentRing>();
+            owned->capacity = recent_per_thread_.load(std::memory_order_relaxed);
+            owned->records.reserve(owned->capacity);
+            ring = owned.get();
+            std::lock_guard<std::mutex> lock(mutex_);
+            rings_.push_back(std::move(owned));
+        }
+        return *ring;
+    }
+
+    Rpcz::SlowestSet &Rpcz::slowest_set(size_t method_id)
+    {
+        // 与MethodMetrics::local相同，按方法id缓存，集合不释放
+        thread_local std::vector<SlowestSet *> sets;
+        if (method_id >= sets.size())
+        {
+            sets.resize(method_id + 1, nullptr);
+        }
+        if (!sets[method_id])
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (method_id >= slowest_.size())
+            {
+                slowest_.resize(method_id + 1);
+            }
+            if (!slowest_[method_id])
+            {
+                slowest_[method_id] = std::make_unique<SlowestSet>();
+            }
+            sets[method_id] = slowest_[method_id].get();
+        }
+        return *sets[method_id];
+    }
+
+    void Rpcz::record(const RpcRecord &record)
+    {
+        if (!enabled())
+        {
+            return;
+        }
+        RecentRing &ring = local_ring();
+        {
+            std::lock_guard<std::mutex> lock(ring.mutex);
+            if (ring.records.size() < ring.capacity)
+            {
+                ring.records.push_back(record);
+            }
+            else
+            {
+                ring.records[ring.next] = record;
+            }
+            ring.next = (ring.next + 1) % ring.capacity;
+        }
+
+        SlowestSet &set = slowest_set(record.method->id());
+        int64_t window = current_window();
+        if (window != set.window.load(std::memory_order_relaxed) ||
+            record.total_us > set.threshold.load(std::memory_order_relaxed))
+        {
+            offer_slowest(set, record, window);
+        }
+    }
+
+    int64_t Rpcz::current_window() const
+    {
+        return now_us() / (slowest_window_ms_.load(std::memory_order_relaxed) * 1000);
+    }
+
+    void Rpcz::rotate(SlowestSet &set, int64_t window)
+    {
+        int64_t current = set.window.load(std::memory_order_relaxed);
+        if (window <= current)
+        {
+            return;
+        }
+        // 上一个窗口的记录保留一个窗口，跳过空窗口时一并丢弃
+        if (window == current + 1)
+        {
+            set.previous.swap(set.records);
+        }
+        else
+        {
+            set.previous.clear();
+        }
+        set.records.clear();
+        set.threshold.store(-1, std::memory_order_relaxed);
+        set.window.store(window, std::memory_order_relaxed);
+    }
+
+    void Rpcz::offer_slowest(SlowestSet &set, const RpcRecord &record, int64_t window)
+    {
+        size_t capacity = slowest_per_method_.load(std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(set.mutex);
+        rotate(set, window);
+        if (set.records.size() < capacity)
+        {
+            set.records.push_back(record);
+            std::push_heap(set.records.begin(), set.records.end(), slower);
+        }
+        else if (record.total_us > set.records.front().total_us)
+        {
+            std::pop_heap(set.records.begin(), set.records.end(), slower);
+            set.records.back() = record;
+            std::push_heap(set.records.begin(), set.records.end(), slower);
+        }
+        if (set.records.size() >= capacity)
+        {
+            set.threshold.store(set.records.front().total_us, std::memory_order_relaxed);
+        }
+    }
+
+    std::vector<RpcRecord> Rpcz::recent(size_t limit) const
+    {
+        std::vector<RecentRing *> rings;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (auto &ring : rings_)
+            {
+                rings.push_back(ring.get());
+            }
+        }
+        std::vector<RpcRecord> result;
+        for (auto ring : rings)
+        {
+            std::lock_guard<std::mutex> lock(ring->mutex);
+            result.insert(result.end(), ring->records.begin(), ring->records.end());
+        }
+        std::sort(result.begin(), result.end(), [](const RpcRecord &a, const RpcRecord &b)
+                  { return a.start_us > b.start_us; });
+        if (result.size() > limit)
+        {
+            result.resize(limit);
+        }
+        return result;
+    }
+
+    std::vector<RpcRecord> Rpcz::slowest() const
+    {
+        std::vector<SlowestSet *> sets;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (auto &set : slowest_)
+            {
+                if (set)
+                {
+                    sets.push_back(set.get());
+                }
+            }
+        }
+        // 没有新调用的方法在读取时轮换，过期的记录不再显示
+        int64_t window = current_window();
+        size_t capacity = slowest_per_method_.load(std::memory_order_relaxed);
+        std::vector<RpcRecord> result;
+        for (auto set : sets)
+        {
+            std::vector<RpcRecord> records;
+            {
+                std::lock_guard<std::mutex> lock(set->mutex);
+                rotate(*set, window);
+                records = set->records;
+                records.insert(records.end(), set->previous.begin(), set->previous.end());
+            }
+            std::sort(records.begin(), records.end(), slower);
+            if (records.size() > capacity)
+            {
+                records.resize(capacity);
+            }
+            result.insert(result.end(), records.begin(), records.end());
+        }
+        return result;
+    }
+
+    std::string Rpcz::dump(size_t recent_limit) const
+    {
+        int64_t wall_offset_us = wall_time_us() - now_us();
+        std::string out = std::format("slowest requests per method (up to {}, last {}-{}s)\n",
+                                      slowest_per_method_.load(std::memory_order_relaxed),
+                                      slowest_window_ms_.load(std::memory_order_relaxed) / 1000,
+                                      slowest_window_ms_.load(std::memory_order_relaxed) * 2 / 1000);
+        append_header(out);
+        for (auto &record : slowest())
+        {
+            append_record(out, record, wall_offset_us);
+        }
+        std::format_to(std::back_inserter(out), "\nrecent requests (newest first, up to {})\n", recent_limit);
+        append_header(out);
+        for (auto &record : recent(recent_limit))
+        {
+            append_record(out, record, wall_offset_us);
+        }
+        return out;
+    }
+
+    bool Rpcz::dump_on_signal(const std::string &path, int signo)
+    {
+        static std::once_flag once;
+        bool ok = true;
+        std::call_once(once, [&]()
+                       {
+                           if (sem_init(&dump_sem, 0, 0) != 0)
+                           {
+                               ok = false;
+                               return;
+                           }
+                           std::thread([this, path]()
+                                       {
+                                           while (true)
+                                           {
+                                               if (sem_wait(&dump_sem) != 0)
+                                               {
+                                                   continue;
+                                               }
+                                               FILE *file = fopen(path.c_str(), "a");
+                                               if (!file)
+                                               {
+                                                   continue;
+                                               }
+                                               std::string out = dump(SIZE_MAX);
+                                               fwrite(out.data(), 1, out.size(), file);
+                                               fputc('\n', file);
+                                               fclose(file);
+                                           } })
+                               .detach();
+
+                           struct sigaction action = {};
+                           action.sa_handler = on_dump_signal;
+                           sigemptyset(&action.sa_mask);
+                           action.sa_flags = SA_RESTART;
+                           ok = sigaction(signo, &action, nullptr) == 0; });
+        return ok;
+    }
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <string_view>
+
+#include "metrics.h"
+
+namespace dRPC::util
+{
+    // 一次已完成的调用，时间为单调时钟微秒，耗时为负表示该阶段不适用
+    struct RpcRecord
+    {
+        MethodMetrics *method = nullptr; // 所属方法，提供side和方法名
+        int64_t request_id = 0;
+        int64_t start_us = 0; // 服务端为帧首部读入时间，客户端为发起调用时间
+        int64_t queue_us = -1;
+        int64_t handler_us = -1;
+        int64_t total_us = 0;
+        uint64_t trace_id = 0; // 未采样为0
+        uint32_t request_bytes = 0;
+        uint32_t response_bytes = 0;
+        int32_t error_code = 0;
+        uint16_t peer_port = 0;
+        char peer_ip[16] = {};
+
+        void set_peer(std::string_view ip, int port);
+    };
+
+    struct RpczOptions
+    {
+        size_t recent_per_thread_ = 1024; // 每个executor线程保留的最近调用数
+        size_t slowest_per_method_ = 16;  // 每个方法保留的最慢调用数
+        int64_t slowest_window_ms_ = 60000; // 最慢调用的统计窗口，只保留当前和上一个窗口内完成的调用
+    };
+
+    // rpcz：最近调用按线程写入有界环形缓冲，另按方法保留近期耗时最长的N次调用，
+    // 用于在延迟上升时查看具体的慢请求。最慢调用按固定时间窗口轮换，启动阶段或偶发的慢请求
+    // 最多保留两个窗口，之后不会挡住新出现的慢请求。记录只在请求完成时写一次，读取时合并
+    class Rpcz
+    {
+    public:
+        static Rpcz &instance();
+
+        // 在记录之前调用，之后修改只影响新创建的缓冲
+        void configure(const RpczOptions &options);
+        void set_enabled(bool enabled) { enabled_.store(enabled, std::memory_order_relaxed); }
+        bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+        void record(const RpcRecord &record);
+
+        // 所有线程最近的调用，按开始时间从新到旧，最多limit条
+        std::vector<RpcRecord> recent(size_t limit) const;
+        // 每个方法在当前和上一个窗口内耗时最长的调用，按方法、耗时从长到短排列
+        std::vector<RpcRecord> slowest() const;
+
+        // 文本格式，供/rpcz页面和信号转储使用
+        std::string dump(size_t recent_limit = 200) const;
+
+        // 收到signo(如SIGUSR1)时把dump()追加写入path，由后台线程写文件，信号处理函数只做sem_post。
+        // 进程内只能安装一次
+        bool dump_on_signal(const std::string &path, int signo);
+
+    private:
+        Rpcz() = default;
+
+        struct RecentRing
+        {
+            std::mutex mutex; // 写者只有所属线程，读取状态页面时才有竞争
+            std::vector<RpcRecord> records;
+            size_t capacity = 0;
+            size_t next = 0;
+        };
+
+        // records为当前窗口的最小堆，堆顶是保留的记录中耗时最短的；进入新窗口时移入previous
+        struct SlowestSet
+        {
+            std::mutex mutex;
+            std::vector<RpcRecord> records;
+            std::vector<RpcRecord> previous;
+            std::atomic<int64_t> window{-1};    // 当前窗口编号(完成时间/窗口长度)
+            std::atomic<int64_t> threshold{-1}; // 当前窗口已满时为堆顶耗时，同一窗口内不超过它的调用无需加锁
+        };
+
+        RecentRing &local_ring();
+        SlowestSet &slowest_set(size_t method_id);
+        int64_t current_window() const;
+        static void rotate(SlowestSet &set, int64_t window);
+        void offer_slowest(SlowestSet &set, const RpcRecord &record, int64_t window);
+
+        std::atomic<bool> enabled_{true};
+        std::atomic<size_t> recent_per_thread_{1024};
+        std::atomic<size_t> slowest_per_method_{16};
+        std::atomic<int64_t> slowest_window_ms_{60000};
+
+        mutable std::mutex mutex_;
+        std::vector<std::unique_ptr<RecentRing>> rings_;
+        std::vector<std::unique_ptr<SlowestSet>> slowest_; // 按MethodMetrics::id()索引
+    };
+}
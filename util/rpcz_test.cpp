@@ -0,0 +1,137 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "rpcz.h"
+
+using dRPC::util::MethodMetrics;
+using dRPC::util::MetricsRegistry;
+using dRPC::util::RpcRecord;
+using dRPC::util::Rpcz;
+using dRPC::util::RpczOptions;
+
+namespace
+{
+    RpcRecord make_record(MethodMetrics *method, int64_t start_us, int64_t total_us)
+    {
+        RpcRecord record;
+        record.method = method;
+        record.request_id = start_us;
+        record.start_us = start_us;
+        record.total_us = total_us;
+        record.set_peer("127.0.0.1", 9000);
+        return record;
+    }
+
+    template <typename Records>
+    std::vector<int64_t> totals_of(const Records &records, MethodMetrics *method)
+    {
+        std::vector<int64_t> totals;
+        for (auto &record : records)
+        {
+            if (record.method == method)
+            {
+                totals.push_back(record.total_us);
+            }
+        }
+        return totals;
+    }
+
+    class RpczTest : public ::testing::Test
+    {
+    protected:
+        static void SetUpTestSuite()
+        {
+            RpczOptions options;
+            options.recent_per_thread_ = 8;
+            options.slowest_per_method_ = 3;
+            Rpcz::instance().configure(options);
+        }
+    };
+}
+
+TEST_F(RpczTest, RecentIsBoundedPerThread)
+{
+    auto method = MetricsRegistry::instance().method("server", "test.Recent");
+    std::thread([method]()
+                {
+                    for (int i = 1; i <= 20; ++i)
+                    {
+                        Rpcz::instance().record(make_record(method, i, i * 10));
+                    } })
+        .join();
+
+    // 新线程的环形缓冲只保留最近8条，按开始时间从新到旧
+    auto totals = totals_of(Rpcz::instance().recent(1000), method);
+    EXPECT_EQ(totals, (std::vector<int64_t>{200, 190, 180, 170, 160, 150, 140, 130}));
+    EXPECT_EQ(Rpcz::instance().recent(2).size(), 2u);
+}
+
+TEST_F(RpczTest, SlowestKeepsTopNPerMethod)
+{
+    auto a = MetricsRegistry::instance().method("server", "test.SlowA");
+    auto b = MetricsRegistry::instance().method("client", "test.SlowB");
+    std::vector<int64_t> latencies = {50, 10, 900, 30, 700, 20, 800, 60};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 2; ++t)
+    {
+        threads.emplace_back([&, t]()
+                             {
+                                 for (size_t i = 0; i < latencies.size(); ++i)
+                                 {
+                                     Rpcz::instance().record(make_record(t == 0 ? a : b, i, latencies[i] + t));
+                                 } });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    auto slowest = Rpcz::instance().slowest();
+    EXPECT_EQ(totals_of(slowest, a), (std::vector<int64_t>{900, 800, 700}));
+    EXPECT_EQ(totals_of(slowest, b), (std::vector<int64_t>{901, 801, 701}));
+}
+
+// 启动阶段的慢请求只保留两个窗口，之后同一方法较快的新请求仍能进入最慢列表
+TEST_F(RpczTest, SlowestExpiresAfterWindow)
+{
+    auto method = MetricsRegistry::instance().method("server", "test.SlowExpire");
+    RpczOptions options;
+    options.recent_per_thread_ = 8;
+    options.slowest_per_method_ = 3;
+    options.slowest_window_ms_ = 100;
+    Rpcz::instance().configure(options);
+
+    for (int i = 0; i < 3; ++i)
+    {
+        Rpcz::instance().record(make_record(method, i, 1000000 + i));
+    }
+    EXPECT_EQ(totals_of(Rpcz::instance().slowest(), method), (std::vector<int64_t>{1000002, 1000001, 1000000}));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    Rpcz::instance().record(make_record(method, 3, 20));
+    Rpcz::instance().record(make_record(method, 4, 10));
+    EXPECT_EQ(totals_of(Rpcz::instance().slowest(), method), (std::vector<int64_t>{20, 10}));
+
+    options.slowest_window_ms_ = RpczOptions().slowest_window_ms_;
+    Rpcz::instance().configure(options);
+}
+
+TEST_F(RpczTest, DumpAndDisable)
+{
+    auto method = MetricsRegistry::instance().method("server", "test.Dump");
+    Rpcz::instance().set_enabled(false);
+    Rpcz::instance().record(make_record(method, 1, 12345));
+    EXPECT_TRUE(totals_of(Rpcz::instance().recent(1000), method).empty());
+
+    Rpcz::instance().set_enabled(true);
+    Rpcz::instance().record(make_record(method, 2, 12345));
+    std::string dump = Rpcz::instance().dump();
+    EXPECT_NE(dump.find("test.Dump"), std::string::npos);
+    EXPECT_NE(dump.find("127.0.0.1:9000"), std::string::npos);
+    EXPECT_NE(dump.find("12345"), std::string::npos);
+}
@@ -1,30 +1,119 @@
 #include "service.h"
 
+#include <algorithm>
+
+#include "clock.h"
+
 namespace dRPC
 {
     void RpcController::Reset()
     {
         failed_ = false;
+        error_code_ = ErrorCode::OK;
         canceled_ = false;
+        finished_ = false;
         error_text_.clear();
         timeout_ms_ = -1;
+        deadline_us_ = -1;
+        request_code_ = 0;
+        has_request_code_ = false;
+        trace_ = {};
+        cancel_callbacks_.clear();
+        cancel_handler_ = nullptr;
     }
 
     void RpcController::StartCancel()
     {
-        canceled_ = true;
+        std::vector<google::protobuf::Closure *> callbacks;
+        std::function<void()> handler;
+        {
+            std::lock_guard<std::mutex> lock(cancel_mutex_);
+            if (canceled_.load(std::memory_order_relaxed) || finished_)
+            {
+                return;
+            }
+            canceled_.store(true, std::memory_order_release);
+            callbacks.swap(cancel_callbacks_);
+            handler.swap(cancel_handler_);
+        }
+        if (handler)
+        {
+            handler();
+        }
+        for (auto callback : callbacks)
+        {
+            callback->Run();
+        }
     }
 
     void RpcController::SetFailed(const std::string &reason)
+    {
+        SetFailed(ErrorCode::FAILED, reason);
+    }
+
+    void RpcController::SetFailed(ErrorCode code, const std::string &reason)
     {
         failed_ = true;
+        error_code_ = code;
         error_text_ = reason;
     }
 
-    void RpcController::NotifyOnCancel(google::protobuf::Closure *callback) {}
+    void RpcController::NotifyOnCancel(google::protobuf::Closure *callback)
+    {
+        {
+            std::lock_guard<std::mutex> lock(cancel_mutex_);
+            if (!canceled_.load(std::memory_order_relaxed) && !finished_)
+            {
+                cancel_callbacks_.push_back(callback);
+                return;
+            }
+        }
+        callback->Run();
+    }
+
+    void RpcController::set_cancel_handler(std::function<void()> &&handler)
+    {
+        {
+            std::lock_guard<std::mutex> lock(cancel_mutex_);
+            if (!canceled_.load(std::memory_order_relaxed))
+            {
+                cancel_handler_ = std::move(handler);
+                return;
+            }
+        }
+        handler();
+    }
+
+    void RpcController::finish()
+    {
+        std::vector<google::protobuf::Closure *> callbacks;
+        {
+            std::lock_guard<std::mutex> lock(cancel_mutex_);
+            if (finished_)
+            {
+                return;
+            }
+            finished_ = true;
+            callbacks.swap(cancel_callbacks_);
+            cancel_handler_ = nullptr;
+        }
+        for (auto callback : callbacks)
+        {
+            callback->Run();
+        }
+    }
 
     void RpcController::SetTimeout(int64_t ms)
     {
         timeout_ms_ = ms;
     }
-}
\ No newline at end of file
+
+    int64_t RpcController::remaining_ms() const
+    {
+        if (deadline_us_ < 0)
+        {
+            return -1;
+        }
+        return std::max<int64_t>(deadline_us_ - util::now_us(), 0) / 1000;
+    }
+}
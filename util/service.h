@@ -1,10 +1,28 @@
 #pragma once
 
 #include <string>
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <functional>
 #include <google/protobuf/service.h>
 
+#include "tracing.h"
+
 namespace dRPC
 {
+    enum class ErrorCode : int32_t
+    {
+        OK = 0,
+        FAILED = 1,  // 未分类错误
+        TIMEOUT = 2,  // 调用超时
+        CANCELED = 3, // 调用被取消
+        UNAVAILABLE = 4, // 连接失败或断开
+        OVERLOADED = 5,  // 超过并发或缓冲上限被拒绝
+        NOT_FOUND = 6,   // 服务端找不到service或method
+        BAD_REQUEST = 7, // 服务端无法解析请求
+    };
+
     class RpcController : public google::protobuf::RpcController
     {
     public:
@@ -16,16 +34,54 @@ namespace dRPC
         std::string ErrorText() const override { return error_text_; }
         void StartCancel() override;
         void SetFailed(const std::string &reason) override;
-        bool IsCanceled() const override { return canceled_; }
+        void SetFailed(ErrorCode code, const std::string &reason);
+        ErrorCode error_code() const { return error_code_; }
+        bool IsCanceled() const override { return canceled_.load(std::memory_order_acquire); }
+        // callback只执行一次：取消时执行，未被取消则在调用完成(finish)后执行
         void NotifyOnCancel(google::protobuf::Closure *callback) override;
 
+        // 客户端：由channel注册，StartCancel时执行，已取消时立即执行
+        void set_cancel_handler(std::function<void()> &&handler);
+        // 服务端：请求处理完成，执行尚未触发的NotifyOnCancel回调
+        void finish();
+
         void SetTimeout(int64_t ms);
         int64_t timeout_ms() const { return timeout_ms_; }
 
+        // 一致性哈希负载均衡使用的请求key，相同key的请求路由到同一endpoint
+        void set_request_code(uint64_t code)
+        {
+            request_code_ = code;
+            has_request_code_ = true;
+        }
+        bool has_request_code() const { return has_request_code_; }
+        uint64_t request_code() const { return request_code_; }
+
+        // 服务端请求截止时间(单调时钟，微秒)，-1表示没有截止时间
+        void set_deadline_us(int64_t deadline_us) { deadline_us_ = deadline_us; }
+        int64_t deadline_us() const { return deadline_us_; }
+        // 距截止时间的剩余毫秒数，没有截止时间返回-1，已过期返回0
+        int64_t remaining_ms() const;
+
+        // 服务端：请求所属的trace，handler在回调中发起下游调用时应设置到下游的controller上；
+        // 客户端：设置后请求作为该span的子span发出，否则使用Tracer::current()或按比例采样
+        void set_trace_context(const util::TraceContext &trace) { trace_ = trace; }
+        const util::TraceContext &trace_context() const { return trace_; }
+
     private:
         bool failed_ = false;
-        bool canceled_ = false;
+        ErrorCode error_code_ = ErrorCode::OK;
+        std::atomic<bool> canceled_{false};
+        bool finished_ = false;
         std::string error_text_;
         int64_t timeout_ms_ = -1; // -1表示无超时
+        int64_t deadline_us_ = -1;
+        uint64_t request_code_ = 0;
+        bool has_request_code_ = false;
+        util::TraceContext trace_;
+
+        std::mutex cancel_mutex_;
+        std::vector<google::protobuf::Closure *> cancel_callbacks_;
+        std::function<void()> cancel_handler_;
     };
 }
\ No newline at end of file
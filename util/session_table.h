@@ -0,0 +1,180 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <optional>
+#include <utility>
+#include <unordered_map>
+
+namespace dRPC::util
+{
+    // 以单调递增的request_id为键的会话表
+    // slot数组容量为2的幂，按 id & mask 定位，slot中保存完整id作为代际校验；
+    // 容量只随进行中的会话数按负载因子增长。目标slot被仍在进行中的旧会话占用时，
+    // 把旧会话移入溢出表，新会话占用slot，长时间未完成的调用不会迫使数组扩容
+    template <typename T>
+    class SessionTable
+    {
+    public:
+        explicit SessionTable(size_t capacity = 64)
+        {
+            size_t cap = 1;
+            while (cap < capacity)
+            {
+                cap <<= 1;
+            }
+            slots_.resize(cap);
+            mask_ = cap - 1;
+        }
+
+        ~SessionTable() = default;
+
+        // 插入会话，id已存在时返回false
+        bool insert(int64_t id, T value)
+        {
+            if (!overflow_.empty() && overflow_.count(id))
+            {
+                return false;
+            }
+            // 负载因子超过3/4时扩容
+            if ((size_ + 1) * 4 > slots_.size() * 3)
+            {
+                grow();
+            }
+            Slot &slot = slots_[index(id)];
+            if (slot.id == id)
+            {
+                return false;
+            }
+            if (slot.id != EMPTY)
+            {
+                overflow_.emplace(slot.id, std::move(slot.value));
+            }
+            slot.id = id;
+            slot.value = std::move(value);
+            ++size_;
+            return true;
+        }
+
+        T *find(int64_t id)
+        {
+            Slot &slot = slots_[index(id)];
+            if (slot.id == id)
+            {
+                return &slot.value;
+            }
+            if (overflow_.empty())
+            {
+                return nullptr;
+            }
+            auto it = overflow_.find(id);
+            return it == overflow_.end() ? nullptr : &it->second;
+        }
+
+        // 取出并删除会话
+        std::optional<T> take(int64_t id)
+        {
+            Slot &slot = slots_[index(id)];
+            if (slot.id == id)
+            {
+                std::optional<T> value(std::move(slot.value));
+                slot.id = EMPTY;
+                slot.value = T();
+                --size_;
+                return value;
+            }
+            if (overflow_.empty())
+            {
+                return std::nullopt;
+            }
+            auto it = overflow_.find(id);
+            if (it == overflow_.end())
+            {
+                return std::nullopt;
+            }
+            std::optional<T> value(std::move(it->second));
+            overflow_.erase(it);
+            --size_;
+            return value;
+        }
+
+        bool erase(int64_t id)
+        {
+            return take(id).has_value();
+        }
+
+        template <typename F>
+        void for_each(F &&func)
+        {
+            for (auto &slot : slots_)
+            {
+                if (slot.id != EMPTY)
+                {
+                    func(slot.id, slot.value);
+                }
+            }
+            for (auto &[id, value] : overflow_)
+            {
+                func(id, value);
+            }
+        }
+
+        size_t size() const { return size_; }
+        bool empty() const { return size_ == 0; }
+        size_t capacity() const { return slots_.size(); }
+        size_t overflow_size() const { return overflow_.size(); }
+
+    private:
+        static constexpr int64_t EMPTY = -1;
+
+        struct Slot
+        {
+            int64_t id = EMPTY;
+            T value{};
+        };
+
+        size_t index(int64_t id) const { return static_cast<size_t>(id) & mask_; }
+
+        // 容量翻倍并重新放置，溢出表中的会话在新数组有空位时移回，仍冲突的留在溢出表
+        void grow()
+        {
+            size_t cap = slots_.size() << 1;
+            std::vector<Slot> slots(cap);
+            size_t mask = cap - 1;
+            std::unordered_map<int64_t, T> overflow;
+            auto place = [&](int64_t id, T &value)
+            {
+                Slot &target = slots[static_cast<size_t>(id) & mask];
+                if (target.id == EMPTY)
+                {
+                    target.id = id;
+                    target.value = std::move(value);
+                }
+                else
+                {
+                    overflow.emplace(id, std::move(value));
+                }
+            };
+            for (auto &slot : slots_)
+            {
+                if (slot.id != EMPTY)
+                {
+                    place(slot.id, slot.value);
+                }
+            }
+            for (auto &[id, value] : overflow_)
+            {
+                place(id, value);
+            }
+            slots_.swap(slots);
+            overflow_.swap(overflow);
+            mask_ = mask;
+        }
+
+        std::vector<Slot> slots_;
+        std::unordered_map<int64_t, T> overflow_; // 与新会话冲突的旧会话，通常为空
+        size_t mask_ = 0;
+        size_t size_ = 0;
+    };
+}
@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "session_table.h"
+
+using dRPC::util::SessionTable;
+
+// 基础插入、查找、删除
+TEST(SessionTableTest, InsertFindTake)
+{
+    SessionTable<std::string> table(8);
+
+    EXPECT_TRUE(table.insert(1, "one"));
+    EXPECT_TRUE(table.insert(2, "two"));
+    EXPECT_FALSE(table.insert(1, "again"));
+    EXPECT_EQ(table.size(), 2);
+
+    ASSERT_NE(table.find(1), nullptr);
+    EXPECT_EQ(*table.find(1), "one");
+    EXPECT_EQ(table.find(3), nullptr);
+
+    auto value = table.take(2);
+    ASSERT_TRUE(value.has_value());
+    EXPECT_EQ(*value, "two");
+    EXPECT_FALSE(table.take(2).has_value());
+    EXPECT_EQ(table.size(), 1);
+}
+
+// 同一slot上的旧id不会被新id误命中
+TEST(SessionTableTest, GenerationCheck)
+{
+    SessionTable<int> table(8);
+
+    table.insert(3, 3);
+    table.take(3);
+    table.insert(11, 11);
+
+    EXPECT_EQ(table.find(3), nullptr);
+    EXPECT_FALSE(table.take(3).has_value());
+    ASSERT_NE(table.find(11), nullptr);
+    EXPECT_EQ(*table.find(11), 11);
+    EXPECT_EQ(table.capacity(), 8);
+}
+
+// 长时间未完成的旧会话移入溢出表，不会随id增长而扩容
+TEST(SessionTableTest, StragglerMovesToOverflow)
+{
+    SessionTable<int> table(8);
+
+    table.insert(0, 0);
+    for (int64_t id = 1; id < 100000; ++id)
+    {
+        ASSERT_TRUE(table.insert(id, static_cast<int>(id)));
+        ASSERT_TRUE(table.take(id).has_value());
+    }
+    EXPECT_EQ(table.capacity(), 8);
+    EXPECT_EQ(table.overflow_size(), 1);
+    EXPECT_FALSE(table.insert(0, 1));
+    ASSERT_NE(table.find(0), nullptr);
+    EXPECT_EQ(*table.find(0), 0);
+    EXPECT_EQ(table.size(), 1);
+
+    int count = 0;
+    table.for_each([&](int64_t id, int &)
+                   {
+                       EXPECT_EQ(id, 0);
+                       ++count; });
+    EXPECT_EQ(count, 1);
+
+    auto value = table.take(0);
+    ASSERT_TRUE(value.has_value());
+    EXPECT_EQ(*value, 0);
+    EXPECT_TRUE(table.empty());
+    EXPECT_EQ(table.overflow_size(), 0);
+}
+
+// 按负载因子扩容，扩容时溢出表中的会话移回数组
+TEST(SessionTableTest, GrowOnLoadFactor)
+{
+    SessionTable<int> table(8);
+
+    table.insert(0, 0);
+    table.insert(8, 8);
+    EXPECT_EQ(table.overflow_size(), 1);
+    for (int64_t id = 1; id <= 6; ++id)
+    {
+        table.insert(id, static_cast<int>(id));
+    }
+    EXPECT_EQ(table.size(), 8);
+    EXPECT_EQ(table.capacity(), 16);
+    EXPECT_EQ(table.overflow_size(), 0);
+    for (int64_t id : {0, 1, 2, 3, 4, 5, 6, 8})
+    {
+        ASSERT_NE(table.find(id), nullptr);
+        EXPECT_EQ(*table.find(id), id);
+    }
+}
+
+// 滑动窗口内的会话全部保留
+TEST(SessionTableTest, SlidingWindow)
+{
+    SessionTable<int64_t> table(4);
+    const int64_t WINDOW = 100;
+
+    for (int64_t id = 0; id < 10000; ++id)
+    {
+        ASSERT_TRUE(table.insert(id, id));
+        if (id >= WINDOW)
+        {
+            auto value = table.take(id - WINDOW);
+            ASSERT_TRUE(value.has_value());
+            EXPECT_EQ(*value, id - WINDOW);
+        }
+    }
+    EXPECT_EQ(table.size(), WINDOW);
+    EXPECT_LE(table.capacity(), 256);
+
+    int64_t count = 0;
+    table.for_each([&](int64_t id, int64_t &value)
+                   {
+                       EXPECT_EQ(id, value);
+                       ++count; });
+    EXPECT_EQ(count, WINDOW);
+}
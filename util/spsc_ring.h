@@ -0,0 +1,141 @@
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <algorithm>
+
+namespace dRPC::util
+{
+    // 单生产者单消费者环形缓冲，元素原地构造和处理。满时丢弃并计数，生产者不会阻塞
+    template <typename T, size_t Capacity>
+    class SpscRing
+    {
+    public:
+        static constexpr size_t CAPACITY = Capacity;
+
+        // 生产者：取得下一个空槽，填充后commit；缓冲已满返回nullptr
+        T *reserve()
+        {
+            size_t tail = tail_.load(std::memory_order_relaxed);
+            if (tail - head_cache_ >= Capacity)
+            {
+                head_cache_ = head_.load(std::memory_order_acquire);
+                if (tail - head_cache_ >= Capacity)
+                {
+                    dropped_.fetch_add(1, std::memory_order_relaxed);
+                    return nullptr;
+                }
+            }
+            return &slots_[tail % Capacity];
+        }
+        void commit() { tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+        // 消费者：依次处理已提交的元素，返回处理个数
+        template <typename F>
+        size_t consume(F &&f)
+        {
+            size_t head = head_.load(std::memory_order_relaxed);
+            size_t tail = tail_.load(std::memory_order_acquire);
+            for (size_t i = head; i != tail; ++i)
+            {
+                f(slots_[i % Capacity]);
+            }
+            head_.store(tail, std::memory_order_release);
+            return tail - head;
+        }
+
+        int64_t take_dropped() { return dropped_.exchange(0, std::memory_order_relaxed); }
+
+    private:
+        alignas(64) std::atomic<size_t> head_{0};
+        alignas(64) std::atomic<size_t> tail_{0};
+        size_t head_cache_ = 0;
+        std::atomic<int64_t> dropped_{0};
+        T slots_[Capacity];
+    };
+
+    // 每线程一个环形缓冲的注册表：线程首次使用时创建并注册，线程退出时标记，
+    // 由消费者处理完剩余元素后移除。Logger和Tracer各持有一个
+    template <typename Ring>
+    class RingRegistry
+    {
+    private:
+        struct Entry
+        {
+            template <typename... Args>
+            explicit Entry(Args &&...args) : ring(std::forward<Args>(args)...) {}
+
+            Ring ring;
+            std::atomic<bool> orphaned{false}; // 所属线程已退出
+        };
+
+    public:
+        // 作为thread_local使用，线程退出时析构并标记环形缓冲
+        class Holder
+        {
+        public:
+            ~Holder()
+            {
+                if (entry_)
+                {
+                    entry_->orphaned.store(true, std::memory_order_release);
+                }
+            }
+
+            Ring *get() const { return entry_ ? &entry_->ring : nullptr; }
+
+        private:
+            friend class RingRegistry;
+            std::shared_ptr<Entry> entry_;
+        };
+
+        // 为当前线程创建环形缓冲并注册，args转发给Ring的构造函数
+        template <typename... Args>
+        Ring *attach(Holder &holder, Args &&...args)
+        {
+            holder.entry_ = std::make_shared<Entry>(std::forward<Args>(args)...);
+            std::lock_guard<std::mutex> lock(mutex_);
+            entries_.push_back(holder.entry_);
+            return &holder.entry_->ring;
+        }
+
+        // 依次以f(Ring &)处理各环形缓冲，调用方保证同一时刻只有一个消费者
+        template <typename F>
+        void for_each(F &&f)
+        {
+            std::vector<std::shared_ptr<Entry>> snapshot;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                snapshot = entries_;
+            }
+
+            std::vector<Entry *> finished;
+            for (auto &entry : snapshot)
+            {
+                // 先读标记再处理，线程退出前提交的元素一定在本轮处理
+                bool orphaned = entry->orphaned.load(std::memory_order_acquire);
+                f(entry->ring);
+                if (orphaned)
+                {
+                    finished.push_back(entry.get());
+                }
+            }
+
+            if (!finished.empty())
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                std::erase_if(entries_, [&](const std::shared_ptr<Entry> &entry)
+                              { return std::find(finished.begin(), finished.end(), entry.get()) != finished.end(); });
+            }
+        }
+
+    private:
+        std::mutex mutex_;
+        std::vector<std::shared_ptr<Entry>> entries_;
+    };
+}
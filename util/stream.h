@@ -17,6 +17,26 @@ namespace dRPC::util
             return input_buffer_->read(buf, len);
         }
 
+        size_t peek(void *buf, size_t len) const
+        {
+            return input_buffer_->peek(buf, len);
+        }
+
+        // 丢弃len字节，用于跳过无人接收的消息体
+        void skip(size_t len)
+        {
+            char buf[256];
+            while (len > 0)
+            {
+                size_t n = read(buf, std::min(len, sizeof(buf)));
+                if (n == 0)
+                {
+                    break;
+                }
+                len -= n;
+            }
+        }
+
         void push_limit(int limit)
         {
             input_buffer_->push_limit(limit);
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <functional>
+
+namespace dRPC::util
+{
+    // 基于最小堆的定时器队列，非线程安全，只在所属executor线程中使用
+    // 定时器回调存放在slot数组中，TimerId = (slot << 32) | seq，
+    // 取消时只需递增slot的seq，堆中残留的过期条目在弹出时被跳过
+    class TimerQueue
+    {
+    public:
+        using TimerId = uint64_t;
+        using Callback = std::function<void()>;
+
+        static constexpr TimerId INVALID_TIMER = 0;
+
+        TimerQueue() = default;
+        ~TimerQueue() = default;
+
+        TimerId add(int64_t expire_us, Callback &&callback)
+        {
+            uint32_t slot;
+            if (!free_slots_.empty())
+            {
+                slot = free_slots_.back();
+                free_slots_.pop_back();
+            }
+            else
+            {
+                slot = static_cast<uint32_t>(slots_.size());
+                slots_.emplace_back();
+            }
+            Slot &s = slots_[slot];
+            s.callback = std::move(callback);
+            s.active = true;
+
+            heap_.push_back({expire_us, slot, s.seq});
+            std::push_heap(heap_.begin(), heap_.end(), Entry::later);
+            ++active_count_;
+            return make_id(slot, s.seq);
+        }
+
+        // 取消定时器，对已触发或已取消的定时器调用无副作用
+        bool cancel(TimerId id)
+        {
+            uint32_t slot = static_cast<uint32_t>(id >> 32);
+            uint32_t seq = static_cast<uint32_t>(id);
+            if (id == INVALID_TIMER || slot >= slots_.size())
+            {
+                return false;
+            }
+            Slot &s = slots_[slot];
+            if (!s.active || s.seq != seq)
+            {
+                return false;
+            }
+            release(slot);
+            // 残留条目过多时重建堆，防止大量取消导致堆无限增长
+            if (heap_.size() > 64 && heap_.size() > active_count_ * 4)
+            {
+                compact();
+            }
+            return true;
+        }
+
+        // 距离最近一个定时器到期的毫秒数(向上取整)，没有定时器时返回-1
+        int next_timeout_ms(int64_t now_us)
+        {
+            skip_stale();
+            if (heap_.empty())
+            {
+                return -1;
+            }
+            int64_t delta = heap_.front().expire_us - now_us;
+            if (delta <= 0)
+            {
+                return 0;
+            }
+            return static_cast<int>(std::min<int64_t>((delta + 999) / 1000, INT32_MAX));
+        }
+
+        // 执行所有到期的定时器，返回执行的个数
+        size_t run_expired(int64_t now_us)
+        {
+            size_t count = 0;
+            while (true)
+            {
+                skip_stale();
+                if (heap_.empty() || heap_.front().expire_us > now_us)
+                {
+                    break;
+                }
+                uint32_t slot = heap_.front().slot;
+                std::pop_heap(heap_.begin(), heap_.end(), Entry::later);
+                heap_.pop_back();
+
+                // 回调中可能再添加定时器，先取出回调并释放slot
+                Callback callback = std::move(slots_[slot].callback);
+                release(slot);
+                callback();
+                ++count;
+            }
+            return count;
+        }
+
+        size_t size() const { return active_count_; }
+        bool empty() const { return active_count_ == 0; }
+
+    private:
+        struct Entry
+        {
+            int64_t expire_us;
+            uint32_t slot;
+            uint32_t seq;
+
+            static bool later(const Entry &a, const Entry &b)
+            {
+                return a.expire_us > b.expire_us;
+            }
+        };
+
+        struct Slot
+        {
+            Callback callback;
+            uint32_t seq = 1;
+            bool active = false;
+        };
+
+        static TimerId make_id(uint32_t slot, uint32_t seq)
+        {
+            return (static_cast<uint64_t>(slot) << 32) | seq;
+        }
+
+        bool stale(const Entry &entry) const
+        {
+            const Slot &s = slots_[entry.slot];
+            return !s.active || s.seq != entry.seq;
+        }
+
+        void release(uint32_t slot)
+        {
+            Slot &s = slots_[slot];
+            s.callback = nullptr;
+            s.active = false;
+            // seq跳过0，保证TimerId不会等于INVALID_TIMER
+            if (++s.seq == 0)
+            {
+                s.seq = 1;
+            }
+            free_slots_.push_back(slot);
+            --active_count_;
+        }
+
+        void skip_stale()
+        {
+            while (!heap_.empty() && stale(heap_.front()))
+            {
+                std::pop_heap(heap_.begin(), heap_.end(), Entry::later);
+                heap_.pop_back();
+            }
+        }
+
+        void compact()
+        {
+            std::erase_if(heap_, [this](const Entry &entry)
+                          { return stale(entry); });
+            std::make_heap(heap_.begin(), heap_.end(), Entry::later);
+        }
+
+        std::vector<Entry> heap_;
+        std::vector<Slot> slots_;
+        std::vector<uint32_t> free_slots_;
+        size_t active_count_ = 0;
+
+        TimerQueue(const TimerQueue &) = delete;
+        TimerQueue &operator=(const TimerQueue &) = delete;
+    };
+}
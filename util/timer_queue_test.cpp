@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "timer_queue.h"
+
+using dRPC::util::TimerQueue;
+
+// 按到期时间顺序触发
+TEST(TimerQueueTest, RunInExpireOrder)
+{
+    TimerQueue timers;
+    std::vector<int> fired;
+
+    timers.add(300, [&]()
+               { fired.push_back(3); });
+    timers.add(100, [&]()
+               { fired.push_back(1); });
+    timers.add(200, [&]()
+               { fired.push_back(2); });
+
+    EXPECT_EQ(timers.run_expired(50), 0);
+    EXPECT_EQ(timers.run_expired(250), 2);
+    EXPECT_EQ(timers.run_expired(1000), 1);
+    EXPECT_EQ(fired, (std::vector<int>{1, 2, 3}));
+    EXPECT_TRUE(timers.empty());
+}
+
+// 取消的定时器不触发，重复取消无副作用
+TEST(TimerQueueTest, Cancel)
+{
+    TimerQueue timers;
+    int fired = 0;
+
+    auto id1 = timers.add(100, [&]()
+                          { fired += 1; });
+    auto id2 = timers.add(100, [&]()
+                          { fired += 10; });
+    EXPECT_TRUE(timers.cancel(id1));
+    EXPECT_FALSE(timers.cancel(id1));
+    EXPECT_EQ(timers.size(), 1);
+
+    timers.run_expired(100);
+    EXPECT_EQ(fired, 10);
+    EXPECT_FALSE(timers.cancel(id2));
+}
+
+// slot复用后旧的TimerId失效
+TEST(TimerQueueTest, StaleIdAfterReuse)
+{
+    TimerQueue timers;
+    int fired = 0;
+
+    auto id1 = timers.add(100, [&]()
+                          { fired += 1; });
+    timers.cancel(id1);
+    auto id2 = timers.add(200, [&]()
+                          { fired += 10; });
+    EXPECT_NE(id1, id2);
+    EXPECT_FALSE(timers.cancel(id1));
+
+    timers.run_expired(200);
+    EXPECT_EQ(fired, 10);
+}
+
+// 最近到期时间换算为epoll_wait超时
+TEST(TimerQueueTest, NextTimeout)
+{
+    TimerQueue timers;
+    EXPECT_EQ(timers.next_timeout_ms(0), -1);
+
+    auto id = timers.add(1500, []() {});
+    timers.add(5000, []() {});
+    EXPECT_EQ(timers.next_timeout_ms(0), 2);
+    EXPECT_EQ(timers.next_timeout_ms(2000), 0);
+
+    timers.cancel(id);
+    EXPECT_EQ(timers.next_timeout_ms(0), 5);
+}
+
+// 回调中添加新定时器
+TEST(TimerQueueTest, AddInCallback)
+{
+    TimerQueue timers;
+    int fired = 0;
+
+    timers.add(100, [&]()
+               {
+                   ++fired;
+                   timers.add(100, [&]()
+                              { ++fired; }); });
+
+    timers.run_expired(100);
+    EXPECT_EQ(fired, 2);
+}
+
+// 大量取消后堆被压缩
+TEST(TimerQueueTest, CompactAfterManyCancels)
+{
+    TimerQueue timers;
+    int fired = 0;
+
+    std::vector<TimerQueue::TimerId> ids;
+    for (int i = 0; i < 10000; ++i)
+    {
+        ids.push_back(timers.add(1000 + i, [&]()
+                                 { ++fired; }));
+    }
+    for (int i = 0; i < 9990; ++i)
+    {
+        timers.cancel(ids[i]);
+    }
+    EXPECT_EQ(timers.size(), 10);
+
+    timers.run_expired(1000000);
+    EXPECT_EQ(fired, 10);
+}
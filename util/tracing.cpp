@@ -0,0 +1,277 @@
+#include "tracing.h"
+
+#include <mutex>
+#include <thread>
+#include <random>
+#include <format>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <condition_variable>
+
+#include "clock.h"
+#include "logger.h"
+
+namespace dRPC::util
+{
+    namespace
+    {
+        // tracer析构后置位，之后不再注册环形缓冲
+        constinit std::atomic<bool> closed{false};
+
+        int64_t wall_time_us()
+        {
+            return std::chrono::duration_cast<std::chrono::microseconds>(
+                       std::chrono::system_clock::now().time_since_epoch())
+                .count();
+        }
+
+        void copy_string(char *dst, size_t size, std::string_view src)
+        {
+            size_t len = std::min(src.size(), size - 1);
+            memcpy(dst, src.data(), len);
+            dst[len] = '\0';
+        }
+
+        void append_json_string(std::string &out, const char *value)
+        {
+            out.push_back('"');
+            for (const char *p = value; *p; ++p)
+            {
+                unsigned char c = static_cast<unsigned char>(*p);
+                if (c == '"' || c == '\\')
+                {
+                    out.push_back('\\');
+                    out.push_back(static_cast<char>(c));
+                }
+                else if (c < 0x20)
+                {
+                    std::format_to(std::back_inserter(out), "\\u{:04x}", c);
+                }
+                else
+                {
+                    out.push_back(static_cast<char>(c));
+                }
+            }
+            out.push_back('"');
+        }
+
+        // Zipkin v2 JSON: https://zipkin.io/zipkin-api/#/default/post_spans
+        void append_span(std::string &out, const Span &span, const std::string &service_name, int64_t wall_offset_us)
+        {
+            std::format_to(std::back_inserter(out), "{{\"traceId\":\"{:016x}\",\"id\":\"{:016x}\"", span.trace_id, span.id);
+            if (span.parent_id != 0)
+            {
+                std::format_to(std::back_inserter(out), ",\"parentId\":\"{:016x}\"", span.parent_id);
+            }
+            out.append(",\"name\":");
+            append_json_string(out, span.name);
+            if (span.kind == SpanKind::CLIENT)
+            {
+                out.append(",\"kind\":\"CLIENT\"");
+            }
+            else if (span.kind == SpanKind::SERVER)
+            {
+                out.append(",\"kind\":\"SERVER\"");
+            }
+            std::format_to(std::back_inserter(out), ",\"timestamp\":{},\"duration\":{}", span.start_us + wall_offset_us,
+                           std::max<int64_t>(span.end_us - span.start_us, 1));
+            out.append(",\"localEndpoint\":{\"serviceName\":");
+            append_json_string(out, service_name.c_str());
+            out.push_back('}');
+            if (span.peer_ip[0])
+            {
+                out.append(",\"remoteEndpoint\":{\"ipv4\":");
+                append_json_string(out, span.peer_ip);
+                std::format_to(std::back_inserter(out), ",\"port\":{}}}", span.peer_port);
+            }
+            if (span.error_code != 0)
+            {
+                std::format_to(std::back_inserter(out), ",\"tags\":{{\"error\":\"{}\"}}", span.error_code);
+            }
+            out.push_back('}');
+        }
+    }
+
+    void Span::set_name(std::string_view value)
+    {
+        copy_string(name, sizeof(name), value);
+    }
+
+    void Span::set_peer(std::string_view ip, int port)
+    {
+        copy_string(peer_ip, sizeof(peer_ip), ip);
+        peer_port = static_cast<uint16_t>(port);
+    }
+
+    struct Tracer::Impl
+    {
+        RingRegistry<SpanRing> rings;
+
+        // 写线程和flush()都会消费环形缓冲，drain_mutex保证单消费者，同时保护文件
+        std::mutex drain_mutex;
+        FILE *file = nullptr;
+        std::string service_name;
+        std::string out;
+
+        std::mutex stop_mutex;
+        std::condition_variable stop_cv;
+        bool stop = false;
+        std::thread writer;
+
+        // 一次写出一行span数组，返回写出的span数
+        size_t drain()
+        {
+            std::lock_guard<std::mutex> drain_lock(drain_mutex);
+            int64_t wall_offset_us = wall_time_us() - now_us();
+            size_t count = 0;
+            int64_t dropped = 0;
+            out.clear();
+            rings.for_each([&](SpanRing &ring)
+                           {
+                               count += ring.consume([&](Span &span)
+                                                     {
+                                                         out.push_back(out.empty() ? '[' : ',');
+                                                         append_span(out, span, service_name, wall_offset_us); });
+                               dropped += ring.take_dropped(); });
+
+            if (file && !out.empty())
+            {
+                out.append("]\n");
+                fwrite(out.data(), 1, out.size(), file);
+                fflush(file);
+            }
+            if (dropped > 0)
+            {
+                DRPC_WARN("tracer: {} spans dropped", dropped);
+            }
+            return count;
+        }
+
+        void run(int interval_ms)
+        {
+            std::unique_lock<std::mutex> lock(stop_mutex);
+            while (!stop_cv.wait_for(lock, std::chrono::milliseconds(interval_ms), [this]()
+                                     { return stop; }))
+            {
+                lock.unlock();
+                drain();
+                lock.lock();
+            }
+        }
+    };
+
+    Tracer::Tracer() : impl_(new Impl) {}
+
+    Tracer::~Tracer()
+    {
+        stop();
+        closed.store(true, std::memory_order_relaxed);
+        // impl_有意泄漏：静态析构期间其它线程仍可能记录span或调用flush()
+    }
+
+    Tracer &Tracer::instance()
+    {
+        static Tracer tracer;
+        return tracer;
+    }
+
+    bool Tracer::start(const TracingOptions &options)
+    {
+        double rate = std::clamp(options.sample_rate_, 0.0, 1.0);
+        uint64_t threshold = rate >= 1.0 ? UINT64_MAX : static_cast<uint64_t>(rate * 18446744073709551616.0);
+        {
+            std::lock_guard<std::mutex> lock(impl_->drain_mutex);
+            if (!impl_->file)
+            {
+                impl_->file = fopen(options.path_.c_str(), "a");
+                if (!impl_->file)
+                {
+                    return false;
+                }
+                impl_->service_name = options.service_name_;
+                impl_->stop = false;
+                int interval_ms = std::max(options.flush_interval_ms_, 1);
+                impl_->writer = std::thread([this, interval_ms]()
+                                            { impl_->run(interval_ms); });
+            }
+        }
+        threshold_.store(threshold, std::memory_order_relaxed);
+        enabled_.store(true, std::memory_order_relaxed);
+        return true;
+    }
+
+    void Tracer::stop()
+    {
+        threshold_.store(0, std::memory_order_relaxed);
+        enabled_.store(false, std::memory_order_relaxed);
+        if (!impl_->writer.joinable())
+        {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(impl_->stop_mutex);
+            impl_->stop = true;
+        }
+        impl_->stop_cv.notify_one();
+        impl_->writer.join();
+        impl_->drain();
+
+        std::lock_guard<std::mutex> lock(impl_->drain_mutex);
+        fclose(impl_->file);
+        impl_->file = nullptr;
+    }
+
+    void Tracer::flush()
+    {
+        impl_->drain();
+    }
+
+    void Tracer::record(const Span &span)
+    {
+        if (!enabled())
+        {
+            return;
+        }
+        SpanRing *ring = thread_ring();
+        if (!ring)
+        {
+            return;
+        }
+        if (Span *slot = ring->reserve())
+        {
+            *slot = span;
+            ring->commit();
+        }
+    }
+
+    SpanRing *Tracer::thread_ring()
+    {
+        thread_local RingRegistry<SpanRing>::Holder holder;
+        if (closed.load(std::memory_order_relaxed))
+        {
+            return nullptr;
+        }
+        if (SpanRing *ring = holder.get())
+        {
+            return ring;
+        }
+        return instance().impl_->rings.attach(holder);
+    }
+
+    uint64_t Tracer::random_id()
+    {
+        // splitmix64，每个线程独立的状态
+        thread_local uint64_t state = (static_cast<uint64_t>(std::random_device{}()) << 32) ^ std::random_device{}() ^
+                                      static_cast<uint64_t>(now_us());
+        uint64_t z;
+        do
+        {
+            z = (state += 0x9e3779b97f4a7c15ULL);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            z ^= z >> 31;
+        } while (z == 0);
+        return z;
+    }
+}
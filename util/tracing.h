@@ -0,0 +1,134 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <cstdint>
+#include <string_view>
+
+#include "spsc_ring.h"
+
+namespace dRPC::util
+{
+    // 请求所属的trace和当前span，trace_id为0表示未采样。采样在发起trace的客户端决定，
+    // 只有采样的请求在帧头中携带trace信息，下游沿用上游的决定
+    struct TraceContext
+    {
+        uint64_t trace_id = 0;
+        uint64_t span_id = 0;
+
+        bool sampled() const { return trace_id != 0; }
+    };
+
+    enum class SpanKind : uint8_t
+    {
+        LOCAL,  // 进程内的阶段
+        CLIENT,
+        SERVER,
+    };
+
+    // 一个已结束的span，时间为单调时钟微秒，写出时换算为墙上时钟
+    struct Span
+    {
+        uint64_t trace_id = 0;
+        uint64_t id = 0;
+        uint64_t parent_id = 0; // 0表示根span
+        int64_t start_us = 0;
+        int64_t end_us = 0;
+        int32_t error_code = 0;
+        SpanKind kind = SpanKind::LOCAL;
+        uint16_t peer_port = 0;
+        char peer_ip[16] = {};
+        char name[96] = {};
+
+        void set_name(std::string_view value);
+        void set_peer(std::string_view ip, int port);
+    };
+
+    // 每个记录span的线程一个
+    using SpanRing = SpscRing<Span, 1024>;
+
+    struct TracingOptions
+    {
+        double sample_rate_ = 0.01;            // 新trace的采样比例，0到1
+        std::string path_ = "drpc_trace.json"; // 每行一个Zipkin v2格式的span数组
+        std::string service_name_ = "drpc";    // span的localEndpoint.serviceName
+        int flush_interval_ms_ = 100;
+    };
+
+    // 采样的span写入各线程的环形缓冲，由后台线程批量写入文件。
+    // 未启动时不采样新trace，也不记录span，但仍向下游传递上游的trace信息
+    class Tracer
+    {
+    public:
+        static Tracer &instance();
+
+        // 打开文件并启动写线程，失败返回false。重复调用只更新采样比例
+        bool start(const TracingOptions &options);
+        // 写出剩余span并关闭文件
+        void stop();
+        // 等待此前记录的span全部写出
+        void flush();
+
+        bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+        // 头部采样：是否为新trace采样，未启动或比例为0时只有一次判断
+        bool sample()
+        {
+            uint64_t threshold = threshold_.load(std::memory_order_relaxed);
+            return threshold != 0 && random_id() <= threshold;
+        }
+
+        void record(const Span &span);
+
+        // 非0的随机id
+        static uint64_t random_id();
+
+        // 当前线程正在执行的handler所属的trace，服务端在调用handler期间设置，
+        // 期间发起的下游调用以其为父span
+        static TraceContext &current()
+        {
+            thread_local TraceContext context;
+            return context;
+        }
+
+        ~Tracer();
+
+    private:
+        Tracer();
+        static SpanRing *thread_ring();
+
+        std::atomic<bool> enabled_{false};
+        std::atomic<uint64_t> threshold_{0};
+        struct Impl;
+        Impl *impl_;
+    };
+
+    // 在作用域内设置Tracer::current()，未采样时不做任何事
+    class ScopedTrace
+    {
+    public:
+        explicit ScopedTrace(const TraceContext &context)
+        {
+            if (context.sampled())
+            {
+                saved_ = Tracer::current();
+                Tracer::current() = context;
+                active_ = true;
+            }
+        }
+        ~ScopedTrace()
+        {
+            if (active_)
+            {
+                Tracer::current() = saved_;
+            }
+        }
+
+        ScopedTrace(const ScopedTrace &) = delete;
+        ScopedTrace &operator=(const ScopedTrace &) = delete;
+
+    private:
+        TraceContext saved_;
+        bool active_ = false;
+    };
+}
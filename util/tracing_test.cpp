@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+
+#include "tracing.h"
+
+using dRPC::util::Span;
+using dRPC::util::SpanKind;
+using dRPC::util::ScopedTrace;
+using dRPC::util::TraceContext;
+using dRPC::util::Tracer;
+using dRPC::util::TracingOptions;
+
+namespace
+{
+    class TracingTest : public ::testing::Test
+    {
+    protected:
+        void SetUp() override
+        {
+            path_ = "/tmp/drpc_tracing_test_" + std::to_string(getpid()) + ".json";
+            unlink(path_.c_str());
+        }
+
+        void TearDown() override
+        {
+            Tracer::instance().stop();
+            unlink(path_.c_str());
+        }
+
+        bool start(double sample_rate)
+        {
+            TracingOptions options;
+            options.sample_rate_ = sample_rate;
+            options.path_ = path_;
+            options.service_name_ = "test";
+            return Tracer::instance().start(options);
+        }
+
+        std::string content()
+        {
+            std::ifstream file(path_);
+            std::stringstream ss;
+            ss << file.rdbuf();
+            return ss.str();
+        }
+
+        std::string path_;
+    };
+}
+
+TEST_F(TracingTest, SampleRate)
+{
+    EXPECT_FALSE(Tracer::instance().sample());
+
+    ASSERT_TRUE(start(0));
+    EXPECT_FALSE(Tracer::instance().sample());
+
+    ASSERT_TRUE(start(1));
+    for (int i = 0; i < 1000; ++i)
+    {
+        EXPECT_TRUE(Tracer::instance().sample());
+    }
+
+    ASSERT_TRUE(start(0.25));
+    int sampled = 0;
+    for (int i = 0; i < 100000; ++i)
+    {
+        sampled += Tracer::instance().sample();
+    }
+    EXPECT_NEAR(sampled, 25000, 1500);
+}
+
+TEST_F(TracingTest, WritesZipkinJson)
+{
+    ASSERT_TRUE(start(1));
+
+    Span span;
+    span.trace_id = 0x1234;
+    span.id = 0xabcd;
+    span.parent_id = 0x42;
+    span.start_us = 100;
+    span.end_us = 350;
+    span.error_code = 5;
+    span.kind = SpanKind::SERVER;
+    span.set_name("echo.EchoService.\"Echo\"");
+    span.set_peer("127.0.0.1", 8080);
+    Tracer::instance().record(span);
+
+    // 其它线程记录的span在线程退出后仍会写出
+    std::thread([]()
+                {
+                    Span child;
+                    child.trace_id = 0x1234;
+                    child.id = 0xbeef;
+                    child.parent_id = 0xabcd;
+                    child.set_name("handler");
+                    Tracer::instance().record(child); })
+        .join();
+
+    Tracer::instance().flush();
+    std::string json = content();
+    EXPECT_EQ(json.front(), '[');
+    EXPECT_NE(json.find("\"traceId\":\"0000000000001234\",\"id\":\"000000000000abcd\",\"parentId\":\"0000000000000042\""), std::string::npos);
+    EXPECT_NE(json.find("\"name\":\"echo.EchoService.\\\"Echo\\\"\",\"kind\":\"SERVER\""), std::string::npos);
+    EXPECT_NE(json.find(",\"duration\":250,"), std::string::npos);
+    EXPECT_NE(json.find("\"localEndpoint\":{\"serviceName\":\"test\"}"), std::string::npos);
+    EXPECT_NE(json.find("\"remoteEndpoint\":{\"ipv4\":\"127.0.0.1\",\"port\":8080}"), std::string::npos);
+    EXPECT_NE(json.find("\"tags\":{\"error\":\"5\"}"), std::string::npos);
+    EXPECT_NE(json.find("\"id\":\"000000000000beef\",\"parentId\":\"000000000000abcd\",\"name\":\"handler\",\"timestamp\""), std::string::npos);
+    EXPECT_EQ(json.substr(json.size() - 2), "]\n");
+}
+
+TEST_F(TracingTest, DisabledTracerRecordsNothing)
+{
+    Span span;
+    span.trace_id = 1;
+    span.id = 1;
+    Tracer::instance().record(span);
+
+    ASSERT_TRUE(start(1));
+    Tracer::instance().flush();
+    EXPECT_EQ(content(), "");
+}
+
+TEST_F(TracingTest, ScopedTrace)
+{
+    EXPECT_FALSE(Tracer::current().sampled());
+    {
+        ScopedTrace outer(TraceContext{1, 2});
+        EXPECT_EQ(Tracer::current().span_id, 2u);
+        {
+            ScopedTrace inner(TraceContext{1, 3});
+            EXPECT_EQ(Tracer::current().span_id, 3u);
+            // 未采样的上下文不改变当前trace
+            ScopedTrace unsampled(TraceContext{});
+            EXPECT_EQ(Tracer::current().span_id, 3u);
+        }
+        EXPECT_EQ(Tracer::current().span_id, 2u);
+    }
+    EXPECT_FALSE(Tracer::current().sampled());
+}